@@ -0,0 +1,402 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Runs the frames of a corpus file through the generated qmi_parse_*
+ * functions and a set of canned requests through qmi_set_*, and prints
+ * the time per message together with the number of bytes each one reads,
+ * writes and allocates from the arena.
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+
+#include <libubox/utils.h>
+
+#include "qmi-message.h"
+#include "utils.h"
+
+typedef int (*bench_parse_cb)(struct qmi_msg *msg, void *res, struct qmi_arena *arena);
+typedef int (*bench_set_cb)(struct qmi_msg *msg, const void *req);
+
+struct bench_parser {
+	const char *name;
+	unsigned int res_size;
+	bench_parse_cb parse;
+};
+
+struct bench_request {
+	const char *name;
+	unsigned int req_size;
+	const void *req;
+	bench_set_cb set;
+};
+
+struct bench_result {
+	unsigned int in;
+	unsigned int out;
+	unsigned int arena;
+	double ns;
+};
+
+#define __bench_parser(_name) \
+	static int bench_parse_##_name(struct qmi_msg *msg, void *res, struct qmi_arena *arena) \
+	{ \
+		return qmi_parse_##_name##_arena(msg, res, arena); \
+	}
+
+#define __bench_request(_name) \
+	static int bench_set_##_name(struct qmi_msg *msg, const void *req) \
+	{ \
+		return qmi_set_##_name(msg, (void *) req); \
+	}
+
+#define bench_parsers \
+	__bench_parser(nas_get_cell_location_info_response) \
+	__bench_parser(nas_get_signal_info_response) \
+	__bench_parser(nas_get_serving_system_response) \
+	__bench_parser(nas_get_system_info_response) \
+	__bench_parser(wds_get_current_settings_response) \
+	__bench_parser(wds_get_packet_service_status_response) \
+	__bench_parser(uim_get_card_status_response) \
+	__bench_parser(wms_raw_read_response) \
+	__bench_parser(wms_list_messages_response) \
+	__bench_parser(dms_get_ids_response)
+
+#define bench_requests \
+	__bench_request(nas_set_system_selection_preference_request) \
+	__bench_request(wds_start_network_request) \
+	__bench_request(uim_read_transparent_request) \
+	__bench_request(wms_raw_read_request)
+
+bench_parsers
+bench_requests
+
+#undef __bench_parser
+#define __bench_parser(_name) \
+	{ #_name, sizeof(struct qmi_##_name), bench_parse_##_name },
+
+static const struct bench_parser parsers[] = {
+	bench_parsers
+};
+
+static int8_t acquisition_order[] = {
+	QMI_NAS_RADIO_INTERFACE_5GNR,
+	QMI_NAS_RADIO_INTERFACE_LTE,
+	QMI_NAS_RADIO_INTERFACE_UMTS,
+	QMI_NAS_RADIO_INTERFACE_GSM,
+};
+
+static const struct qmi_nas_set_system_selection_preference_request nas_sspref = {
+	QMI_INIT(mode_preference, QMI_NAS_RAT_MODE_PREFERENCE_LTE | QMI_NAS_RAT_MODE_PREFERENCE_5GNR),
+	QMI_INIT(roaming_preference, QMI_NAS_ROAMING_PREFERENCE_ANY),
+	QMI_INIT(lte_band_preference, 0x000000000a0800c5ULL),
+	QMI_INIT_SEQUENCE(network_selection_preference,
+		.mode = QMI_NAS_NETWORK_SELECTION_PREFERENCE_MANUAL,
+		.mcc = 262,
+		.mnc = 1,
+	),
+	QMI_INIT(change_duration, QMI_NAS_CHANGE_DURATION_PERMANENT),
+	QMI_INIT_STATIC_ARRAY(acquisition_order_preference, acquisition_order),
+	QMI_INIT_SEQUENCE(extended_lte_band_preference,
+		.mask_low = 0x000000000a0800c5ULL,
+		.mask_mid_low = 0x0000000000000080ULL,
+	),
+};
+
+static const struct qmi_wds_start_network_request wds_start = {
+	QMI_INIT_PTR(apn, "internet.telekom"),
+	QMI_INIT(authentication_preference, QMI_WDS_AUTHENTICATION_PAP | QMI_WDS_AUTHENTICATION_CHAP),
+	QMI_INIT_PTR(username, "telekom"),
+	QMI_INIT_PTR(password, "tm"),
+	QMI_INIT(ip_family_preference, QMI_WDS_IP_FAMILY_IPV6),
+	QMI_INIT(profile_index_3gpp, 1),
+	QMI_INIT(enable_autoconnect, false),
+};
+
+static uint8_t usim_aid[] = {
+	0xa0, 0x00, 0x00, 0x00, 0x87, 0x10, 0x02, 0xff,
+	0x49, 0xff, 0x05, 0x89, 0xff, 0xff, 0xff, 0xff,
+};
+static uint8_t usim_path[] = { 0x00, 0x3f, 0xff, 0x7f };
+
+static const struct qmi_uim_read_transparent_request uim_read = {
+	QMI_INIT_SEQUENCE(session,
+		.session_type = QMI_UIM_SESSION_TYPE_PRIMARY_GW_PROVISIONING,
+		.application_identifier_n = ARRAY_SIZE(usim_aid),
+		.application_identifier = usim_aid,
+	),
+	QMI_INIT_SEQUENCE(file,
+		.file_id = 0x6f07,
+		.file_path_n = ARRAY_SIZE(usim_path),
+		.file_path = usim_path,
+	),
+	QMI_INIT_SEQUENCE(read_information,
+		.offset = 0,
+		.length = 0,
+	),
+};
+
+static const struct qmi_wms_raw_read_request wms_read = {
+	QMI_INIT_SEQUENCE(message_memory_storage_id,
+		.storage_type = QMI_WMS_STORAGE_TYPE_UIM,
+		.memory_index = 3,
+	),
+	QMI_INIT(message_mode, QMI_WMS_MESSAGE_MODE_GSM_WCDMA),
+};
+
+#undef __bench_request
+#define __bench_request(_name, _req) \
+	{ #_name, sizeof(_req), &_req, bench_set_##_name },
+
+static const struct bench_request requests[] = {
+	__bench_request(nas_set_system_selection_preference_request, nas_sspref)
+	__bench_request(wds_start_network_request, wds_start)
+	__bench_request(uim_read_transparent_request, uim_read)
+	__bench_request(wms_raw_read_request, wms_read)
+};
+
+static union {
+	char buf[QMI_BUFFER_LEN];
+	struct qmi_msg msg;
+} msgbuf;
+
+static union {
+	char buf[QMI_BUFFER_LEN];
+	uint64_t align;
+} resbuf;
+
+static QMI_ARENA_DECLARE(arena, QMI_BUFFER_LEN);
+
+static int iterations = 100000;
+
+static double bench_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static const struct bench_parser *bench_find_parser(const char *name)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(parsers); i++)
+		if (!strcmp(parsers[i].name, name))
+			return &parsers[i];
+
+	return NULL;
+}
+
+static int bench_hex_val(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+
+	c = tolower(c);
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+
+	return -1;
+}
+
+static int bench_parse_hex(const char *str, char *buf, int len)
+{
+	int n = 0;
+
+	while (*str) {
+		int hi, lo;
+
+		if (isspace(*str)) {
+			str++;
+			continue;
+		}
+
+		hi = bench_hex_val(str[0]);
+		lo = bench_hex_val(str[1]);
+		if (n >= len || hi < 0 || lo < 0)
+			return -1;
+
+		buf[n++] = (hi << 4) | lo;
+		str += 2;
+	}
+
+	return n;
+}
+
+static void bench_print(const char *type, const char *name, struct bench_result *res)
+{
+	printf("%-6s %-50s %6u %6u %6u %10.1f\n",
+	       type, name, res->in, res->out, res->arena, res->ns);
+}
+
+static int bench_frame(const char *name, const char *hex)
+{
+	const struct bench_parser *p;
+	struct bench_result res = {};
+	struct qmi_msg *msg = &msgbuf.msg;
+	double start;
+	int len, ret, i;
+
+	p = bench_find_parser(name);
+	if (!p) {
+		fprintf(stderr, "No parser for '%s'\n", name);
+		return -1;
+	}
+
+	len = bench_parse_hex(hex, msgbuf.buf, sizeof(msgbuf.buf));
+	if (len < (int) sizeof(msg->qmux) + 1 || len != le16_to_cpu(msg->qmux.len) + 1) {
+		fprintf(stderr, "Invalid frame for '%s'\n", name);
+		return -1;
+	}
+
+	qmi_arena_reset(&arena);
+	ret = p->parse(msg, resbuf.buf, &arena);
+	if (ret) {
+		fprintf(stderr, "Failed to parse '%s': %s\n", name, qmi_get_error_str(ret));
+		return -1;
+	}
+
+	res.in = len;
+	res.out = p->res_size;
+	res.arena = arena.ofs;
+
+	start = bench_time();
+	for (i = 0; i < iterations; i++) {
+		qmi_arena_reset(&arena);
+		memset(resbuf.buf, 0, p->res_size);
+		p->parse(msg, resbuf.buf, &arena);
+	}
+	res.ns = (bench_time() - start) / iterations;
+
+	bench_print("parse", name, &res);
+	return 0;
+}
+
+static int bench_request(const struct bench_request *r)
+{
+	struct bench_result res = {};
+	struct qmi_msg *msg = &msgbuf.msg;
+	double start;
+	int ret, i;
+
+	ret = r->set(msg, r->req);
+	if (ret) {
+		fprintf(stderr, "Failed to encode '%s': %s\n", r->name, qmi_get_error_str(ret));
+		return -1;
+	}
+
+	res.in = r->req_size;
+	res.out = qmi_complete_request_message(msg);
+
+	start = bench_time();
+	for (i = 0; i < iterations; i++)
+		r->set(msg, r->req);
+	res.ns = (bench_time() - start) / iterations;
+
+	bench_print("set", r->name, &res);
+	return 0;
+}
+
+static int bench_corpus(const char *file)
+{
+	char *line = NULL;
+	size_t line_len = 0;
+	int ret = 0;
+	FILE *f;
+
+	f = fopen(file, "r");
+	if (!f) {
+		fprintf(stderr, "Failed to open corpus %s\n", file);
+		return -1;
+	}
+
+	while (getline(&line, &line_len, f) > 0) {
+		char *name, *hex;
+
+		name = strtok(line, " \t\n");
+		if (!name || *name == '#')
+			continue;
+
+		hex = strtok(NULL, "\n");
+		if (!hex || bench_frame(name, hex))
+			ret = -1;
+	}
+
+	free(line);
+	fclose(f);
+
+	return ret;
+}
+
+static int usage(const char *progname)
+{
+	fprintf(stderr, "Usage: %s [options] [<corpus>]\n"
+		"Options:\n"
+		"  -n <count>:                       Number of iterations per message (default: %d)\n"
+		"  -p:                               Only run the parsers\n"
+		"\n"
+		"Columns: bytes read, bytes written, arena bytes, ns per message\n"
+		"\n", progname, iterations);
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	const char *corpus = QMI_BENCH_CORPUS;
+	bool parse_only = false;
+	int ret = 0;
+	int ch, i;
+
+	while ((ch = getopt(argc, argv, "n:p")) != -1) {
+		switch (ch) {
+		case 'n':
+			iterations = atoi(optarg);
+			if (iterations <= 0)
+				return usage(argv[0]);
+			break;
+		case 'p':
+			parse_only = true;
+			break;
+		default:
+			return usage(argv[0]);
+		}
+	}
+
+	if (optind < argc)
+		corpus = argv[optind];
+
+	printf("%-6s %-50s %6s %6s %6s %10s\n", "", "message", "in", "out", "arena", "ns/msg");
+
+	if (bench_corpus(corpus))
+		ret = 1;
+
+	for (i = 0; !parse_only && i < ARRAY_SIZE(requests); i++)
+		if (bench_request(&requests[i]))
+			ret = 1;
+
+	return ret;
+}
@@ -0,0 +1,366 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#include <alloca.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libubox/uloop.h>
+#include <libubox/utils.h>
+
+#include "capture.h"
+
+#define PCAPNG_SHB		0x0a0d0d0a
+#define PCAPNG_IDB		0x00000001
+#define PCAPNG_EPB		0x00000006
+#define PCAPNG_BYTE_ORDER	0x1a2b3c4d
+
+#define PCAPNG_OPT_END		0
+#define PCAPNG_OPT_IF_NAME	2
+#define PCAPNG_OPT_EPB_FLAGS	2
+
+#define PCAPNG_EPB_INBOUND	1
+#define PCAPNG_EPB_OUTBOUND	2
+
+#define CAPTURE_BUF_LEN		(64 * 1024)
+#define CAPTURE_FLUSH_MS	1000
+#define CAPTURE_MAX_IF		16
+
+struct pcapng_block {
+	uint32_t type;
+	uint32_t len;
+};
+
+struct pcapng_shb {
+	struct pcapng_block hdr;
+	uint32_t byte_order;
+	uint16_t major;
+	uint16_t minor;
+	int64_t section_len;
+	uint32_t len;
+} __packed;
+
+struct pcapng_epb {
+	struct pcapng_block hdr;
+	uint32_t if_id;
+	uint32_t ts_high;
+	uint32_t ts_low;
+	uint32_t cap_len;
+	uint32_t len;
+};
+
+/* epb_flags option, end of options and the trailing block length */
+struct pcapng_epb_tail {
+	uint16_t flags_code;
+	uint16_t flags_len;
+	uint32_t flags;
+	uint32_t opt_end;
+	uint32_t len;
+};
+
+struct capture {
+	int fd;
+	char *path;
+	unsigned int file_size;
+	unsigned int n_files;
+	unsigned int file_idx;
+	/* bytes in the current file, including the buffered ones */
+	unsigned int written;
+
+	char *if_name[CAPTURE_MAX_IF];
+	int n_if;
+
+	struct uloop_timeout flush;
+	unsigned int len;
+	uint8_t buf[CAPTURE_BUF_LEN];
+};
+
+static struct capture *cap;
+
+static const uint8_t pad[4];
+
+static void capture_write(const struct iovec *iov, int iovcnt)
+{
+	ssize_t ret;
+
+	do {
+		ret = writev(cap->fd, iov, iovcnt);
+	} while (ret < 0 && errno == EINTR);
+
+	if (ret < 0)
+		fprintf(stderr, "Capture write failed: %s\n", strerror(errno));
+}
+
+void qmi_capture_flush(void)
+{
+	struct iovec iov;
+
+	if (!cap)
+		return;
+
+	uloop_timeout_cancel(&cap->flush);
+	if (!cap->len)
+		return;
+
+	iov.iov_base = cap->buf;
+	iov.iov_len = cap->len;
+	capture_write(&iov, 1);
+	cap->len = 0;
+}
+
+static void capture_flush_cb(struct uloop_timeout *t)
+{
+	qmi_capture_flush();
+}
+
+/* blocks are queued whole: flush first if the buffer cannot take them */
+static void *capture_reserve(unsigned int len)
+{
+	void *ret;
+
+	if (cap->len + len > sizeof(cap->buf))
+		qmi_capture_flush();
+
+	if (len > sizeof(cap->buf))
+		return NULL;
+
+	if (!cap->len)
+		uloop_timeout_set(&cap->flush, CAPTURE_FLUSH_MS);
+
+	ret = &cap->buf[cap->len];
+	cap->len += len;
+	cap->written += len;
+	return ret;
+}
+
+static void capture_add_shb(void)
+{
+	struct pcapng_shb *shb = capture_reserve(sizeof(*shb));
+
+	shb->hdr.type = PCAPNG_SHB;
+	shb->hdr.len = sizeof(*shb);
+	shb->byte_order = PCAPNG_BYTE_ORDER;
+	shb->major = 1;
+	shb->minor = 0;
+	shb->section_len = -1;
+	shb->len = sizeof(*shb);
+}
+
+static void capture_add_idb(const char *name)
+{
+	unsigned int name_len = strlen(name);
+	unsigned int opt_len = 4 + ((name_len + 3) & ~3);
+	unsigned int len = sizeof(struct pcapng_block) + 8 + opt_len + 4 + 4;
+	uint8_t *data = capture_reserve(len);
+	uint32_t *p = (uint32_t *) data;
+
+	memset(data, 0, len);
+	p[0] = PCAPNG_IDB;
+	p[1] = len;
+	*(uint16_t *) &p[2] = QMI_CAPTURE_LINKTYPE;
+	*((uint16_t *) &p[2] + 1) = 0;	/* reserved */
+	p[3] = 0;			/* no snaplen */
+	p += 4;
+
+	*(uint16_t *) p = PCAPNG_OPT_IF_NAME;
+	*((uint16_t *) p + 1) = name_len;
+	memcpy(p + 1, name, name_len);
+	p += opt_len / 4;
+
+	*p++ = PCAPNG_OPT_END;
+	*p = len;
+}
+
+static int capture_open_file(void)
+{
+	char *name = cap->path;
+	int i;
+
+	if (cap->file_size) {
+		name = alloca(strlen(cap->path) + 12);
+		sprintf(name, "%s.%u", cap->path, cap->file_idx);
+	}
+
+	cap->fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (cap->fd < 0) {
+		fprintf(stderr, "Failed to open capture file %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+
+	cap->written = 0;
+	capture_add_shb();
+	for (i = 0; i < cap->n_if; i++)
+		capture_add_idb(cap->if_name[i]);
+
+	return 0;
+}
+
+static int capture_next_file(void)
+{
+	qmi_capture_flush();
+	close(cap->fd);
+
+	cap->file_idx++;
+	if (cap->n_files && cap->file_idx >= cap->n_files)
+		cap->file_idx = 0;
+
+	return capture_open_file();
+}
+
+static int capture_if_id(const char *name)
+{
+	int i;
+
+	for (i = 0; i < cap->n_if; i++)
+		if (!strcmp(cap->if_name[i], name))
+			return i;
+
+	if (cap->n_if == CAPTURE_MAX_IF)
+		return -1;
+
+	cap->if_name[i] = strdup(name);
+	if (!cap->if_name[i])
+		return -1;
+
+	cap->n_if++;
+	capture_add_idb(name);
+	return i;
+}
+
+void qmi_capture_frame(const char *name, bool tx, const struct iovec *iov, int iovcnt)
+{
+	struct pcapng_epb epb_buf, *epb = &epb_buf;
+	struct pcapng_epb_tail tail_buf, *tail = &tail_buf;
+	struct iovec vec[iovcnt + 3];
+	struct timespec ts;
+	unsigned int data_len = 0, pad_len, block_len;
+	uint64_t usec;
+	uint8_t *p;
+	int if_id, i;
+
+	if (!cap)
+		return;
+
+	for (i = 0; i < iovcnt; i++)
+		data_len += iov[i].iov_len;
+
+	pad_len = -data_len & 3;
+	block_len = sizeof(*epb) + data_len + pad_len + sizeof(*tail);
+
+	if (cap->file_size && cap->written + block_len > cap->file_size &&
+	    cap->written > sizeof(struct pcapng_shb) && capture_next_file()) {
+		qmi_capture_close();
+		return;
+	}
+
+	if_id = capture_if_id(name);
+	if (if_id < 0)
+		return;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	usec = (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+
+	/* NULL if larger than the whole buffer, it is written out directly then */
+	p = capture_reserve(block_len);
+	if (p) {
+		epb = (struct pcapng_epb *) p;
+		p += sizeof(*epb);
+		for (i = 0; i < iovcnt; i++) {
+			memcpy(p, iov[i].iov_base, iov[i].iov_len);
+			p += iov[i].iov_len;
+		}
+		memset(p, 0, pad_len);
+		tail = (struct pcapng_epb_tail *) (p + pad_len);
+	}
+
+	epb->hdr.type = PCAPNG_EPB;
+	epb->hdr.len = block_len;
+	epb->if_id = if_id;
+	epb->ts_high = usec >> 32;
+	epb->ts_low = usec;
+	epb->cap_len = data_len;
+	epb->len = data_len;
+
+	tail->flags_code = PCAPNG_OPT_EPB_FLAGS;
+	tail->flags_len = sizeof(tail->flags);
+	tail->flags = tx ? PCAPNG_EPB_OUTBOUND : PCAPNG_EPB_INBOUND;
+	tail->opt_end = PCAPNG_OPT_END;
+	tail->len = block_len;
+
+	if (p)
+		return;
+
+	vec[0].iov_base = epb;
+	vec[0].iov_len = sizeof(*epb);
+	for (i = 0; i < iovcnt; i++)
+		vec[i + 1] = iov[i];
+	vec[i + 1].iov_base = (void *) pad;
+	vec[i + 1].iov_len = pad_len;
+	vec[i + 2].iov_base = tail;
+	vec[i + 2].iov_len = sizeof(*tail);
+	capture_write(vec, iovcnt + 3);
+	cap->written += block_len;
+}
+
+int qmi_capture_open(const char *path, unsigned int file_size, unsigned int n_files)
+{
+	qmi_capture_close();
+
+	cap = calloc(1, sizeof(*cap));
+	if (!cap)
+		return -1;
+
+	cap->path = strdup(path);
+	cap->file_size = file_size;
+	cap->n_files = n_files;
+	cap->flush.cb = capture_flush_cb;
+	if (!cap->path || capture_open_file()) {
+		free(cap->path);
+		free(cap);
+		cap = NULL;
+		return -1;
+	}
+
+	return 0;
+}
+
+void qmi_capture_close(void)
+{
+	int i;
+
+	if (!cap)
+		return;
+
+	qmi_capture_flush();
+	close(cap->fd);
+
+	for (i = 0; i < cap->n_if; i++)
+		free(cap->if_name[i]);
+	free(cap->path);
+	free(cap);
+	cap = NULL;
+}
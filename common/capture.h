@@ -0,0 +1,51 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __UQMI_CAPTURE_H
+#define __UQMI_CAPTURE_H
+
+#include <stdbool.h>
+#include <sys/uio.h>
+
+/*
+ * pcapng capture of all QMI traffic. Every frame is a QMUX message starting
+ * with the 0x01 marker (MBIM framing is stripped) stored with
+ * LINKTYPE_USER0. Each modem gets its own interface named after it, and
+ * the direction is recorded in the epb_flags option.
+ *
+ * Frames are collected in memory and written out when the buffer fills up
+ * or a second after the first pending frame (from the uloop), so capturing
+ * does not add a syscall per message.
+ *
+ * With file_size set, the capture is split into <path>.0, <path>.1, ...
+ * and moves on to the next file once one has grown past file_size bytes.
+ * With n_files set as well, the names wrap around after n_files, so only
+ * the most recent ones are kept.
+ */
+
+#define QMI_CAPTURE_LINKTYPE	147	/* LINKTYPE_USER0 */
+
+int qmi_capture_open(const char *path, unsigned int file_size, unsigned int n_files);
+void qmi_capture_close(void);
+void qmi_capture_flush(void);
+void qmi_capture_frame(const char *name, bool tx, const struct iovec *iov, int iovcnt);
+
+#endif
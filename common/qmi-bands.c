@@ -0,0 +1,92 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#include <libubox/utils.h>
+
+#include "qmi-enums-nas.h"
+#include "qmi-bands.h"
+#include <qmi-bands-table.c>
+
+static const struct {
+	const struct qmi_band *list;
+	unsigned int len;
+} qmi_band_tables[__QMI_BAND_RAT_MAX] = {
+	[QMI_BAND_RAT_LTE] = { qmi_bands_lte, ARRAY_SIZE(qmi_bands_lte) },
+	[QMI_BAND_RAT_UMTS] = { qmi_bands_umts, ARRAY_SIZE(qmi_bands_umts) },
+	[QMI_BAND_RAT_NR] = { qmi_bands_nr, ARRAY_SIZE(qmi_bands_nr) },
+};
+
+const struct qmi_band *qmi_band_find(enum qmi_band_rat rat, uint32_t channel)
+{
+	const struct qmi_band *list;
+	unsigned int lo = 0, hi;
+
+	if ((unsigned int) rat >= __QMI_BAND_RAT_MAX)
+		return NULL;
+
+	list = qmi_band_tables[rat].list;
+	hi = qmi_band_tables[rat].len;
+
+	/* the last range starting at or below the channel */
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+
+		if (list[mid].first <= channel)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (!lo || list[lo - 1].last < channel)
+		return NULL;
+
+	return &list[lo - 1];
+}
+
+uint32_t qmi_band_freq(const struct qmi_band *band, uint32_t channel)
+{
+	return band->freq + band->step * (channel - band->first);
+}
+
+const char *qmi_band_duplex_name(const struct qmi_band *band)
+{
+	static const char *names[] = {
+		[QMI_BAND_DUPLEX_FDD] = "FDD",
+		[QMI_BAND_DUPLEX_TDD] = "TDD",
+		[QMI_BAND_DUPLEX_SDL] = "SDL",
+	};
+
+	return names[band->duplex];
+}
+
+int qmi_band_rat_from_radio_interface(int radio_interface)
+{
+	switch (radio_interface) {
+	case QMI_NAS_RADIO_INTERFACE_LTE:
+		return QMI_BAND_RAT_LTE;
+	case QMI_NAS_RADIO_INTERFACE_UMTS:
+		return QMI_BAND_RAT_UMTS;
+	case QMI_NAS_RADIO_INTERFACE_5GNR:
+		return QMI_BAND_RAT_NR;
+	default:
+		return -1;
+	}
+}
@@ -0,0 +1,68 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __UQMI_BANDS_H
+#define __UQMI_BANDS_H
+
+#include <stdint.h>
+
+/*
+ * Operating band lookup for LTE EARFCNs, NR-ARFCNs and UMTS UARFCNs.
+ *
+ * The tables are generated from data/qmi-bands.txt by gen-band-table.pl:
+ * one per RAT, of disjoint downlink channel ranges sorted by their first
+ * channel, so a lookup is a binary search over a few dozen entries.
+ */
+
+enum qmi_band_rat {
+	QMI_BAND_RAT_LTE,
+	QMI_BAND_RAT_UMTS,
+	QMI_BAND_RAT_NR,
+	__QMI_BAND_RAT_MAX
+};
+
+enum qmi_band_duplex {
+	QMI_BAND_DUPLEX_FDD,
+	QMI_BAND_DUPLEX_TDD,
+	QMI_BAND_DUPLEX_SDL,
+};
+
+struct qmi_band {
+	uint32_t first;
+	uint32_t last;
+	/* downlink frequency of the first channel and channel spacing, in kHz */
+	uint32_t freq;
+	uint16_t step;
+	uint16_t band;
+	/* the frequency the band is usually named after, in MHz */
+	uint16_t mhz;
+	uint8_t duplex;
+};
+
+/* NULL if the channel isn't part of a known band */
+const struct qmi_band *qmi_band_find(enum qmi_band_rat rat, uint32_t channel);
+/* downlink frequency of a channel of the band, in kHz */
+uint32_t qmi_band_freq(const struct qmi_band *band, uint32_t channel);
+const char *qmi_band_duplex_name(const struct qmi_band *band);
+/* QmiNasRadioInterface to RAT, -1 if the tables don't cover it */
+int qmi_band_rat_from_radio_interface(int radio_interface);
+
+#endif
@@ -0,0 +1,513 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "qmi-codec.h"
+
+struct qmi_decoder {
+	const uint8_t *data;
+	unsigned int len;
+	unsigned int ofs;
+	struct qmi_arena *arena;
+};
+
+/*
+ * The set bits are the first member of every message struct. GCC fills
+ * bitfields from the least significant bit on little endian and from the
+ * most significant bit on big endian targets.
+ */
+static inline uint8_t set_mask(unsigned int bit)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	return 0x80 >> (bit % 8);
+#else
+	return 1 << (bit % 8);
+#endif
+}
+
+static inline void set_bit(void *data, unsigned int bit)
+{
+	((uint8_t *) data)[bit / 8] |= set_mask(bit);
+}
+
+static inline bool test_bit(const void *data, unsigned int bit)
+{
+	return ((const uint8_t *) data)[bit / 8] & set_mask(bit);
+}
+
+static uint64_t get_uint(const uint8_t *p, unsigned int size, bool be)
+{
+	union {
+		uint8_t u8;
+		uint16_t u16;
+		uint32_t u32;
+		uint64_t u64;
+	} v;
+
+	memcpy(&v, p, size);
+	switch (size) {
+	case 1:
+		return v.u8;
+	case 2:
+		return be ? be16_to_cpu(v.u16) : le16_to_cpu(v.u16);
+	case 4:
+		return be ? be32_to_cpu(v.u32) : le32_to_cpu(v.u32);
+	case 8:
+		return be ? be64_to_cpu(v.u64) : le64_to_cpu(v.u64);
+	}
+
+	/* guint-sized values */
+	v.u64 = 0;
+	memcpy(&v, p, size);
+	return le64_to_cpu(v.u64);
+}
+
+static void put_uint(uint8_t *p, unsigned int size, bool be, uint64_t val)
+{
+	union {
+		uint8_t u8;
+		uint16_t u16;
+		uint32_t u32;
+		uint64_t u64;
+	} v;
+
+	switch (size) {
+	case 1:
+		v.u8 = val;
+		break;
+	case 2:
+		v.u16 = be ? cpu_to_be16(val) : cpu_to_le16(val);
+		break;
+	case 4:
+		v.u32 = be ? cpu_to_be32(val) : cpu_to_le32(val);
+		break;
+	default:
+		v.u64 = be ? cpu_to_be64(val) : cpu_to_le64(val);
+		break;
+	}
+
+	memcpy(p, &v, size);
+}
+
+static uint64_t load_uint(const void *p, unsigned int size)
+{
+	switch (size) {
+	case 1:
+		return *(const uint8_t *) p;
+	case 2:
+		return *(const uint16_t *) p;
+	case 4:
+		return *(const uint32_t *) p;
+	default:
+		return *(const uint64_t *) p;
+	}
+}
+
+static void store_uint(void *p, unsigned int size, uint64_t val)
+{
+	switch (size) {
+	case 1:
+		*(uint8_t *) p = val;
+		break;
+	case 2:
+		*(uint16_t *) p = val;
+		break;
+	case 4:
+		*(uint32_t *) p = val;
+		break;
+	default:
+		*(uint64_t *) p = val;
+		break;
+	}
+}
+
+static const uint8_t *get_next(struct qmi_decoder *d, unsigned int size)
+{
+	const uint8_t *ret = &d->data[d->ofs];
+
+	if (size > d->len - d->ofs)
+		return NULL;
+
+	d->ofs += size;
+	return ret;
+}
+
+static int get_prefix(struct qmi_decoder *d, unsigned int size, unsigned int *val)
+{
+	const uint8_t *p = get_next(d, size);
+
+	if (!p)
+		return QMI_ERROR_INVALID_DATA;
+
+	*val = get_uint(p, size, false);
+	return 0;
+}
+
+static int decode_elem(struct qmi_decoder *d, const struct qmi_elem *e, uint8_t *base)
+{
+	void *field = base + e->offset;
+	const uint8_t *p;
+	unsigned int i, n;
+	uint64_t val;
+	uint8_t *elems;
+	int ret;
+
+	switch (e->type) {
+	case QMI_ELEM_INT:
+		p = get_next(d, e->size);
+		if (!p)
+			return QMI_ERROR_INVALID_DATA;
+
+		val = get_uint(p, e->size, e->flags & QMI_ELEM_F_BE);
+		if (e->flags & QMI_ELEM_F_BOOL)
+			*(bool *) field = !!val;
+		else
+			store_uint(field, e->size, val);
+		return 0;
+
+	case QMI_ELEM_FLOAT:
+		p = get_next(d, sizeof(float));
+		if (!p)
+			return QMI_ERROR_INVALID_DATA;
+
+		val = get_uint(p, sizeof(float), false);
+		memcpy(field, &(uint32_t) { val }, sizeof(float));
+		return 0;
+
+	case QMI_ELEM_SIZED:
+		p = get_next(d, e->size);
+		if (!p)
+			return QMI_ERROR_INVALID_DATA;
+
+		store_uint(field, e->size > 4 ? 8 : 4, get_uint(p, e->size, false));
+		return 0;
+
+	case QMI_ELEM_STRING:
+		if (e->fixed)
+			n = e->fixed;
+		else if (!e->size)
+			n = d->len - d->ofs;
+		else if (get_prefix(d, e->size, &n))
+			return QMI_ERROR_INVALID_DATA;
+
+		if (e->max && n > e->max)
+			n = e->max;
+
+		p = get_next(d, n);
+		if (!p)
+			return QMI_ERROR_INVALID_DATA;
+
+		*(char **) field = qmi_arena_strdup(d->arena, p, n);
+		if (!*(char **) field)
+			return QMI_ERROR_NO_MEMORY;
+		return 0;
+
+	case QMI_ELEM_ARRAY:
+		if (e->fixed) {
+			elems = field;
+			for (i = 0; i < e->fixed; i++) {
+				ret = decode_elem(d, e->sub, elems + i * e->elem_size);
+				if (ret)
+					return ret;
+			}
+			return 0;
+		}
+
+		if (get_prefix(d, e->size, &n))
+			return QMI_ERROR_INVALID_DATA;
+
+		elems = qmi_arena_alloc(d->arena, n * e->elem_size);
+		if (!elems)
+			return QMI_ERROR_NO_MEMORY;
+
+		*(void **) field = elems;
+		for (i = 0; i < n; i++) {
+			unsigned int *count = (unsigned int *) (base + e->n_offset);
+
+			ret = decode_elem(d, e->sub, elems + *count * e->elem_size);
+			if (ret)
+				return ret;
+
+			(*count)++;
+		}
+		return 0;
+
+	case QMI_ELEM_STRUCT:
+		for (i = 0; i < e->n_sub; i++) {
+			ret = decode_elem(d, &e->sub[i], base);
+			if (ret)
+				return ret;
+		}
+		return 0;
+	}
+
+	return QMI_ERROR_INVALID_DATA;
+}
+
+static int decode_error(const char *func, struct tlv *tlv, int ret)
+{
+	if (ret == QMI_ERROR_INVALID_DATA)
+		fprintf(stderr, "%s: Invalid TLV length in message, tlv=0x%02x, len=%d\n",
+		        func, tlv->type, le16_to_cpu(tlv->len));
+	else if (ret == QMI_ERROR_NO_MEMORY)
+		fprintf(stderr, "%s: Not enough memory to decode message, tlv=0x%02x\n",
+		        func, tlv->type);
+
+	return ret;
+}
+
+int qmi_codec_decode_tlv(const struct qmi_tlv_desc *desc, struct tlv *tlv, void *res, struct qmi_arena *arena)
+{
+	struct qmi_decoder d = {
+		.arena = arena,
+	};
+
+	if (!tlv)
+		return QMI_ERROR_NO_DATA;
+
+	d.data = tlv->data;
+	d.len = le16_to_cpu(tlv->len);
+
+	if (desc->set_bit >= 0)
+		set_bit(res, desc->set_bit);
+
+	return decode_error(__func__, tlv, decode_elem(&d, &desc->elem, res));
+}
+
+int qmi_codec_iter(const struct qmi_elem *array, struct tlv *tlv, unsigned int ofs, struct qmi_tlv_iter *iter)
+{
+	struct qmi_decoder d = {
+		.ofs = ofs,
+	};
+	unsigned int n;
+
+	iter->n = 0;
+	if (!tlv)
+		return QMI_ERROR_NO_DATA;
+
+	d.data = tlv->data;
+	d.len = le16_to_cpu(tlv->len);
+	if (ofs > d.len || get_prefix(&d, array->size, &n))
+		return decode_error(__func__, tlv, QMI_ERROR_INVALID_DATA);
+
+	iter->tlv = tlv;
+	iter->ofs = d.ofs;
+	iter->n = n;
+	return n;
+}
+
+int qmi_codec_iter_next(const struct qmi_elem *array, struct qmi_tlv_iter *iter, void *res, struct qmi_arena *arena)
+{
+	struct qmi_decoder d = {
+		.arena = arena,
+	};
+	int ret;
+
+	if (!iter->n)
+		return QMI_ERROR_NO_DATA;
+
+	d.data = iter->tlv->data;
+	d.len = le16_to_cpu(iter->tlv->len);
+	d.ofs = iter->ofs;
+
+	memset(res, 0, array->elem_size);
+	ret = decode_elem(&d, array->sub, res);
+	if (ret)
+		return decode_error(__func__, iter->tlv, ret);
+
+	iter->ofs = d.ofs;
+	iter->n--;
+	return 0;
+}
+
+static void *msg_tlv_buf(struct qmi_msg *msg, unsigned int *len)
+{
+	if (msg->qmux.service == QMI_SERVICE_CTL) {
+		*len = le16_to_cpu(msg->ctl.tlv_len);
+		return msg->ctl.tlv;
+	}
+
+	*len = le16_to_cpu(msg->svc.tlv_len);
+	return msg->svc.tlv;
+}
+
+static int find_tlv(const struct qmi_msg_desc *desc, uint8_t id)
+{
+	int i;
+
+	for (i = 0; i < desc->n_tlv; i++)
+		if (desc->tlv[i].id == id)
+			return i;
+
+	return -1;
+}
+
+int qmi_codec_view(struct qmi_msg *msg, const struct qmi_msg_desc *desc, struct tlv **view)
+{
+	unsigned int tlv_len;
+	void *tlv_buf = msg_tlv_buf(msg, &tlv_len);
+	struct tlv *tlv;
+	int i;
+
+	memset(view, 0, desc->n_tlv * sizeof(*view));
+	while ((tlv = tlv_get_next(&tlv_buf, &tlv_len)) != NULL) {
+		i = find_tlv(desc, tlv->type);
+		if (i >= 0 && !view[i])
+			view[i] = tlv;
+	}
+
+	return 0;
+}
+
+int qmi_codec_decode(struct qmi_msg *msg, const struct qmi_msg_desc *desc, void *res, struct qmi_arena *arena)
+{
+	struct tlv *view[desc->n_tlv];
+	int i, ret;
+
+	memset(res, 0, desc->size);
+	qmi_codec_view(msg, desc, view);
+
+	for (i = 0; i < desc->n_tlv; i++) {
+		ret = qmi_codec_decode_tlv(&desc->tlv[i], view[i], res, arena);
+		if (ret < 0 && ret != QMI_ERROR_NO_DATA)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int encode_elem(struct qmi_arena *arena, const struct qmi_elem *e, const uint8_t *base)
+{
+	const void *field = base + e->offset;
+	const uint8_t *elems;
+	const char *str;
+	unsigned int i, n;
+	uint64_t val;
+	uint8_t *p;
+	int ret;
+
+	switch (e->type) {
+	case QMI_ELEM_INT:
+		if (e->flags & QMI_ELEM_F_BOOL)
+			val = *(const bool *) field;
+		else
+			val = load_uint(field, e->size);
+
+		p = qmi_arena_alloc(arena, e->size);
+		if (!p)
+			return QMI_ERROR_NO_MEMORY;
+
+		put_uint(p, e->size, e->flags & QMI_ELEM_F_BE, val);
+		return 0;
+
+	case QMI_ELEM_STRING:
+		str = *(const char **) field;
+		if (!str)
+			str = "";
+
+		n = e->fixed ? e->fixed : strlen(str);
+		if (e->max && n > e->max)
+			n = e->max;
+
+		if (e->size) {
+			p = qmi_arena_alloc(arena, e->size);
+			if (!p)
+				return QMI_ERROR_NO_MEMORY;
+
+			put_uint(p, e->size, false, n);
+		}
+
+		p = qmi_arena_alloc(arena, n);
+		if (!p)
+			return QMI_ERROR_NO_MEMORY;
+
+		strncpy((char *) p, str, n);
+		return 0;
+
+	case QMI_ELEM_ARRAY:
+		if (e->fixed) {
+			n = e->fixed;
+			elems = field;
+		} else {
+			n = *(const unsigned int *) (base + e->n_offset);
+			elems = *(const void **) field;
+
+			p = qmi_arena_alloc(arena, e->size);
+			if (!p)
+				return QMI_ERROR_NO_MEMORY;
+
+			put_uint(p, e->size, false, n);
+		}
+
+		for (i = 0; i < n; i++) {
+			ret = encode_elem(arena, e->sub, elems + i * e->elem_size);
+			if (ret)
+				return ret;
+		}
+		return 0;
+
+	case QMI_ELEM_STRUCT:
+		for (i = 0; i < e->n_sub; i++) {
+			ret = encode_elem(arena, &e->sub[i], base);
+			if (ret)
+				return ret;
+		}
+		return 0;
+	}
+
+	/* floats and guint-sized values are never sent to the modem */
+	return QMI_ERROR_INVALID_DATA;
+}
+
+int qmi_codec_encode(struct qmi_msg *msg, const struct qmi_msg_desc *desc, const void *req)
+{
+	const struct qmi_tlv_desc *t;
+	struct qmi_arena arena;
+	int i, ret;
+
+	qmi_init_request_message(msg, desc->service);
+	if (desc->service == QMI_SERVICE_CTL)
+		msg->ctl.message = cpu_to_le16(desc->message);
+	else
+		msg->svc.message = cpu_to_le16(desc->message);
+
+	for (i = 0; i < desc->n_tlv; i++) {
+		t = &desc->tlv[i];
+
+		/* strings and variable arrays are sent if the pointer is set */
+		if (t->set_bit >= 0 ? !test_bit(req, t->set_bit) :
+		    !*(void * const *) ((const uint8_t *) req + t->elem.offset))
+			continue;
+
+		tlv_arena_init(msg, &arena);
+		ret = encode_elem(&arena, &t->elem, req);
+		if (ret == QMI_ERROR_NO_MEMORY)
+			fprintf(stderr, "%s: Not enough space in message buffer\n", __func__);
+		if (ret)
+			return ret;
+
+		tlv_arena_finish(msg, t->id, &arena);
+	}
+
+	return 0;
+}
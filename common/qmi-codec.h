@@ -0,0 +1,92 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __UQMI_CODEC_H
+#define __UQMI_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "qmi-message.h"
+
+/*
+ * Descriptor tables emitted by gen-code-table.pl (CODEC_TABLES=ON).
+ * Instead of open-coding every message, the generated qmi_set_* and
+ * qmi_parse_* functions hand a constant description of the message
+ * layout to the shared encoder/decoder below.
+ */
+
+enum {
+	QMI_ELEM_INT,		/* size: wire size of the integer */
+	QMI_ELEM_FLOAT,
+	QMI_ELEM_SIZED,		/* size: guint-size, stored in 32 or 64 bit */
+	QMI_ELEM_STRING,	/* size: length prefix, 0 = rest of the TLV */
+	QMI_ELEM_ARRAY,		/* size: count prefix, sub: the element */
+	QMI_ELEM_STRUCT,	/* sub: the members */
+};
+
+#define QMI_ELEM_F_BE		(1 << 0)
+#define QMI_ELEM_F_BOOL		(1 << 1)
+
+struct qmi_elem {
+	uint8_t type;
+	uint8_t size;
+	uint8_t flags;
+	uint8_t n_sub;
+
+	/* member offset from the enclosing struct or array element */
+	uint16_t offset;
+	/* fixed array length or string size */
+	uint16_t fixed;
+	/* string max-size */
+	uint16_t max;
+	/* offset of the _n counter of variable sized arrays */
+	uint16_t n_offset;
+	uint16_t elem_size;
+
+	const struct qmi_elem *sub;
+};
+
+struct qmi_tlv_desc {
+	uint8_t id;
+	/* bit in the set bitfield, -1 if the field has none */
+	int8_t set_bit;
+	struct qmi_elem elem;
+};
+
+struct qmi_msg_desc {
+	uint8_t service;
+	uint8_t n_tlv;
+	uint16_t message;
+	uint16_t size;
+	const struct qmi_tlv_desc *tlv;
+};
+
+int qmi_codec_encode(struct qmi_msg *msg, const struct qmi_msg_desc *desc, const void *req);
+int qmi_codec_decode(struct qmi_msg *msg, const struct qmi_msg_desc *desc, void *res, struct qmi_arena *arena);
+int qmi_codec_view(struct qmi_msg *msg, const struct qmi_msg_desc *desc, struct tlv **view);
+int qmi_codec_decode_tlv(const struct qmi_tlv_desc *desc, struct tlv *tlv, void *res, struct qmi_arena *arena);
+
+/* element by element decoding of a counted array starting at ofs in tlv */
+int qmi_codec_iter(const struct qmi_elem *array, struct tlv *tlv, unsigned int ofs, struct qmi_tlv_iter *iter);
+int qmi_codec_iter_next(const struct qmi_elem *array, struct qmi_tlv_iter *iter, void *res, struct qmi_arena *arena);
+
+#endif
@@ -24,42 +24,110 @@
 #include <stdlib.h>
 
 #include "qmi-message.h"
+#include "mbim.h"
 
-static uint8_t buf[QMI_BUFFER_LEN];
-static unsigned int buf_ofs;
+struct qmi_arena_chunk {
+	struct qmi_arena_chunk *next;
+	uint8_t data[];
+};
 
-uint8_t *__qmi_get_buf(unsigned int *ofs)
+static uint8_t default_buf[QMI_BUFFER_LEN];
+static struct qmi_arena default_arena = {
+	.buf = default_buf,
+	.len = sizeof(default_buf),
+	.alloc = qmi_arena_grow,
+};
+
+/*
+ * Room for the largest possible request. Only the part a request actually
+ * fills is ever touched, so small requests do not pay for the rest. The
+ * headroom lets the MBIM header be put in front, so a frame goes out with
+ * a single write().
+ */
+static struct {
+	uint8_t headroom[QMI_REQUEST_HEADROOM];
+	union {
+		uint8_t buf[QMI_MSG_MAX_LEN];
+		struct qmi_msg msg;
+	};
+} request_buf;
+
+_Static_assert(sizeof(struct mbim_command_message) <= QMI_REQUEST_HEADROOM,
+	       "no room for the MBIM header in front of the request buffer");
+
+struct qmi_arena *qmi_default_arena(void)
 {
-	*ofs = buf_ofs;
-	return buf;
+	return &default_arena;
 }
 
-void __qmi_alloc_reset(void)
+struct qmi_msg *qmi_request_buf(void)
 {
-	buf_ofs = 0;
+	return &request_buf.msg;
+}
+
+void *qmi_arena_grow(struct qmi_arena *arena, unsigned int len)
+{
+	struct qmi_arena_chunk *chunk;
+
+	chunk = malloc(sizeof(*chunk) + len);
+	if (!chunk)
+		return NULL;
+
+	chunk->next = arena->priv;
+	arena->priv = chunk;
+	return chunk->data;
 }
 
-void *__qmi_alloc_static(unsigned int len)
+void qmi_arena_reset(struct qmi_arena *arena)
+{
+	struct qmi_arena_chunk *chunk;
+
+	arena->ofs = 0;
+	if (arena->alloc != qmi_arena_grow)
+		return;
+
+	while ((chunk = arena->priv) != NULL) {
+		arena->priv = chunk->next;
+		free(chunk);
+	}
+}
+
+void *qmi_arena_alloc(struct qmi_arena *arena, unsigned int len)
 {
 	void *ret;
 
-	if (buf_ofs + len > sizeof(buf)) {
-		fprintf(stderr, "ERROR: static buffer for message data too small\n");
-		abort();
+	if (len > arena->len - arena->ofs) {
+		if (!arena->alloc)
+			return NULL;
+
+		ret = arena->alloc(arena, len);
+		if (!ret)
+			return NULL;
+	} else {
+		ret = &arena->buf[arena->ofs];
+		arena->ofs += len;
 	}
 
-	ret = &buf[buf_ofs];
-	buf_ofs += len;
 	memset(ret, 0, len);
 	return ret;
 }
 
-char *__qmi_copy_string(void *data, unsigned int len)
+char *qmi_arena_strdup(struct qmi_arena *arena, const void *data, unsigned int len)
 {
 	char *res;
 
-	res = (char *) &buf[buf_ofs];
-	buf_ofs += len + 1;
+	if (len >= arena->len - arena->ofs) {
+		if (!arena->alloc)
+			return NULL;
+
+		res = arena->alloc(arena, len + 1);
+		if (!res)
+			return NULL;
+	} else {
+		res = (char *) &arena->buf[arena->ofs];
+		arena->ofs += len + 1;
+	}
+
 	memcpy(res, data, len);
 	res[len] = 0;
 	return res;
@@ -113,6 +181,31 @@ void tlv_new(struct qmi_msg *qm, uint8_t type, uint16_t len, void *data)
 	memcpy(tlv->data, data, len);
 }
 
+/*
+ * Start a TLV in place: the arena covers the free space behind the TLV
+ * header, so the encoder writes its payload straight into the message.
+ */
+void tlv_arena_init(struct qmi_msg *qm, struct qmi_arena *arena)
+{
+	struct tlv *tlv = qmi_msg_next_tlv(qm, 0);
+	unsigned int used = (uint8_t *) tlv->data - (uint8_t *) qm;
+	unsigned int size = QMI_BUFFER_LEN;
+
+	if (qm == &request_buf.msg)
+		size = QMI_MSG_MAX_LEN;
+
+	qmi_arena_init(arena, tlv->data, used < size ? size - used : 0);
+}
+
+void tlv_arena_finish(struct qmi_msg *qm, uint8_t type, struct qmi_arena *arena)
+{
+	struct tlv *tlv;
+
+	tlv = qmi_msg_next_tlv(qm, sizeof(*tlv) + arena->ofs);
+	tlv->type = type;
+	tlv->len = cpu_to_le16(arena->ofs);
+}
+
 void qmi_init_request_message(struct qmi_msg *qm, QmiService service)
 {
 	memset(qm, 0, sizeof(*qm));
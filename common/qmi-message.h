@@ -24,10 +24,14 @@
 
 #include <libubox/utils.h>
 #include <stdbool.h>
+#include <string.h>
 
 #include "qmi-struct.h"
 #include "qmi-enums.h"
 
+struct qmi_arena;
+struct qmi_tlv_iter;
+
 #include "qmi-enums-private.h"
 #include "qmi-message-ctl.h"
 
@@ -54,6 +58,8 @@
 #include "qmi-enums-uim.h"
 #include "qmi-message-uim.h"
 
+#include "qmi-enum-names.h"
+
 #define qmi_set(_data, _field, _val) \
 	do { \
 		(_data)->set._field = 1; \
@@ -101,14 +107,84 @@ enum {
 	QMI_ERROR_NO_DATA = -1,
 	QMI_ERROR_INVALID_DATA = -2,
 	QMI_ERROR_CANCELLED = -3,
+	QMI_ERROR_NO_MEMORY = -4,
+	QMI_ERROR_TIMEOUT = -5,
 };
 
 #define QMI_BUFFER_LEN 2048
 
-void __qmi_alloc_reset(void);
-void *__qmi_alloc_static(unsigned int len);
-char *__qmi_copy_string(void *data, unsigned int len);
-uint8_t *__qmi_get_buf(unsigned int *ofs);
+/* largest message the 16 bit QMUX length allows, including the marker */
+#define QMI_MSG_MAX_LEN (1 + 0xffff)
+
+/*
+ * Storage for decoded arrays and strings. The caller owns the arena and
+ * the data it hands out stays valid until the arena is reset, so results
+ * of several messages can be kept side by side. When the buffer is used
+ * up, allocations are passed on to the optional alloc callback (e.g. a
+ * talloc context in priv); without one they fail with NULL.
+ */
+struct qmi_arena {
+	uint8_t *buf;
+	unsigned int len;
+	unsigned int ofs;
+
+	void *(*alloc)(struct qmi_arena *arena, unsigned int len);
+	void *priv;
+};
+
+#define QMI_ARENA_INIT(_buf, _len) \
+	{ .buf = (uint8_t *) (_buf), .len = (_len) }
+
+#define QMI_ARENA_DECLARE(_name, _len) \
+	uint8_t _name##_buf[_len]; \
+	struct qmi_arena _name = QMI_ARENA_INIT(_name##_buf, _len)
+
+static inline void qmi_arena_init(struct qmi_arena *arena, void *buf, unsigned int len)
+{
+	memset(arena, 0, sizeof(*arena));
+	arena->buf = buf;
+	arena->len = len;
+}
+
+void qmi_arena_reset(struct qmi_arena *arena);
+void *qmi_arena_alloc(struct qmi_arena *arena, unsigned int len);
+char *qmi_arena_strdup(struct qmi_arena *arena, const void *data, unsigned int len);
+
+/*
+ * alloc callback that spills into malloc()ed chunks kept in priv, which
+ * are released by the next qmi_arena_reset()
+ */
+void *qmi_arena_grow(struct qmi_arena *arena, unsigned int len);
+
+/*
+ * Besides qmi_parse_<msg>() the generator emits a lazy view API:
+ * qmi_view_<msg>() only records where each TLV starts, and
+ * qmi_view_<msg>_<field>() decodes a single field into res on demand,
+ * returning QMI_ERROR_NO_DATA if the TLV is absent. Fields without
+ * strings or arrays do not touch the arena, which may be NULL for them.
+ *
+ * Counted arrays can also be streamed: qmi_view_<msg>_<path>_iter()
+ * returns the number of elements and qmi_view_<msg>_<path>_next()
+ * decodes the next one into res until it returns QMI_ERROR_NO_DATA, so
+ * the arena only has to hold a single element at a time.
+ */
+struct qmi_tlv_iter {
+	struct tlv *tlv;
+	unsigned int ofs;
+	unsigned int n;
+};
+
+/* arena used by the qmi_parse_* wrappers, reset on every call */
+struct qmi_arena *qmi_default_arena(void);
+
+/*
+ * The qmi_set_* encoders fill up to QMI_BUFFER_LEN bytes of the message,
+ * or up to QMI_MSG_MAX_LEN if it is the shared buffer returned here. That
+ * one is preceded by QMI_REQUEST_HEADROOM bytes for a transport header.
+ */
+#define QMI_REQUEST_HEADROOM	48
+
+struct qmi_msg *qmi_request_buf(void);
 
 static inline int tlv_data_len(struct tlv *tlv)
 {
@@ -117,6 +193,8 @@ static inline int tlv_data_len(struct tlv *tlv)
 
 struct tlv *tlv_get_next(void **buf, unsigned int *buflen);
 void tlv_new(struct qmi_msg *qm, uint8_t type, uint16_t len, void *data);
+void tlv_arena_init(struct qmi_msg *qm, struct qmi_arena *arena);
+void tlv_arena_finish(struct qmi_msg *qm, uint8_t type, struct qmi_arena *arena);
 
 void qmi_init_request_message(struct qmi_msg *qm, QmiService service);
 int qmi_complete_request_message(struct qmi_msg *qm);
@@ -0,0 +1,87 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#include "qmi-message.h"
+#include "qmi-req-table.h"
+
+static unsigned int qmi_req_hash(uint32_t key)
+{
+	return (key * 0x9e3779b1) >> (32 - QMI_REQ_TABLE_BITS);
+}
+
+static struct qmi_req_slot *qmi_req_table_lookup(struct qmi_req_table *t, uint32_t key)
+{
+	unsigned int i = qmi_req_hash(key);
+
+	while (t->slot[i].req && t->slot[i].key != key)
+		i = (i + 1) & (QMI_REQ_TABLE_SIZE - 1);
+
+	return &t->slot[i];
+}
+
+/* fails if the table is full or the key is still taken */
+int qmi_req_table_add(struct qmi_req_table *t, uint32_t key, void *req)
+{
+	struct qmi_req_slot *slot;
+
+	if (t->n >= QMI_REQ_TABLE_MAX)
+		return QMI_ERROR_NO_MEMORY;
+
+	slot = qmi_req_table_lookup(t, key);
+	if (slot->req)
+		return QMI_ERROR_INVALID_DATA;
+
+	slot->key = key;
+	slot->req = req;
+	t->n++;
+
+	return 0;
+}
+
+void *qmi_req_table_find(struct qmi_req_table *t, uint32_t key)
+{
+	return qmi_req_table_lookup(t, key)->req;
+}
+
+void qmi_req_table_del(struct qmi_req_table *t, uint32_t key)
+{
+	struct qmi_req_slot *slot = qmi_req_table_lookup(t, key);
+	unsigned int mask = QMI_REQ_TABLE_SIZE - 1;
+	unsigned int hole, i, home;
+
+	if (!slot->req)
+		return;
+
+	t->n--;
+	hole = slot - t->slot;
+	for (i = (hole + 1) & mask; t->slot[i].req; i = (i + 1) & mask) {
+		home = qmi_req_hash(t->slot[i].key);
+
+		/* entries whose home lies cyclically in (hole, i] stay put */
+		if (((i - home) & mask) < ((i - hole) & mask))
+			continue;
+
+		t->slot[hole] = t->slot[i];
+		hole = i;
+	}
+
+	t->slot[hole].req = NULL;
+}
@@ -0,0 +1,58 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __UQMI_REQ_TABLE_H
+#define __UQMI_REQ_TABLE_H
+
+#include <stdint.h>
+
+/*
+ * Outstanding requests of a device, indexed by service, client id and
+ * transaction id of the response they wait for. Open addressing with
+ * linear probing; removal shifts the following entries back instead of
+ * leaving tombstones, so lookups never get slower over time.
+ */
+
+#define QMI_REQ_TABLE_BITS	10
+#define QMI_REQ_TABLE_SIZE	(1 << QMI_REQ_TABLE_BITS)
+/* keeps the probe sequences short */
+#define QMI_REQ_TABLE_MAX	(QMI_REQ_TABLE_SIZE * 3 / 4)
+
+struct qmi_req_slot {
+	uint32_t key;
+	void *req;
+};
+
+struct qmi_req_table {
+	unsigned int n;
+	struct qmi_req_slot slot[QMI_REQ_TABLE_SIZE];
+};
+
+static inline uint32_t qmi_req_key(uint8_t service, uint8_t client, uint16_t tid)
+{
+	return (service << 24) | (client << 16) | tid;
+}
+
+int qmi_req_table_add(struct qmi_req_table *t, uint32_t key, void *req);
+void *qmi_req_table_find(struct qmi_req_table *t, uint32_t key);
+void qmi_req_table_del(struct qmi_req_table *t, uint32_t key);
+
+#endif
@@ -0,0 +1,185 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#include <time.h>
+
+#include <libubox/uloop.h>
+#include <libubox/utils.h>
+
+#include "timer-wheel.h"
+
+#define WHEEL_BITS	6
+#define WHEEL_SLOTS	(1 << WHEEL_BITS)
+#define WHEEL_MASK	(WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS	4
+#define WHEEL_MAX	((1ULL << (WHEEL_BITS * WHEEL_LEVELS)) - 1)
+
+static struct {
+	struct uloop_timeout timeout;
+	/* the next tick to run */
+	uint64_t tick;
+	unsigned int pending;
+	struct list_head slot[WHEEL_LEVELS][WHEEL_SLOTS];
+} wheel;
+
+static uint64_t wheel_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void wheel_insert(struct qmi_timer *t)
+{
+	uint64_t delta = 0;
+	int level = 0;
+
+	if (t->expires > wheel.tick)
+		delta = t->expires - wheel.tick;
+
+	if (delta > WHEEL_MAX)
+		delta = WHEEL_MAX;
+
+	t->expires = wheel.tick + delta;
+	while (delta >> (WHEEL_BITS * (level + 1)))
+		level++;
+
+	list_add_tail(&t->list, &wheel.slot[level][(t->expires >> (WHEEL_BITS * level)) & WHEEL_MASK]);
+}
+
+/* move the timers of a slot down to the lower levels */
+static void wheel_cascade(int level)
+{
+	struct list_head *slot = &wheel.slot[level][(wheel.tick >> (WHEEL_BITS * level)) & WHEEL_MASK];
+	struct qmi_timer *t, *tmp;
+	LIST_HEAD(list);
+
+	list_splice_init(slot, &list);
+	list_for_each_entry_safe(t, tmp, &list, list)
+		wheel_insert(t);
+}
+
+static void wheel_run(uint64_t now)
+{
+	struct qmi_timer *t;
+	LIST_HEAD(list);
+	int level;
+
+	while (wheel.tick <= now) {
+		if (!wheel.pending) {
+			wheel.tick = now + 1;
+			break;
+		}
+
+		for (level = 1; level < WHEEL_LEVELS; level++) {
+			if (wheel.tick & ((1ULL << (WHEEL_BITS * level)) - 1))
+				break;
+
+			wheel_cascade(level);
+		}
+
+		/* timers set from the callbacks must not land in this slot again */
+		list_splice_init(&wheel.slot[0][wheel.tick & WHEEL_MASK], &list);
+		wheel.tick++;
+
+		while (!list_empty(&list)) {
+			t = list_first_entry(&list, struct qmi_timer, list);
+			list_del(&t->list);
+			t->pending = false;
+			wheel.pending--;
+			t->cb(t);
+		}
+	}
+}
+
+/* wake up for the next slot with timers or the next cascade, whichever is first */
+static void wheel_arm(uint64_t now_ms)
+{
+	unsigned int idx = wheel.tick & WHEEL_MASK;
+	unsigned int i, limit = idx ? WHEEL_SLOTS - idx : 0;
+	uint64_t next;
+
+	if (!wheel.pending) {
+		uloop_timeout_cancel(&wheel.timeout);
+		return;
+	}
+
+	for (i = 0; i < limit; i++)
+		if (!list_empty(&wheel.slot[0][(idx + i) & WHEEL_MASK]))
+			break;
+
+	next = (wheel.tick + i) * QMI_TIMER_TICK_MS;
+	uloop_timeout_set(&wheel.timeout, next > now_ms ? next - now_ms : 0);
+}
+
+static void wheel_timeout_cb(struct uloop_timeout *timeout)
+{
+	uint64_t now_ms = wheel_now_ms();
+
+	wheel_run(now_ms / QMI_TIMER_TICK_MS);
+	wheel_arm(now_ms);
+}
+
+static void wheel_init(uint64_t now_ms)
+{
+	int i, j;
+
+	if (wheel.timeout.cb)
+		return;
+
+	for (i = 0; i < WHEEL_LEVELS; i++)
+		for (j = 0; j < WHEEL_SLOTS; j++)
+			INIT_LIST_HEAD(&wheel.slot[i][j]);
+
+	wheel.tick = now_ms / QMI_TIMER_TICK_MS;
+	wheel.timeout.cb = wheel_timeout_cb;
+}
+
+void qmi_timer_set(struct qmi_timer *t, unsigned int msecs)
+{
+	uint64_t now_ms = wheel_now_ms();
+
+	wheel_init(now_ms);
+	qmi_timer_cancel(t);
+
+	/* an idle wheel may be far behind, there is nothing to catch up on */
+	if (!wheel.pending)
+		wheel.tick = now_ms / QMI_TIMER_TICK_MS;
+
+	/* round up, the timer never fires early */
+	t->expires = (now_ms + msecs + QMI_TIMER_TICK_MS - 1) / QMI_TIMER_TICK_MS;
+	t->pending = true;
+	wheel.pending++;
+	wheel_insert(t);
+	wheel_arm(now_ms);
+}
+
+void qmi_timer_cancel(struct qmi_timer *t)
+{
+	if (!t->pending)
+		return;
+
+	list_del(&t->list);
+	t->pending = false;
+	if (!--wheel.pending)
+		uloop_timeout_cancel(&wheel.timeout);
+}
@@ -0,0 +1,55 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __UQMI_TIMER_WHEEL_H
+#define __UQMI_TIMER_WHEEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <libubox/list.h>
+
+/*
+ * Timers for many short lived deadlines, e.g. one per pending request.
+ *
+ * They are kept in a hierarchical timer wheel: 4 levels of 64 slots, level
+ * n covering 64^(n+1) ticks of QMI_TIMER_TICK_MS. Setting and cancelling a
+ * timer is a list operation; timers further out are moved down a level as
+ * their time comes closer. The whole wheel runs off a single uloop timeout,
+ * which only fires for ticks that have timers due or need to cascade.
+ */
+
+#define QMI_TIMER_TICK_MS	10
+
+struct qmi_timer;
+typedef void (*qmi_timer_cb)(struct qmi_timer *t);
+
+struct qmi_timer {
+	struct list_head list;
+	qmi_timer_cb cb;
+	uint64_t expires;
+	bool pending;
+};
+
+void qmi_timer_set(struct qmi_timer *t, unsigned int msecs);
+void qmi_timer_cancel(struct qmi_timer *t);
+
+#endif
@@ -19,24 +19,107 @@
  * Boston, MA 02110-1301 USA.
  */
 
+#include <ctype.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <libubox/utils.h>
+#include <libubox/ustream.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "qmi-message.h"
 #include "utils.h"
 #include "qmi-errors.h"
 #include <qmi-errors.c>
 
 
+const char *qmi_enum_name(const struct qmi_enum_names *names, int value)
+{
+	const struct qmi_enum_entry *entry;
+	unsigned int slot;
+
+	if (names->sparse)
+		slot = (unsigned int) value % names->value_size;
+	else
+		slot = (unsigned int) value - names->min;
+
+	if (slot >= names->value_size || !names->by_value[slot])
+		return NULL;
+
+	entry = &names->entries[names->by_value[slot] - 1];
+	if (entry->value != value)
+		return NULL;
+
+	return entry->name;
+}
+
+static uint32_t qmi_enum_hash(const char *name, uint32_t seed)
+{
+	uint32_t h = seed ^ 2166136261U;
+
+	for (; *name; name++) {
+		char c = tolower(*name);
+
+		if (c == '-')
+			c = '_';
+
+		h ^= (uint8_t) c;
+		h *= 16777619;
+	}
+
+	return h ^ (h >> 16);
+}
+
+static bool qmi_enum_name_match(const char *a, const char *b)
+{
+	for (; *a && *b; a++, b++) {
+		if (*a == *b)
+			continue;
+
+		if ((*a == '-' || *a == '_') && (*b == '-' || *b == '_'))
+			continue;
+
+		if (tolower(*a) != tolower(*b))
+			return false;
+	}
+
+	return *a == *b;
+}
+
+int qmi_enum_value(const struct qmi_enum_names *names, const char *name, int *value)
+{
+	const struct qmi_enum_entry *entry;
+	uint32_t seed;
+	int idx;
+
+	seed = names->name_disp[qmi_enum_hash(name, 0) & names->disp_mask];
+	idx = names->by_name[qmi_enum_hash(name, seed) & names->name_mask];
+	if (!idx)
+		return -1;
+
+	entry = &names->entries[idx - 1];
+	if (!qmi_enum_name_match(entry->name, name))
+		return -1;
+
+	*value = entry->value;
+	return 0;
+}
+
 const char *qmi_get_error_str(int code)
 {
-	int i;
+	const char *str;
 
-	for (i = 0; i < ARRAY_SIZE(qmi_errors); i++) {
-		if (qmi_errors[i].code == code)
-			return qmi_errors[i].text;
+	switch (code) {
+	case QMI_ERROR_CANCELLED:
+		return "Request cancelled";
+	case QMI_ERROR_TIMEOUT:
+		return "Request timed out";
 	}
 
-	return "Unknown error";
+	str = qmi_enum_name(&qmi_errors, code);
+
+	return str ? str : "Unknown error";
 }
 
 void system_fd_set_cloexec(int fd)
@@ -45,3 +128,96 @@ void system_fd_set_cloexec(int fd)
 	fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
 #endif
 }
+
+/*
+ * Send a frame made of several buffers with a single writev() on the
+ * device. Only if the fd would block, or older data is still queued, the
+ * remainder ends up being copied into the ustream write buffers.
+ *
+ * Character devices without write_iter (cdc-wdm) see one write() per
+ * iovec, so a frame for them has to be passed as a single buffer.
+ */
+void ustream_fd_writev(struct ustream_fd *sf, const struct iovec *iov, int iovcnt)
+{
+	struct ustream *s = &sf->stream;
+	ssize_t done = 0;
+	int i;
+
+	if (s->write_error)
+		return;
+
+	if (!ustream_pending_data(s, true)) {
+		do {
+			done = writev(sf->fd.fd, iov, iovcnt);
+		} while (done < 0 && errno == EINTR);
+
+		/* let ustream deal with hard errors */
+		if (done < 0)
+			done = 0;
+	}
+
+	for (i = 0; i < iovcnt; i++) {
+		if (done >= iov[i].iov_len) {
+			done -= iov[i].iov_len;
+			continue;
+		}
+
+		ustream_write(s, (char *) iov[i].iov_base + done, iov[i].iov_len - done, false);
+		done = 0;
+	}
+}
+
+/*
+ * ustream_fd_init() with enough read buffers to hold max_len bytes of
+ * unconsumed data, the default of a single one stalls on any message that
+ * does not fit. Buffers are only allocated once they are needed.
+ */
+void ustream_fd_init_len(struct ustream_fd *sf, int fd, int max_len)
+{
+	struct ustream *s = &sf->stream;
+
+	s->r.buffer_len = 4096;
+	s->r.max_buffers = max_len / s->r.buffer_len + 2;
+	ustream_fd_init(sf, fd);
+}
+
+/*
+ * Like ustream_get_read_buf(), but returns the first len bytes of the
+ * stream in one piece. If they are spread over several read buffers, they
+ * are copied into *buf, which is grown with realloc() as needed and owned
+ * by the caller. Returns NULL until len bytes are pending.
+ */
+char *ustream_get_read_buf_len(struct ustream *s, int len, char **buf, int *buf_len)
+{
+	struct ustream_buf *b;
+	char *data;
+	int avail, ofs = 0;
+
+	data = ustream_get_read_buf(s, &avail);
+	if (data && avail >= len)
+		return data;
+
+	if (ustream_pending_data(s, false) < len)
+		return NULL;
+
+	if (*buf_len < len) {
+		data = realloc(*buf, len);
+		if (!data)
+			return NULL;
+
+		*buf = data;
+		*buf_len = len;
+	}
+
+	for (b = s->r.head; b && ofs < len; b = b->next) {
+		int cur = b->tail - b->data;
+
+		if (cur > len - ofs)
+			cur = len - ofs;
+
+		memcpy(*buf + ofs, b->data, cur);
+		ofs += cur;
+	}
+
+	return *buf;
+}
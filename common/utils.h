@@ -23,7 +23,43 @@
 #ifndef __UTILS_H
 #define __UTILS_H
 
+#include <stdint.h>
+#include <sys/uio.h>
+
+struct ustream;
+struct ustream_fd;
+
+struct qmi_enum_entry {
+	const char *name;
+	int value;
+};
+
+/*
+ * Name tables emitted by gen-enum-list.pl (qmi_<enum>_names for every enum
+ * in the qmi-enums-*.h headers) and gen-error-list.pl. Both directions are
+ * a single table access, see gen-enum-common.pm for the layout.
+ */
+struct qmi_enum_names {
+	const struct qmi_enum_entry *entries;
+	const uint16_t *by_value;
+	const uint16_t *by_name;
+	const uint16_t *name_disp;
+	int min;
+	uint16_t value_size;
+	uint16_t name_mask;
+	uint16_t disp_mask;
+	uint8_t sparse;
+};
+
+/* NULL if the value is unknown */
+const char *qmi_enum_name(const struct qmi_enum_names *names, int value);
+/* case insensitive, '-' and '_' match each other; -1 if the name is unknown */
+int qmi_enum_value(const struct qmi_enum_names *names, const char *name, int *value);
+
 const char *qmi_get_error_str(int code);
 void system_fd_set_cloexec(int fd);
+void ustream_fd_writev(struct ustream_fd *sf, const struct iovec *iov, int iovcnt);
+void ustream_fd_init_len(struct ustream_fd *sf, int fd, int max_len);
+char *ustream_get_read_buf_len(struct ustream *s, int len, char **buf, int *buf_len);
 
 #endif /* __UTILS_H */
@@ -0,0 +1,116 @@
+#!/usr/bin/env perl
+use strict;
+
+# Turns qmi-bands.txt into one table per RAT of disjoint channel ranges,
+# sorted by their first channel for a binary search. Ranges shared by
+# several bands go to the band listed first, each range carries the
+# downlink frequency of its first channel and the channel spacing.
+
+@ARGV == 1 or die "Usage: $0 <qmi-bands.txt>\n";
+
+my %rat_step = (
+	lte => 100,
+	umts => 200,
+);
+
+# NR-ARFCN global raster (38.104 table 5.4.2.1-1): first channel, kHz, step
+my @nr_raster = (
+	[ 0, 0, 5 ],
+	[ 600000, 3000000, 15 ],
+	[ 2016667, 24250080, 60 ],
+	[ 3279166 ],
+);
+
+my @rats = qw(lte umts nr);
+my %ranges;
+
+sub khz($) {
+	return sprintf("%.0f", shift() * 1000);
+}
+
+sub nr_raster($$) {
+	my ($first, $last) = @_;
+
+	for (my $i = 0; $i < @nr_raster - 1; $i++) {
+		my ($start, $freq, $step) = @{$nr_raster[$i]};
+
+		$first >= $nr_raster[$i + 1][0] and next;
+		$last < $nr_raster[$i + 1][0] or die "NR-ARFCN $first-$last crosses the raster at $nr_raster[$i + 1][0]\n";
+		return ($freq + $step * ($first - $start), $step);
+	}
+	die "NR-ARFCN $first is out of range\n";
+}
+
+# the parts of first..last not taken by an earlier band yet
+sub unclaimed($$$) {
+	my ($list, $first, $last) = @_;
+	my @free = ([ $first, $last ]);
+
+	foreach my $r (@$list) {
+		my @rest;
+
+		foreach my $f (@free) {
+			if ($r->{last} < $f->[0] or $r->{first} > $f->[1]) {
+				push @rest, $f;
+				next;
+			}
+			push @rest, [ $f->[0], $r->{first} - 1 ] if $f->[0] < $r->{first};
+			push @rest, [ $r->{last} + 1, $f->[1] ] if $f->[1] > $r->{last};
+		}
+		@free = @rest;
+	}
+
+	return @free;
+}
+
+open my $fh, '<', $ARGV[0] or die "Cannot open $ARGV[0]\n";
+while (my $line = <$fh>) {
+	$line =~ s/#.*//;
+	$line =~ /\S/ or next;
+
+	my ($rat, $band, $duplex, $mhz, $first, $last, $freq) = split /\s+/, $line =~ s/^\s+//r;
+	exists $rat_step{$rat} or $rat eq "nr" or die "Unknown RAT '$rat' at line $.\n";
+	$duplex =~ /^(FDD|TDD|SDL)$/ or die "Unknown duplex mode '$duplex' at line $.\n";
+	$first <= $last or die "Empty channel range at line $.\n";
+	$rat eq "nr" or defined $freq or die "Missing frequency at line $.\n";
+
+	foreach my $part (unclaimed($ranges{$rat} ||= [], $first, $last)) {
+		my ($pfirst, $plast) = @$part;
+		my ($pfreq, $step);
+
+		if ($rat eq "lte") {
+			$step = $rat_step{$rat};
+			$pfreq = khz($freq) + $step * ($pfirst - $first);
+		} elsif ($rat eq "umts") {
+			$step = $rat_step{$rat};
+			$pfreq = khz($freq) + $step * $pfirst;
+		} else {
+			($pfreq, $step) = nr_raster($pfirst, $plast);
+		}
+		$pfreq > 0 or die "Invalid frequency at line $.\n";
+
+		push @{$ranges{$rat}}, {
+			first => $pfirst,
+			last => $plast,
+			freq => $pfreq,
+			step => $step,
+			band => $band,
+			mhz => $mhz,
+			duplex => $duplex,
+		};
+	}
+}
+close $fh;
+
+print "/* generated by gen-band-table.pl, do not edit */\n\n";
+
+foreach my $rat (@rats) {
+	my @list = sort { $a->{first} <=> $b->{first} } @{$ranges{$rat} || []};
+
+	@list > 0 or die "No bands for $rat\n";
+	print "static const struct qmi_band qmi_bands_$rat\[] = {\n";
+	foreach my $r (@list) {
+		print "\t{ $r->{first}, $r->{last}, $r->{freq}, $r->{step}, $r->{band}, $r->{mhz}, QMI_BAND_DUPLEX_$r->{duplex} },\n";
+	}
+	print "};\n\n";
+}
@@ -0,0 +1,300 @@
+#!/usr/bin/env perl
+use strict;
+
+use FindBin '$Bin';
+require "$Bin/gen-common.pm";
+
+our %tlv_types;
+our $ctl;
+
+my $data = get_json();
+my $n_elems = 0;
+my $decls;
+
+my %int_size = (
+	gint8 => 1,
+	guint8 => 1,
+	gint16 => 2,
+	guint16 => 2,
+	gint32 => 4,
+	guint32 => 4,
+	gint64 => 8,
+	guint64 => 8,
+);
+
+sub prefix_size($$) {
+	my $prefix = shift;
+	my $default = shift;
+
+	$prefix or $prefix = $default;
+	$prefix or return 0;
+
+	my $size = $int_size{$prefix};
+	defined $size or die "Unknown size prefix type $prefix\n";
+	return $size;
+}
+
+# Returns an initializer for struct qmi_elem describing $elem, which lives
+# at member $path of the object $root (a C lvalue expression)
+sub gen_elem($$$);
+sub gen_elem($$$) {
+	my $elem = shift;
+	my $root = shift;
+	my $path = shift;
+
+	my $type = $elem->{"format"};
+	my $base = "typeof($root)";
+	my $member = $path ? "$root.$path" : $root;
+	my $offset = $path ? "offsetof($base, $path)" : "0";
+	my @init = (".offset = $offset");
+
+	if ($int_size{$type}) {
+		push @init, ".type = QMI_ELEM_INT", ".size = $int_size{$type}";
+
+		my @flags;
+		$elem->{endian} eq 'network' and push @flags, "QMI_ELEM_F_BE";
+		$elem->{"public-format"} eq 'gboolean' and push @flags, "QMI_ELEM_F_BOOL";
+		@flags and push @init, ".flags = ".join(" | ", @flags);
+	} elsif ($type eq "gfloat") {
+		push @init, ".type = QMI_ELEM_FLOAT", ".size = 4";
+	} elsif ($type eq "guint-sized") {
+		push @init, ".type = QMI_ELEM_SIZED", ".size = ".$elem->{"guint-size"};
+	} elsif ($type eq "string") {
+		my $size = 0;
+
+		push @init, ".type = QMI_ELEM_STRING";
+		if ($elem->{"fixed-size"}) {
+			push @init, ".fixed = ".$elem->{"fixed-size"};
+		} else {
+			$size = prefix_size($elem->{"size-prefix-format"}, $elem->{type} eq 'TLV' ? undef : 'guint8');
+		}
+		$size and push @init, ".size = $size";
+		$elem->{"max-size"} and push @init, ".max = ".$elem->{"max-size"};
+	} elsif ($type eq "array") {
+		my $element = $elem->{"array-element"};
+		my $elem_root = "$member\[0]";
+
+		$element->{format} eq "array" and not $element->{"fixed-size"} and
+			die "Arrays of variable sized arrays are not supported ($member)\n";
+
+		push @init, ".type = QMI_ELEM_ARRAY", ".elem_size = sizeof($elem_root)";
+		if ($elem->{"fixed-size"}) {
+			push @init, ".fixed = ".$elem->{"fixed-size"};
+		} else {
+			push @init, ".size = ".prefix_size($elem->{"size-prefix-format"}, 'guint8');
+			push @init, ".n_offset = offsetof($base, $path\_n)";
+		}
+
+		my $name = "elems_".$n_elems++;
+		my $sub = gen_elem($element, $elem_root, "");
+		$decls .= "static const struct qmi_elem $name\[] = {\n\t$sub,\n};\n\n";
+		push @init, ".n_sub = 1", ".sub = $name";
+	} elsif ($type eq "struct" or $type eq "sequence") {
+		my @sub;
+
+		foreach my $field (@{$elem->{contents}}) {
+			$field = gen_common_ref($field);
+			my $cname = gen_cname($field->{name});
+			push @sub, gen_elem($field, $root, $path ? "$path.$cname" : $cname);
+		}
+
+		my $name = "elems_".$n_elems++;
+		$decls .= "static const struct qmi_elem $name\[] = {\n\t".join(",\n\t", @sub).",\n};\n\n";
+		push @init, ".type = QMI_ELEM_STRUCT", ".n_sub = ".scalar(@sub), ".sub = $name";
+	} else {
+		die "Invalid type $type for variable $member\n";
+	}
+
+	return "{ ".join(", ", @init)." }";
+}
+
+# same rule as gen-header.pl: strings and variable sized arrays have no set bit
+sub has_set_bit($) {
+	my $elem = shift;
+	my $type = $elem->{"format"};
+
+	$type eq "string" and return 0;
+	$type eq "array" and do {
+		$elem->{"fixed-size"} or return 0;
+		return has_set_bit($elem->{"array-element"});
+	};
+	return 1;
+}
+
+sub gen_msg_desc($$$) {
+	my $name = shift;
+	my $fields = shift;
+	my $data = shift;
+
+	my $cname = gen_cname($name);
+	my $root = "(*(struct qmi_$cname *) 0)";
+	my $set_bit = 0;
+	my @tlvs;
+
+	$decls = "";
+	foreach my $field (gen_view_fields($fields)) {
+		my $bit = -1;
+
+		has_set_bit($field) and $bit = $set_bit++;
+
+		my $elem = gen_elem($field, $root, "data.".gen_cname($field->{name}));
+		push @tlvs, "{ .id = $field->{id}, .set_bit = $bit, .elem = $elem }";
+	}
+
+	print $decls;
+	print "static const struct qmi_tlv_desc qmi_$cname\_tlv[] = {\n\t".join(",\n\t", @tlvs).",\n};\n\n";
+	print <<EOF;
+static const struct qmi_msg_desc qmi_$cname\_desc = {
+	.service = QMI_SERVICE_$data->{service},
+	.message = $data->{id},
+	.n_tlv = ARRAY_SIZE(qmi_$cname\_tlv),
+	.size = sizeof(struct qmi_$cname),
+	.tlv = qmi_$cname\_tlv,
+};
+
+EOF
+}
+
+sub gen_parse_func($$$)
+{
+	my $name = shift;
+	my $fields = shift;
+	my $data = shift;
+
+	my $type = "svc";
+	$ctl and $type = "ctl";
+
+	gen_has_types($fields) or do {
+		print gen_tlv_parse_func($name, $fields)."\n";
+		print <<EOF;
+{
+	void *tlv_buf = &msg->$type.tlv;
+	unsigned int tlv_len = le16_to_cpu(msg->$type.tlv_len);
+
+	return qmi_check_message_status(tlv_buf, tlv_len);
+}
+
+EOF
+		return;
+	};
+
+	my $cname = gen_cname($name);
+	my $i = 0;
+
+	gen_msg_desc($name, $fields, $data);
+
+	print gen_tlv_view_func($name, $fields)."\n";
+	print <<EOF;
+{
+	return qmi_codec_view(msg, &qmi_$cname\_desc, view->tlv);
+}
+
+EOF
+	foreach my $field (gen_view_fields($fields)) {
+		print gen_tlv_view_field_func($name, gen_cname($field->{name}))."\n";
+		print <<EOF;
+{
+	return qmi_codec_decode_tlv(&qmi_$cname\_tlv[$i], view->tlv[$i], res, arena);
+}
+
+EOF
+		$i++;
+	}
+
+	foreach my $iter (gen_view_iters($fields)) {
+		my ($idx, $field, $path, $array, $ofs) = @$iter;
+		my $elem_name = "qmi_$cname\_$path\_elem";
+
+		$elem_name =~ s/\./_/g;
+		$decls = "";
+		my $elem = gen_elem($array, "(*(struct qmi_$cname *) 0)", "data.$path");
+		print $decls;
+		print "static const struct qmi_elem $elem_name = $elem;\n\n";
+
+		print gen_tlv_view_iter_func($name, $path)."\n";
+		print <<EOF;
+{
+	return qmi_codec_iter(&$elem_name, view->tlv[$idx], $ofs, iter);
+}
+
+EOF
+		print gen_tlv_view_next_func($name, $path)."\n";
+		print <<EOF;
+{
+	return qmi_codec_iter_next(&$elem_name, iter, res, arena);
+}
+
+EOF
+	}
+
+	print gen_tlv_parse_func($name, $fields)."\n";
+	print <<EOF;
+{
+	struct qmi_arena *arena = qmi_default_arena();
+
+	qmi_arena_reset(arena);
+	return qmi_codec_decode(msg, &qmi_$cname\_desc, res, arena);
+}
+
+EOF
+	print gen_tlv_parse_arena_func($name, $fields)."\n";
+	print <<EOF;
+{
+	return qmi_codec_decode(msg, &qmi_$cname\_desc, res, arena);
+}
+
+EOF
+}
+
+sub gen_set_func($$$)
+{
+	my $name = shift;
+	my $fields = shift;
+	my $data = shift;
+
+	my $type = "svc";
+	$data->{service} eq 'CTL' and $type = 'ctl';
+
+	print gen_tlv_set_func($name, $fields)."\n";
+	gen_has_types($fields) or do {
+		print <<EOF;
+{
+	qmi_init_request_message(msg, QMI_SERVICE_$data->{service});
+	msg->$type.message = cpu_to_le16($data->{id});
+
+	return 0;
+}
+
+EOF
+		return;
+	};
+
+	my $cname = gen_cname($name);
+	print <<EOF;
+{
+	return qmi_codec_encode(msg, &qmi_$cname\_desc, req);
+}
+
+EOF
+}
+
+sub gen_set_desc_func($$$)
+{
+	my $name = shift;
+	my $fields = shift;
+	my $data = shift;
+
+	gen_has_types($fields) and gen_msg_desc($name, $fields, $data);
+	gen_set_func($name, $fields, $data);
+}
+
+print <<EOF;
+/* generated by uqmi gen-code-table.pl */
+#include <stdio.h>
+#include <string.h>
+#include "qmi-message.h"
+#include "qmi-codec.h"
+
+EOF
+
+gen_foreach_message_type($data, \&gen_set_desc_func, \&gen_parse_func, \&gen_parse_func);
@@ -85,7 +85,7 @@ sub gen_tlv_parse_field($$$$) {
 
 			$var_data .= $indent."\t$curvar++;\n";
 			$data .= $indent."$iterator = $size;\n";
-			$data .= $indent."$var = __qmi_alloc_static($iterator * sizeof($var\[0]));\n";
+			$data .= $indent."$var = alloc_static($iterator * sizeof($var\[0]));\n";
 			$data .= $indent."while($iterator\-- > 0) {\n";
 		}
 
@@ -128,7 +128,7 @@ sub gen_tlv_parse_field($$$$) {
 			$data .= $indent."if ($iterator > $maxsize)\n";
 			$data .= $indent."\t$iterator = $maxsize;\n";
 		};
-		$data .= $indent.$var." = __qmi_copy_string(get_next($iterator), $iterator);\n";
+		$data .= $indent.$var." = copy_string(get_next($iterator), $iterator);\n";
 		return $data, 1;
 	} elsif ($type eq "guint-sized") {
 		my $size = $elem->{"guint-size"};
@@ -138,120 +138,153 @@ sub gen_tlv_parse_field($$$$) {
 	}
 }
 
-sub gen_tlv_type($$$) {
+sub gen_tlv_type($$) {
 	my $cname = shift;
 	my $elem = shift;
-	my $idx = shift;
-	my $idx_word = "found[".int($idx / 32)."]";
-	my $idx_bit = "(1 << ".($idx % 32).")";
 
 	my $type = $elem->{"format"};
-	my $id = $elem->{"id"};
 	my $data = "";
 	undef $varsize_field;
 	my $indent = "\t\t\t";
 
 	$type or return undef;
 
-	print <<EOF;
-		case $id:
-			if ($idx_word & $idx_bit)
-				break;
-
-			$idx_word |= $idx_bit;
-EOF
-
 	my $val = $tlv_get{$type};
 	if ($val) {
-		print $indent."qmi_set(res, $cname, $val);\n";
+		$data = $indent."qmi_set(res, $cname, $val);\n";
 	} elsif ($type eq "string") {
 		my ($var_data, $var_iterator) =
 			gen_tlv_parse_field("res->data.$cname", $elem, 0, "i");
-		print "$var_data";
+		$data = $var_data;
 	} elsif ($type eq "array") {
 		$elem->{"fixed-size"} and $data = $indent."res->set.$cname = 1;\n";
 		my ($var_data, $var_iterator) =
 			gen_tlv_parse_field("res->data.$cname", $elem, 0, "i");
-		print "$data$var_data\n";
+		$data .= $var_data;
 	} elsif ($type eq "sequence" or $type eq "struct") {
 		my ($var_data, $var_iterator) =
 			gen_tlv_parse_field("res->data.$cname", $elem, 0, "i");
-
-		print $indent."res->set.$cname = 1;\n".$var_data;
+		$data = $indent."res->set.$cname = 1;\n".$var_data;
 	}
-	print <<EOF;
-			break;
 
-EOF
+	# generated for the switch in the old parser, shift back to function level
+	$data =~ s/^\t\t//mg;
+	return $data;
 }
 
-sub gen_parse_func($$)
+sub gen_view_field_func($$$)
 {
 	my $name = shift;
-	my $data = shift;
+	my $field = shift;
+	my $idx = shift;
 
-	my $type = "svc";
-	$ctl and $type = "ctl";
+	my $cname = gen_cname($field->{name});
+	my $body = gen_tlv_type($cname, $field);
 
-	print gen_tlv_parse_func($name, $data)."\n";
+	print gen_tlv_view_field_func($name, $cname)."\n";
 	print <<EOF;
 {
-	void *tlv_buf = &msg->$type.tlv;
-	unsigned int tlv_len = le16_to_cpu(msg->$type.tlv_len);
-EOF
+	struct tlv *tlv = view->tlv[$idx];
+	unsigned int cur_tlv_len;
+	unsigned int ofs = 0;
+	int i;
 
-	if (gen_has_types($data)) {
-		my $n_bits = scalar @$data;
-		my $n_words = int(($n_bits + 31) / 32);
-		my $i = 0;
+	if (!tlv)
+		return QMI_ERROR_NO_DATA;
 
-		print <<EOF;
-	struct tlv *tlv;
-	int i;
-	uint32_t found[$n_words] = {};
+	cur_tlv_len = le16_to_cpu(tlv->len);
+$body
+	return 0;
 
-	memset(res, 0, sizeof(*res));
+error_len:
+	fprintf(stderr, "%s: Invalid TLV length in message, tlv=0x%02x, len=%d\\n",
+	        __func__, tlv->type, le16_to_cpu(tlv->len));
+	return QMI_ERROR_INVALID_DATA;
 
-	__qmi_alloc_reset();
-	while ((tlv = tlv_get_next(&tlv_buf, &tlv_len)) != NULL) {
-		unsigned int cur_tlv_len = le16_to_cpu(tlv->len);
-		unsigned int ofs = 0;
+error_nomem:
+	fprintf(stderr, "%s: Not enough memory to decode message, tlv=0x%02x\\n",
+	        __func__, tlv->type);
+	return QMI_ERROR_NO_MEMORY;
+}
 
-		switch(tlv->type) {
 EOF
-		foreach my $field (@$data) {
-			$field = gen_common_ref($field);
-			my $cname = gen_cname($field->{name});
-			gen_tlv_type($cname, $field, $i++);
-		}
+}
 
-		print <<EOF;
-		default:
-			break;
-		}
-	}
+sub gen_view_iter_funcs($$$$$$)
+{
+	my $name = shift;
+	my $idx = shift;
+	my $field = shift;
+	my $path = shift;
+	my $array = shift;
+	my $ofs = shift;
 
-	return 0;
+	my $prefix = $array->{"size-prefix-format"};
+	$prefix or $prefix = 'guint8';
+	my $size = $tlv_get{$prefix};
+	die "Unknown size element type '$prefix'" if not defined $size;
+
+	undef $varsize_field;
+	my ($body) = gen_tlv_parse_field("(*res)", $array->{"array-element"}, 0, "i");
+	$body =~ s/^\t\t//mg;
+
+	print gen_tlv_view_iter_func($name, $path)."\n";
+	print <<EOF;
+{
+	struct tlv *tlv = view->tlv[$idx];
+	unsigned int cur_tlv_len;
+	unsigned int ofs = $ofs;
+
+	iter->n = 0;
+	if (!tlv)
+		return QMI_ERROR_NO_DATA;
+
+	cur_tlv_len = le16_to_cpu(tlv->len);
+	iter->n = $size;
+	iter->tlv = tlv;
+	iter->ofs = ofs;
+	return iter->n;
 
 error_len:
 	fprintf(stderr, "%s: Invalid TLV length in message, tlv=0x%02x, len=%d\\n",
 	        __func__, tlv->type, le16_to_cpu(tlv->len));
 	return QMI_ERROR_INVALID_DATA;
-EOF
-	} else {
-		print <<EOF;
+}
 
-	return qmi_check_message_status(tlv_buf, tlv_len);
 EOF
-	}
-
+	print gen_tlv_view_next_func($name, $path)."\n";
 	print <<EOF;
+{
+	struct tlv *tlv = iter->tlv;
+	unsigned int cur_tlv_len;
+	unsigned int ofs = iter->ofs;
+	int i;
+
+	if (!iter->n)
+		return QMI_ERROR_NO_DATA;
+
+	cur_tlv_len = le16_to_cpu(tlv->len);
+	memset(res, 0, sizeof(*res));
+$body
+	iter->ofs = ofs;
+	iter->n--;
+	return 0;
+
+error_len:
+	fprintf(stderr, "%s: Invalid TLV length in message, tlv=0x%02x, len=%d\\n",
+	        __func__, tlv->type, le16_to_cpu(tlv->len));
+	return QMI_ERROR_INVALID_DATA;
+
+error_nomem:
+	fprintf(stderr, "%s: Not enough memory to decode message, tlv=0x%02x\\n",
+	        __func__, tlv->type);
+	return QMI_ERROR_NO_MEMORY;
 }
 
 EOF
 }
 
-sub gen_parse_ind_func($$)
+sub gen_view_func($$)
 {
 	my $name = shift;
 	my $data = shift;
@@ -259,53 +292,104 @@ sub gen_parse_ind_func($$)
 	my $type = "svc";
 	$ctl and $type = "ctl";
 
-	print gen_tlv_parse_func($name, $data)."\n";
+	my @fields = gen_view_fields($data);
+	my $i = 0;
+
+	print gen_tlv_view_func($name, $data)."\n";
 	print <<EOF;
 {
 	void *tlv_buf = &msg->$type.tlv;
 	unsigned int tlv_len = le16_to_cpu(msg->$type.tlv_len);
+	struct tlv *tlv;
+	int i = -1;
+
+	memset(view, 0, sizeof(*view));
+
+	while ((tlv = tlv_get_next(&tlv_buf, &tlv_len)) != NULL) {
+		switch(tlv->type) {
 EOF
+	foreach my $field (@fields) {
+		print "\t\tcase $field->{id}:\n";
+		print "\t\t\ti = $i;\n";
+		print "\t\t\tbreak;\n";
+		$i++;
+	}
+	print <<EOF;
+		default:
+			continue;
+		}
+
+		/* like the eager parser, only the first instance of a TLV counts */
+		if (!view->tlv[i])
+			view->tlv[i] = tlv;
+	}
+
+	return 0;
+}
+
+EOF
+
+	$i = 0;
+	foreach my $field (@fields) {
+		gen_view_field_func($name, $field, $i++);
+	}
+
+	foreach my $iter (gen_view_iters($data)) {
+		gen_view_iter_funcs($name, $iter->[0], $iter->[1], $iter->[2], $iter->[3], $iter->[4]);
+	}
+}
+
+sub gen_parse_func($$)
+{
+	my $name = shift;
+	my $data = shift;
+
+	my $type = "svc";
+	$ctl and $type = "ctl";
 
 	if (gen_has_types($data)) {
-		my $n_bits = scalar @$data;
-		my $n_words = int(($n_bits + 31) / 32);
-		my $i = 0;
+		my $cname = gen_cname($name);
 
+		gen_view_func($name, $data);
+
+		print gen_tlv_parse_func($name, $data)."\n";
 		print <<EOF;
-	struct tlv *tlv;
-	int i;
-	uint32_t found[$n_words] = {};
+{
+	struct qmi_arena *arena = qmi_default_arena();
+
+	qmi_arena_reset(arena);
+	return qmi_parse_$cname\_arena(msg, res, arena);
+}
+
+EOF
+		print gen_tlv_parse_arena_func($name, $data)."\n";
+		print <<EOF;
+{
+	struct qmi_$cname\_view view;
+	int ret;
 
 	memset(res, 0, sizeof(*res));
+	qmi_view_$cname(msg, &view);
 
-	__qmi_alloc_reset();
-	while ((tlv = tlv_get_next(&tlv_buf, &tlv_len)) != NULL) {
-		unsigned int cur_tlv_len = le16_to_cpu(tlv->len);
-		unsigned int ofs = 0;
+EOF
+		foreach my $field (gen_view_fields($data)) {
+			my $func = "qmi_view_$cname\_".gen_cname($field->{name});
+			print <<EOF;
+	ret = $func(&view, res, arena);
+	if (ret < 0 && ret != QMI_ERROR_NO_DATA)
+		return ret;
 
-		switch(tlv->type) {
 EOF
-		foreach my $field (@$data) {
-			$field = gen_common_ref($field);
-			my $cname = gen_cname($field->{name});
-			gen_tlv_type($cname, $field, $i++);
 		}
-
 		print <<EOF;
-		default:
-			break;
-		}
-	}
-
 	return 0;
-
-error_len:
-	fprintf(stderr, "%s: Invalid TLV length in message, tlv=0x%02x, len=%d\\n",
-	        __func__, tlv->type, le16_to_cpu(tlv->len));
-	return QMI_ERROR_INVALID_DATA;
 EOF
 	} else {
+		print gen_tlv_parse_func($name, $data)."\n";
 		print <<EOF;
+{
+	void *tlv_buf = &msg->$type.tlv;
+	unsigned int tlv_len = le16_to_cpu(msg->$type.tlv_len);
 
 	return qmi_check_message_status(tlv_buf, tlv_len);
 EOF
@@ -414,7 +498,7 @@ sub gen_tlv_val_set($$$$$)
 			$data .= $indent.&$put("$iterator");
 		};
 
-		$data .= $indent."strncpy(__qmi_alloc_static($iterator), $cname, $iterator);\n";
+		$data .= $indent."strncpy(alloc_static($iterator), $cname, $iterator);\n";
 
 		return $data, 1;
 	};
@@ -453,13 +537,11 @@ sub gen_tlv_attr_set($$)
 
 	$data = <<EOF;
 	if ($cond) {
-		void *buf;
-		unsigned int ofs;
+		struct qmi_arena _arena, *arena = &_arena;
 $iterator$size_var
-		__qmi_alloc_reset();
+		tlv_arena_init(msg, arena);
 $var_data
-		buf = __qmi_get_buf(&ofs);
-		tlv_new(msg, $id, ofs, buf);
+		tlv_arena_finish(msg, $id, arena);
 	}
 
 EOF
@@ -493,6 +575,10 @@ EOF
 
 	print <<EOF;
 	return 0;
+
+error_nomem:
+	fprintf(stderr, "%s: Not enough space in message buffer\\n", __func__);
+	return QMI_ERROR_NO_MEMORY;
 }
 
 EOF
@@ -505,11 +591,13 @@ print <<EOF;
 #include "qmi-message.h"
 
 #define get_next(_size) ({ void *_buf = &tlv->data[ofs]; ofs += _size; if (ofs > cur_tlv_len) goto error_len; _buf; })
+#define alloc_static(_size) ({ void *_ptr = qmi_arena_alloc(arena, _size); if (!_ptr) goto error_nomem; _ptr; })
+#define copy_string(_data, _size) ({ char *_ptr = qmi_arena_strdup(arena, _data, _size); if (!_ptr) goto error_nomem; _ptr; })
 #define copy_tlv(_val, _size) \\
 	do { \\
 		unsigned int __size = _size; \\
 		if (__size > 0) \\
-			memcpy(__qmi_alloc_static(__size), _val, __size); \\
+			memcpy(alloc_static(__size), _val, __size); \\
 	} while (0);
 
 #define put_tlv_var(_type, _val, _size) \\
@@ -520,4 +608,4 @@ print <<EOF;
 
 EOF
 
-gen_foreach_message_type($data, \&gen_set_func, \&gen_parse_func, \&gen_parse_ind_func);
+gen_foreach_message_type($data, \&gen_set_func, \&gen_parse_func, \&gen_parse_func);
@@ -97,6 +97,20 @@ sub gen_has_types($) {
 	return undef
 }
 
+sub gen_view_fields($)
+{
+	my $data = shift;
+	my @fields;
+
+	foreach my $field (@$data) {
+		$field = gen_common_ref($field);
+		$field->{"format"} or next;
+		push @fields, $field;
+	}
+
+	return @fields;
+}
+
 sub gen_tlv_set_func($$) {
 	my $name = shift;
 	my $data = shift;
@@ -121,6 +135,131 @@ sub gen_tlv_parse_func($$) {
 	}
 }
 
+sub gen_tlv_parse_arena_func($$) {
+	my $name = shift;
+	my $data = shift;
+
+	gen_has_types($data) or return undef;
+
+	$name = gen_cname($name);
+	return "int qmi_parse_$name\_arena(struct qmi_msg *msg, struct qmi_$name *res, struct qmi_arena *arena)"
+}
+
+sub gen_tlv_view_func($$) {
+	my $name = shift;
+	my $data = shift;
+
+	gen_has_types($data) or return undef;
+
+	$name = gen_cname($name);
+	return "int qmi_view_$name(struct qmi_msg *msg, struct qmi_$name\_view *view)"
+}
+
+sub gen_tlv_view_field_func($$) {
+	my $name = shift;
+	my $field = shift;
+
+	$name = gen_cname($name);
+	return "int qmi_view_$name\_$field(struct qmi_$name\_view *view, struct qmi_$name *res, struct qmi_arena *arena)"
+}
+
+# wire size of an element, undef if it depends on the data
+sub gen_fixed_size($);
+sub gen_fixed_size($) {
+	my $elem = shift;
+	my $type = $elem->{"format"};
+	my %size = (
+		gint8 => 1, guint8 => 1,
+		gint16 => 2, guint16 => 2,
+		gint32 => 4, guint32 => 4, gfloat => 4,
+		gint64 => 8, guint64 => 8,
+	);
+
+	$size{$type} and return $size{$type};
+	$type eq "guint-sized" and return $elem->{"guint-size"};
+	$type eq "string" and return $elem->{"fixed-size"};
+	$type eq "array" and do {
+		$elem->{"fixed-size"} or return undef;
+		my $sub = gen_fixed_size($elem->{"array-element"});
+		defined $sub or return undef;
+		return $elem->{"fixed-size"} * $sub;
+	};
+	($type eq "struct" or $type eq "sequence") and do {
+		my $total = 0;
+
+		foreach my $field (@{$elem->{contents}}) {
+			my $sub = gen_fixed_size(gen_common_ref($field));
+			defined $sub or return undef;
+			$total += $sub;
+		}
+		return $total;
+	};
+	return undef;
+}
+
+# Counted arrays that can be decoded one element at a time: a TLV that is
+# an array, or an array member of a TLV struct behind fixed size members.
+# Returns [ TLV index, field, C path below res->data, array, byte offset ]
+sub gen_view_iters($) {
+	my $data = shift;
+	my @iters;
+	my $idx = 0;
+
+	my $is_counted = sub {
+		my $elem = shift;
+
+		$elem->{"format"} eq "array" or return 0;
+		$elem->{"fixed-size"} and return 0;
+		# arrays of counted arrays have no element type of their own
+		$elem->{"array-element"}{"format"} eq "array" and
+			not $elem->{"array-element"}{"fixed-size"} and return 0;
+		return 1;
+	};
+
+	foreach my $field (gen_view_fields($data)) {
+		my $cname = gen_cname($field->{name});
+		my $type = $field->{"format"};
+
+		if (&$is_counted($field)) {
+			push @iters, [ $idx, $field, $cname, $field, 0 ];
+		} elsif ($type eq "struct" or $type eq "sequence") {
+			my $ofs = 0;
+
+			foreach my $member (@{$field->{contents}}) {
+				$member = gen_common_ref($member);
+				&$is_counted($member) and
+					push @iters, [ $idx, $field, "$cname.".gen_cname($member->{name}), $member, $ofs ];
+
+				my $size = gen_fixed_size($member);
+				defined $size or last;
+				$ofs += $size;
+			}
+		}
+		$idx++;
+	}
+
+	return @iters;
+}
+
+sub gen_tlv_view_iter_func($$) {
+	my $name = shift;
+	my $path = shift;
+
+	$name = gen_cname($name);
+	$path =~ s/\./_/g;
+	return "int qmi_view_$name\_$path\_iter(struct qmi_$name\_view *view, struct qmi_tlv_iter *iter)"
+}
+
+sub gen_tlv_view_next_func($$) {
+	my $name = shift;
+	my $path = shift;
+
+	$name = gen_cname($name);
+	my $func = $path;
+	$func =~ s/\./_/g;
+	return "int qmi_view_$name\_$func\_next(struct qmi_tlv_iter *iter, typeof(*((struct qmi_$name *) 0)->data.$path) *res, struct qmi_arena *arena)"
+}
+
 sub gen_common_ref($$) {
 	my $field = shift;
 	$field = $common_ref{$field->{'common-ref'}} if $field->{'common-ref'} ne '';
@@ -0,0 +1,169 @@
+use strict;
+
+# Emits the lookup tables for struct qmi_enum_names (see common/utils.h).
+#
+# value -> name: dense enums are indexed directly by (value - min), sparse
+# ones through the smallest modulus that maps every value to its own slot.
+# name -> value: a power of two sized table indexed by a seeded FNV-1a hash
+# of the lower case name (with '-' folded to '_'). The unseeded hash picks
+# the seed out of name_disp, which is chosen so that no two names collide.
+
+sub enum_name_hash($$) {
+	my $name = lc shift;
+	my $h = shift;
+
+	$name =~ tr/-/_/;
+	$h ^= 2166136261;
+	foreach my $c (unpack("C*", $name)) {
+		$h ^= $c;
+		$h = ($h * 16777619) & 0xffffffff;
+	}
+	# the low bits only depend on the low bits of the seed otherwise
+	return $h ^ ($h >> 16);
+}
+
+sub enum_value_slots($) {
+	my $values = shift;
+	my ($min, $max);
+
+	foreach my $v (@$values) {
+		defined $min and $v >= $min or $min = $v;
+		defined $max and $v <= $max or $max = $v;
+	}
+
+	my $n = @$values;
+	my $range = $max - $min + 1;
+	$range <= 2 * $n + 8 and return (0, $min, $range);
+
+	for (my $mod = $n; $mod < 16 * $n + 64 && $mod < 65536; $mod++) {
+		my %used;
+		my $ok = 1;
+
+		foreach my $v (@$values) {
+			my $slot = ($v & 0xffffffff) % $mod;
+			$used{$slot}++ and do {
+				$ok = 0;
+				last;
+			};
+		}
+		$ok and return (1, 0, $mod);
+	}
+	die "No perfect hash found for the enum values (@$values)\n";
+}
+
+# hash and displace: every bucket of names gets the seed that moves all
+# of its names to free slots
+sub enum_name_slots($) {
+	my $names = shift;
+	my ($size, $n_disp) = (1, 1);
+
+	$size <<= 1 while $size < @$names + @$names / 4;
+	$n_disp <<= 1 while $n_disp < @$names / 4;
+
+	while (1) {
+		my @buckets = map { [] } 1 .. $n_disp;
+		my @disp = (0) x $n_disp;
+		my %used;
+		my $ok = 1;
+
+		foreach my $name (@$names) {
+			push @{$buckets[enum_name_hash($name, 0) & ($n_disp - 1)]}, $name;
+		}
+
+		foreach my $b (sort { @{$buckets[$b]} <=> @{$buckets[$a]} or $a <=> $b } 0 .. $n_disp - 1) {
+			my $bucket = $buckets[$b];
+			my $seed;
+
+			@$bucket or last;
+			SEED: for ($seed = 1; $seed < 65536; $seed++) {
+				my %slots;
+
+				foreach my $name (@$bucket) {
+					my $slot = enum_name_hash($name, $seed) & ($size - 1);
+
+					$used{$slot} and next SEED;
+					$slots{$slot}++ and next SEED;
+				}
+				last;
+			}
+			$seed < 65536 or do {
+				$ok = 0;
+				last;
+			};
+
+			$disp[$b] = $seed;
+			$used{enum_name_hash($_, $seed) & ($size - 1)} = 1 foreach @$bucket;
+		}
+		$ok and return ($size, \@disp);
+		$size <<= 1;
+	}
+}
+
+# $entries: array of [ name, value, C symbol ], the first entry wins for
+# duplicate names or values
+sub gen_enum_table($$$) {
+	my $cname = shift;
+	my $storage = shift;
+	my $entries = shift;
+	my (%seen_value, %seen_name);
+	my (@values, @names);
+	my $out;
+
+	foreach my $entry (@$entries) {
+		$seen_value{$entry->[1]}++ or push @values, $entry->[1];
+		my $key = lc $entry->[0];
+
+		$key =~ tr/-/_/;
+		$seen_name{$key}++ or push @names, $entry->[0];
+	}
+
+	my ($sparse, $min, $value_size) = enum_value_slots(\@values);
+	my ($name_size, $disp) = enum_name_slots(\@names);
+	my @by_value = (0) x $value_size;
+	my @by_name = (0) x $name_size;
+
+	for (my $i = 0; $i < @$entries; $i++) {
+		my ($name, $value) = @{$entries->[$i]};
+		my $slot = $sparse ? ($value & 0xffffffff) % $value_size : $value - $min;
+		my $seed = $disp->[enum_name_hash($name, 0) & (@$disp - 1)];
+		my $name_slot = enum_name_hash($name, $seed) & ($name_size - 1);
+
+		$by_value[$slot] or $by_value[$slot] = $i + 1;
+		$by_name[$name_slot] or $by_name[$name_slot] = $i + 1;
+	}
+
+	$out = "static const struct qmi_enum_entry $cname\_entries[] = {\n";
+	foreach my $entry (@$entries) {
+		$out .= "\t{ \"$entry->[0]\", ".($entry->[2] // $entry->[1])." },\n";
+	}
+	$out .= "};\n\n";
+
+	foreach my $table ([ "by_value", \@by_value ], [ "by_name", \@by_name ], [ "name_disp", $disp ]) {
+		my @vals = @{$table->[1]};
+
+		$out .= "static const uint16_t $cname\_$table->[0]\[] = {";
+		for (my $i = 0; $i < @vals; $i++) {
+			$out .= ($i % 16) ? " " : "\n\t";
+			$out .= "$vals[$i],";
+		}
+		$out .= "\n};\n\n";
+	}
+
+	$out .= <<EOF;
+${storage}const struct qmi_enum_names $cname = {
+	.entries = $cname\_entries,
+	.by_value = $cname\_by_value,
+	.by_name = $cname\_by_name,
+	.name_disp = $cname\_name_disp,
+	.min = $min,
+	.value_size = $value_size,
+	.name_mask = @{[ $name_size - 1 ]},
+	.disp_mask = @{[ @$disp - 1 ]},
+	.sparse = $sparse,
+};
+
+EOF
+	return $out;
+}
+
+1;
@@ -0,0 +1,116 @@
+#!/usr/bin/env perl
+use strict;
+
+use FindBin '$Bin';
+require "$Bin/gen-enum-common.pm";
+
+@ARGV < 2 and die "Usage: $0 <header|code> <qmi-enums-*.h>...\n";
+my $mode = shift @ARGV;
+my @enums;
+
+sub enum_cname($) {
+	my $name = shift;
+
+	$name =~ s/([a-z0-9])([A-Z])/$1_$2/g;
+	return lc $name;
+}
+
+# the part of the value names shared by all values of the enum:
+# QMI_NAS_RADIO_INTERFACE_LTE -> lte
+sub enum_prefix($$) {
+	my $type = shift;
+	my $values = shift;
+	my $prefix = uc(enum_cname($type))."_";
+
+	grep { index($_->[0], $prefix) != 0 or length($_->[0]) == length($prefix) } @$values or return $prefix;
+
+	my @common = split /_/, $values->[0][0];
+	foreach my $val (@$values) {
+		my @parts = split /_/, $val->[0];
+		my $i = 0;
+
+		$i++ while $i < @common && $i < @parts - 1 && $common[$i] eq $parts[$i];
+		splice @common, $i;
+	}
+	return join("_", @common)."_";
+}
+
+sub enum_value($$) {
+	my $expr = shift;
+	my $known = shift;
+
+	$expr =~ s/\b([A-Z]\w*)\b/exists $known->{$1} ? "($known->{$1})" : die "Unknown symbol $1\n"/ge;
+	$expr =~ /^[\s0-9a-fA-Fx()<|+\-]*$/ or die "Cannot evaluate '$expr'\n";
+
+	my $val = eval $expr;
+	defined $val or die "Cannot evaluate '$expr'\n";
+	return $val;
+}
+
+foreach my $file (@ARGV) {
+	my (%known, @values);
+	my $in_enum;
+	my $next = 0;
+
+	open my $fh, '<', $file or die "Cannot open $file\n";
+	while (my $line = <$fh>) {
+		$line =~ s/\/\*.*?\*\///g;
+		$line =~ /^typedef\s+enum\b/ and do {
+			$in_enum = 1;
+			@values = ();
+			$next = 0;
+			next;
+		};
+		$in_enum or next;
+
+		$line =~ /^\s*}\s*(\w+)\s*;/ and do {
+			my $prefix = enum_prefix($1, \@values);
+
+			foreach my $val (@values) {
+				$val->[2] = $val->[0];
+				$val->[0] = lc substr($val->[0], length($prefix));
+			}
+			push @enums, [ $1, [ @values ] ];
+			undef $in_enum;
+			next;
+		};
+
+		$line =~ /^\s*([A-Z]\w*)\s*(?:=\s*([^,]+?))?\s*,?\s*$/ or next;
+		my ($name, $expr) = ($1, $2);
+		my $val = defined $expr ? enum_value($expr, \%known) : $next;
+
+		$val >= -2147483648 && $val <= 2147483647 or die "Value of $name out of range\n";
+		$known{$name} = $val;
+		$next = $val + 1;
+		push @values, [ $name, $val ];
+	}
+	close $fh;
+}
+
+if ($mode eq "header") {
+	print <<EOF;
+/* generated by uqmi gen-enum-list.pl */
+#ifndef __QMI_ENUM_NAMES_H
+#define __QMI_ENUM_NAMES_H
+
+struct qmi_enum_names;
+
+EOF
+	foreach my $enum (@enums) {
+		print "extern const struct qmi_enum_names ".enum_cname($enum->[0])."_names;\n";
+	}
+	print "\n#endif\n";
+} elsif ($mode eq "code") {
+	print <<EOF;
+/* generated by uqmi gen-enum-list.pl */
+#include <stdint.h>
+#include "qmi-message.h"
+#include "utils.h"
+
+EOF
+	foreach my $enum (@enums) {
+		print gen_enum_table(enum_cname($enum->[0])."_names", "", $enum->[1]);
+	}
+} else {
+	die "Unknown mode $mode\n";
+}
@@ -1,9 +1,14 @@
 #!/usr/bin/env perl
 use strict;
+
+use FindBin '$Bin';
+require "$Bin/gen-enum-common.pm";
+
 my $doc_start;
 my $error_data;
 my $line;
 my @errors;
+my %values;
 
 while ($line = <>) {
 	chomp $line;
@@ -22,20 +27,15 @@ while ($line = <>) {
 	};
 	undef $doc_start;
 
-	$line =~ /^.*@([A-Z0-9_]+): ([A-z0-9 ]+)[.].*$/ and push @errors, [ $1, $2 ];
+	$line =~ /^\s*(QMI_PROTOCOL_ERROR_[A-Z0-9_]+)\s*=\s*(\d+)/ and $values{$1} = $2;
+	$error_data and $line =~ /^.*@([A-Z0-9_]+): ([A-z0-9 ]+)[.].*$/ and push @errors, [ $2, undef, $1 ];
 }
 
 @errors > 0 or die "No data found\n";
 
-print <<EOF;
-static const struct {
-	QmiProtocolError code;
-	const char *text;
-} qmi_errors[] = {
-EOF
 foreach my $error (@errors) {
-	print "\t{ ".$error->[0].", \"".$error->[1]."\" },\n";
+	$error->[1] = $values{$error->[2]};
+	defined $error->[1] or die "No value for $error->[2]\n";
 }
-print <<EOF;
-};
-EOF
+
+print gen_enum_table("qmi_errors", "static ", \@errors);
@@ -97,6 +97,23 @@ struct qmi_$name {
 EOF
 }
 
+sub gen_view_struct($$) {
+	my $name = shift;
+	my $data = shift;
+
+	gen_has_types($data) or return;
+
+	my $n_fields = scalar gen_view_fields($data);
+	$name = gen_cname($name);
+
+	print <<EOF
+struct qmi_$name\_view {
+	struct tlv *tlv[$n_fields];
+};
+
+EOF
+}
+
 sub gen_set_func_header($$)
 {
 	my $name = shift;
@@ -112,8 +129,23 @@ sub gen_parse_func_header($$)
 	my $data = shift;
 
 	my $func = gen_tlv_parse_func($name, $data);
+	my $arena_func = gen_tlv_parse_arena_func($name, $data);
+	my $view_func = gen_tlv_view_func($name, $data);
+
+	$view_func and do {
+		print "$view_func;\n";
+		foreach my $field (gen_view_fields($data)) {
+			print gen_tlv_view_field_func($name, gen_cname($field->{name})).";\n";
+		}
+		foreach my $iter (gen_view_iters($data)) {
+			print gen_tlv_view_iter_func($name, $iter->[2]).";\n";
+			print gen_tlv_view_next_func($name, $iter->[2]).";\n";
+		}
+	};
+	$arena_func and print "$arena_func;\n";
 	$func and print "$func;\n\n";
 }
 
 gen_foreach_message_type($data, \&gen_tlv_struct, \&gen_tlv_struct, \&gen_tlv_struct);
+gen_foreach_message_type($data, sub {}, \&gen_view_struct, \&gen_view_struct);
 gen_foreach_message_type($data, \&gen_set_func_header, \&gen_parse_func_header, \&gen_parse_func_header);
@@ -0,0 +1,800 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Simulated QMI modem on a pseudo terminal, which uqmi -d and the uqmid
+ * add_modem call can open like a /dev/cdc-wdm device.
+ *
+ * Responses and indications are replayed from a script: either a text file
+ * with one QMUX frame in hex per line (the qmi-bench corpus format, or
+ * DEBUG_PACKET output) or a pcapng file written with --capture. Requests in
+ * the script are ignored. A request is answered with the next response
+ * frame for the same service and message, taking turns if there are
+ * several, with the transaction and client id of the request filled in.
+ * Client ids are handed out by the simulator itself, and requests without
+ * a scripted response get QMI_PROTOCOL_ERROR_NOT_SUPPORTED.
+ */
+
+#define _GNU_SOURCE
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <libubox/uloop.h>
+#include <libubox/ustream.h>
+#include <libubox/utils.h>
+
+#include "qmi-message.h"
+#include "qmi-errors.h"
+#include "mbim.h"
+#include "utils.h"
+
+#define SIM_CTL_GET_VERSION_INFO	0x0021
+#define SIM_CTL_ALLOCATE_CID		0x0022
+#define SIM_CTL_RELEASE_CID		0x0023
+
+#define SIM_TLV_RESULT			0x02
+
+#define MBIM_MESSAGE_TYPE_INDICATE_STATUS	0x80000007
+
+struct sim_frame {
+	/* service << 16 | message */
+	uint32_t key;
+	unsigned int idx;
+	/* turn among the frames with the same key, kept in the first one */
+	unsigned int next;
+	int len;
+	struct qmi_msg *msg;
+};
+
+struct sim_frames {
+	struct sim_frame *frames;
+	int n;
+};
+
+struct sim_delayed {
+	struct uloop_timeout timeout;
+	uint32_t tid;
+	int len;
+	char data[];
+};
+
+struct sim_stats {
+	unsigned int requests;
+	unsigned int responses;
+	unsigned int unsupported;
+	unsigned int dropped;
+	unsigned int indications;
+};
+
+static struct sim_frames responses, indications;
+static struct sim_stats stats;
+
+static struct ustream_fd sim_fd;
+static char *rx_buf;
+static int rx_buf_len;
+
+static bool is_mbim;
+static int latency;
+static int drop_rate;
+static int ind_count, ind_interval;
+static unsigned int ind_next;
+
+static uint8_t client_ids[256];
+
+static union {
+	char buf[QMI_MSG_MAX_LEN];
+	struct qmi_msg msg;
+} txbuf;
+
+static int sim_hex_val(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+
+	c = tolower(c);
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+
+	return -1;
+}
+
+static int sim_parse_hex(const char *str, char *buf, int len)
+{
+	int n = 0;
+
+	while (*str) {
+		int hi, lo;
+
+		if (isspace(*str)) {
+			str++;
+			continue;
+		}
+
+		hi = sim_hex_val(str[0]);
+		lo = sim_hex_val(str[1]);
+		if (n >= len || hi < 0 || lo < 0)
+			return -1;
+
+		buf[n++] = (hi << 4) | lo;
+		str += 2;
+	}
+
+	return n;
+}
+
+static uint16_t sim_msg_id(struct qmi_msg *msg)
+{
+	if (msg->qmux.service == QMI_SERVICE_CTL)
+		return le16_to_cpu(msg->ctl.message);
+
+	return le16_to_cpu(msg->svc.message);
+}
+
+static bool sim_msg_valid(const void *data, int len)
+{
+	const struct qmi_msg *msg = data;
+
+	if (len < (int) offsetof(struct qmi_msg, svc.tlv))
+		return false;
+
+	return msg->marker == 1 && len == le16_to_cpu(msg->qmux.len) + 1;
+}
+
+static int sim_add_frame(const void *data, int len)
+{
+	struct sim_frames *list;
+	struct sim_frame *f;
+	struct qmi_msg *msg;
+	uint8_t resp_flag, ind_flag;
+
+	if (!sim_msg_valid(data, len))
+		return -1;
+
+	msg = malloc(len);
+	if (!msg)
+		return -1;
+
+	memcpy(msg, data, len);
+	if (msg->qmux.service == QMI_SERVICE_CTL) {
+		resp_flag = QMI_CTL_FLAG_RESPONSE;
+		ind_flag = QMI_CTL_FLAG_INDICATION;
+	} else {
+		resp_flag = QMI_SERVICE_FLAG_RESPONSE;
+		ind_flag = QMI_SERVICE_FLAG_INDICATION;
+	}
+
+	if (msg->flags & ind_flag) {
+		list = &indications;
+	} else if (msg->flags & resp_flag) {
+		list = &responses;
+	} else {
+		/* requests of a capture */
+		free(msg);
+		return 0;
+	}
+
+	f = realloc(list->frames, (list->n + 1) * sizeof(*f));
+	if (!f) {
+		free(msg);
+		return -1;
+	}
+
+	list->frames = f;
+	f = &f[list->n];
+	f->key = (msg->qmux.service << 16) | sim_msg_id(msg);
+	f->idx = list->n++;
+	f->next = 0;
+	f->len = len;
+	f->msg = msg;
+
+	return 0;
+}
+
+static int sim_load_pcapng(FILE *f)
+{
+	struct {
+		uint32_t type;
+		uint32_t len;
+	} hdr;
+	uint32_t *block;
+	int n = 0;
+
+	while (fread(&hdr, sizeof(hdr), 1, f) == 1) {
+		if (hdr.len < 12 || hdr.len % 4 || hdr.len > 2 * QMI_MSG_MAX_LEN)
+			return -1;
+
+		block = malloc(hdr.len);
+		if (!block)
+			return -1;
+
+		if (fread(block + 2, hdr.len - sizeof(hdr), 1, f) != 1) {
+			free(block);
+			return -1;
+		}
+
+		/* enhanced packet block: if_id, ts_high, ts_low, cap_len, len */
+		if (hdr.type == 6 && hdr.len >= 28 && block[5] <= hdr.len - 28 &&
+		    sim_add_frame(&block[7], block[5]))
+			fprintf(stderr, "Skipping invalid frame %d\n", n);
+
+		if (hdr.type == 6)
+			n++;
+
+		free(block);
+	}
+
+	return 0;
+}
+
+static int sim_load_text(FILE *f)
+{
+	char *line = NULL, *hex, *p;
+	size_t line_len = 0;
+	int lineno = 0;
+	int len;
+
+	while (getline(&line, &line_len, f) > 0) {
+		lineno++;
+
+		hex = line + strspn(line, " \t\n");
+		if (!*hex || *hex == '#')
+			continue;
+
+		/* skip the message name or DEBUG_PACKET prefix */
+		for (p = hex; *p; p++)
+			if (!isspace(*p) && sim_hex_val(*p) < 0)
+				hex = p + strcspn(p, " \t\n");
+
+		len = sim_parse_hex(hex, txbuf.buf, sizeof(txbuf.buf));
+		if (len < 0 || sim_add_frame(txbuf.buf, len))
+			fprintf(stderr, "Skipping invalid frame on line %d\n", lineno);
+	}
+
+	free(line);
+
+	return 0;
+}
+
+static int sim_frame_cmp(const void *a, const void *b)
+{
+	const struct sim_frame *fa = a, *fb = b;
+
+	if (fa->key != fb->key)
+		return fa->key < fb->key ? -1 : 1;
+
+	return (int) fa->idx - (int) fb->idx;
+}
+
+static int sim_load_script(const char *file)
+{
+	uint32_t magic;
+	int ret;
+	FILE *f;
+
+	f = fopen(file, "r");
+	if (!f) {
+		fprintf(stderr, "Failed to open script %s\n", file);
+		return -1;
+	}
+
+	if (fread(&magic, sizeof(magic), 1, f) == 1 && magic == 0x0a0d0d0a) {
+		rewind(f);
+		ret = sim_load_pcapng(f);
+	} else {
+		rewind(f);
+		ret = sim_load_text(f);
+	}
+	fclose(f);
+
+	if (ret) {
+		fprintf(stderr, "Failed to read script %s\n", file);
+		return -1;
+	}
+
+	qsort(responses.frames, responses.n, sizeof(*responses.frames), sim_frame_cmp);
+
+	return 0;
+}
+
+static struct sim_frame *sim_lookup(uint32_t key)
+{
+	int lo = 0, hi = responses.n;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (responses.frames[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == responses.n || responses.frames[lo].key != key)
+		return NULL;
+
+	return &responses.frames[lo];
+}
+
+static struct sim_frame *sim_find_response(uint32_t key)
+{
+	struct sim_frame *first, *f;
+
+	first = sim_lookup(key);
+	if (!first)
+		return NULL;
+
+	f = first + first->next++;
+	if (f + 1 == &responses.frames[responses.n] || f[1].key != key)
+		first->next = 0;
+
+	return f;
+}
+
+/* tid is the MBIM transaction of the request, 0 for indications */
+static void sim_write(const void *data, int len, uint32_t tid)
+{
+	struct mbim_command_message mbim;
+	struct iovec iov[2];
+	int iovcnt = 0;
+
+	if (is_mbim) {
+		mbim_qmi_cmd(&mbim, len, 0);
+		if (!tid) {
+			/* no status field, the indication data starts right behind the cid */
+			mbim.header.type = cpu_to_le32(MBIM_MESSAGE_TYPE_INDICATE_STATUS);
+			mbim.header.length = cpu_to_le32(sizeof(mbim) - 4 + len);
+			mbim.command_type = cpu_to_le32(len);
+			iov[iovcnt].iov_len = sizeof(mbim) - 4;
+		} else {
+			mbim.header.type = cpu_to_le32(MBIM_MESSAGE_TYPE_COMMAND_DONE);
+			mbim.header.transaction_id = tid;
+			mbim.command_type = 0;
+			iov[iovcnt].iov_len = sizeof(mbim);
+		}
+		iov[iovcnt++].iov_base = &mbim;
+	}
+
+	iov[iovcnt].iov_base = (void *) data;
+	iov[iovcnt++].iov_len = len;
+	ustream_fd_writev(&sim_fd, iov, iovcnt);
+}
+
+static void sim_delayed_cb(struct uloop_timeout *t)
+{
+	struct sim_delayed *d = container_of(t, struct sim_delayed, timeout);
+
+	sim_write(d->data, d->len, d->tid);
+	free(d);
+}
+
+static void sim_send(struct qmi_msg *msg, int len, uint32_t tid)
+{
+	struct sim_delayed *d;
+
+	if (drop_rate && random() % 100 < drop_rate) {
+		stats.dropped++;
+		return;
+	}
+
+	stats.responses++;
+	if (!latency) {
+		sim_write(msg, len, tid);
+		return;
+	}
+
+	d = malloc(sizeof(*d) + len);
+	if (!d)
+		return;
+
+	memset(&d->timeout, 0, sizeof(d->timeout));
+	d->timeout.cb = sim_delayed_cb;
+	d->tid = tid;
+	d->len = len;
+	memcpy(d->data, msg, len);
+	uloop_timeout_set(&d->timeout, latency);
+}
+
+static void sim_init_response(struct qmi_msg *msg, struct qmi_msg *req)
+{
+	qmi_init_request_message(msg, req->qmux.service);
+	msg->qmux.flags = 0x80;
+	msg->qmux.client = req->qmux.client;
+	if (req->qmux.service == QMI_SERVICE_CTL) {
+		msg->flags = QMI_CTL_FLAG_RESPONSE;
+		msg->ctl.transaction = req->ctl.transaction;
+		msg->ctl.message = req->ctl.message;
+	} else {
+		msg->flags = QMI_SERVICE_FLAG_RESPONSE;
+		msg->svc.transaction = req->svc.transaction;
+		msg->svc.message = req->svc.message;
+	}
+}
+
+static void sim_add_result(struct qmi_msg *msg, uint16_t error)
+{
+	struct {
+		uint16_t status;
+		uint16_t error;
+	} __packed result = {
+		.status = cpu_to_le16(!!error),
+		.error = cpu_to_le16(error),
+	};
+
+	tlv_new(msg, SIM_TLV_RESULT, sizeof(result), &result);
+}
+
+/* every service the script knows about, as version 1.0 */
+static void sim_ctl_version_info(struct qmi_msg *msg)
+{
+	uint8_t list[1 + 256 * 5], *p = &list[1];
+	int i, n = 0;
+
+	for (i = 0; i < responses.n; i++) {
+		uint8_t svc = responses.frames[i].key >> 16;
+
+		if (n && p[-5] == svc)
+			continue;
+
+		*p++ = svc;
+		*p++ = 1;
+		*p++ = 0;
+		*p++ = 0;
+		*p++ = 0;
+		n++;
+	}
+
+	list[0] = n;
+	sim_add_result(msg, 0);
+	tlv_new(msg, 0x01, p - list, list);
+}
+
+/* CTL requests the script does not need to cover */
+static bool sim_ctl_request(struct qmi_msg *msg, struct qmi_msg *req)
+{
+	struct {
+		uint8_t service;
+		uint8_t cid;
+	} __packed alloc;
+	unsigned int len;
+	struct tlv *tlv;
+	void *buf;
+	int tlv_len;
+
+	buf = qmi_msg_get_tlv_buf(req, &tlv_len);
+	len = tlv_len;
+	tlv = tlv_get_next(&buf, &len);
+
+	switch (le16_to_cpu(req->ctl.message)) {
+	case SIM_CTL_ALLOCATE_CID:
+		if (!tlv || tlv_data_len(tlv) < 1)
+			return false;
+
+		alloc.service = tlv->data[0];
+		alloc.cid = ++client_ids[alloc.service];
+		sim_add_result(msg, 0);
+		tlv_new(msg, 0x01, sizeof(alloc), &alloc);
+		return true;
+	case SIM_CTL_RELEASE_CID:
+		if (!tlv || tlv_data_len(tlv) < sizeof(alloc))
+			return false;
+
+		sim_add_result(msg, 0);
+		tlv_new(msg, 0x01, sizeof(alloc), tlv->data);
+		return true;
+	case SIM_CTL_GET_VERSION_INFO:
+		if (sim_lookup((QMI_SERVICE_CTL << 16) | SIM_CTL_GET_VERSION_INFO))
+			return false;
+
+		sim_ctl_version_info(msg);
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void sim_request(struct qmi_msg *req, uint32_t tid)
+{
+	struct qmi_msg *msg = &txbuf.msg;
+	struct sim_frame *f;
+	uint32_t key;
+
+	stats.requests++;
+	sim_init_response(msg, req);
+
+	key = (req->qmux.service << 16) | sim_msg_id(req);
+	if (req->qmux.service == QMI_SERVICE_CTL && sim_ctl_request(msg, req)) {
+		sim_send(msg, qmi_complete_request_message(msg), tid);
+		return;
+	}
+
+	f = sim_find_response(key);
+	if (!f) {
+		stats.unsupported++;
+		sim_add_result(msg, QMI_PROTOCOL_ERROR_NOT_SUPPORTED);
+		sim_send(msg, qmi_complete_request_message(msg), tid);
+		return;
+	}
+
+	memcpy(msg, f->msg, f->len);
+	msg->qmux.client = req->qmux.client;
+	if (req->qmux.service == QMI_SERVICE_CTL)
+		msg->ctl.transaction = req->ctl.transaction;
+	else
+		msg->svc.transaction = req->svc.transaction;
+
+	sim_send(msg, f->len, tid);
+}
+
+static void sim_indication_cb(struct uloop_timeout *t)
+{
+	struct qmi_msg *msg = &txbuf.msg;
+	struct sim_frame *f;
+	int i;
+
+	for (i = 0; i < ind_count; i++) {
+		f = &indications.frames[ind_next++ % indications.n];
+		memcpy(msg, f->msg, f->len);
+
+		/* address the client that got the last id for the service */
+		if (client_ids[msg->qmux.service])
+			msg->qmux.client = client_ids[msg->qmux.service];
+
+		stats.indications++;
+		sim_write(msg, f->len, 0);
+	}
+
+	uloop_timeout_set(t, ind_interval);
+}
+
+static struct uloop_timeout ind_timer = { .cb = sim_indication_cb };
+
+static void sim_notify_read(struct ustream *us, int bytes)
+{
+	struct mbim_command_message ref;
+	struct qmi_msg *msg;
+	uint32_t tid = 0;
+	char *buf;
+	int len, msg_len, hdr_len = 0;
+
+	while (1) {
+		len = is_mbim ? sizeof(struct mbim_command_message) :
+				offsetof(struct qmi_msg, flags);
+		buf = ustream_get_read_buf_len(us, len, &rx_buf, &rx_buf_len);
+		if (!buf)
+			return;
+
+		if (is_mbim) {
+			struct mbim_command_message *mbim = (void *) buf;
+
+			msg_len = le32_to_cpu(mbim->header.length);
+			mbim_qmi_cmd(&ref, 0, 0);
+			if (mbim->header.type != cpu_to_le32(MBIM_MESSAGE_TYPE_COMMAND) ||
+			    memcmp(mbim->service_id, ref.service_id, sizeof(ref.service_id))) {
+				/* open, close and other services are not simulated */
+				ustream_consume(us, msg_len);
+				continue;
+			}
+			hdr_len = sizeof(struct mbim_command_message);
+			tid = mbim->header.transaction_id;
+		} else {
+			msg = (struct qmi_msg *) buf;
+			msg_len = le16_to_cpu(msg->qmux.len) + 1;
+		}
+
+		buf = ustream_get_read_buf_len(us, msg_len, &rx_buf, &rx_buf_len);
+		if (!buf)
+			return;
+
+		if (sim_msg_valid(buf + hdr_len, msg_len - hdr_len))
+			sim_request((struct qmi_msg *) (buf + hdr_len), tid);
+
+		ustream_consume(us, msg_len);
+	}
+}
+
+static void sim_notify_state(struct ustream *us)
+{
+	if (us->eof || us->write_error)
+		uloop_end();
+}
+
+static int sim_open_pty(const char *link)
+{
+	struct termios tio;
+	const char *name;
+	int fd, slave;
+
+	fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (fd < 0 || grantpt(fd) || unlockpt(fd) || !(name = ptsname(fd))) {
+		fprintf(stderr, "Failed to create pty: %s\n", strerror(errno));
+		return -1;
+	}
+
+	/*
+	 * Keep the slave side open, so that the master does not see a hangup
+	 * whenever a client closes it, and switch it to raw mode.
+	 */
+	slave = open(name, O_RDWR | O_NOCTTY);
+	if (slave < 0 || tcgetattr(slave, &tio)) {
+		fprintf(stderr, "Failed to open %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+
+	cfmakeraw(&tio);
+	tcsetattr(slave, TCSANOW, &tio);
+
+	if (link) {
+		unlink(link);
+		if (symlink(name, link)) {
+			fprintf(stderr, "Failed to create %s: %s\n", link, strerror(errno));
+			return -1;
+		}
+		name = link;
+	}
+
+	setenv("QMI_SIM_DEVICE", name, 1);
+	sim_fd.stream.notify_read = sim_notify_read;
+	sim_fd.stream.notify_state = sim_notify_state;
+	ustream_fd_init_len(&sim_fd, fd, sizeof(struct mbim_command_message) + QMI_MSG_MAX_LEN);
+
+	return 0;
+}
+
+static int sim_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void sim_print_stats(int msecs)
+{
+	fprintf(stderr, "%u requests in %d ms, %u responses (%u not supported), "
+		"%u dropped, %u indications\n",
+		stats.requests, msecs, stats.responses, stats.unsupported,
+		stats.dropped, stats.indications);
+}
+
+static int exit_status;
+
+static void sim_command_cb(struct uloop_process *p, int ret)
+{
+	exit_status = WIFEXITED(ret) ? WEXITSTATUS(ret) : 1;
+	uloop_end();
+}
+
+static struct uloop_process command_proc = { .cb = sim_command_cb };
+
+static int sim_run_command(const char *cmd)
+{
+	pid_t pid = fork();
+
+	if (pid < 0)
+		return -1;
+
+	if (!pid) {
+		execl("/bin/sh", "sh", "-c", cmd, NULL);
+		_exit(127);
+	}
+
+	command_proc.pid = pid;
+	uloop_process_add(&command_proc);
+
+	return 0;
+}
+
+static void handle_exit_signal(int signal)
+{
+	uloop_end();
+}
+
+static int usage(const char *progname)
+{
+	fprintf(stderr, "Usage: %s [options] [<script>]\n"
+		"Options:\n"
+		"  -m:                               Speak MBIM with EXT_QMUX (like uqmi --mbim)\n"
+		"  -l <link>:                        Create a symlink <link> to the pty\n"
+		"  -d <msecs>:                       Delay every response by <msecs>\n"
+		"  -p <percent>:                     Drop <percent> of the responses\n"
+		"  -i <count>,<msecs>:               Send <count> scripted indications every <msecs>\n"
+		"  -x <command>:                     Run <command> against the simulator and exit with\n"
+		"                                    its status, $QMI_SIM_DEVICE is set to the pty\n"
+		"\n"
+		"The script is a pcapng file written by uqmi --capture, or a text file\n"
+		"with one QMUX frame in hex per line like the qmi-bench corpus.\n"
+		"\n", progname);
+	return 1;
+}
+
+int main(int argc, char **argv)
+{
+	const char *link = NULL, *cmd = NULL;
+	int start, ch;
+
+	while ((ch = getopt(argc, argv, "ml:d:p:i:x:")) != -1) {
+		switch (ch) {
+		case 'm':
+			is_mbim = true;
+			break;
+		case 'l':
+			link = optarg;
+			break;
+		case 'd':
+			latency = atoi(optarg);
+			break;
+		case 'p':
+			drop_rate = atoi(optarg);
+			break;
+		case 'i':
+			if (sscanf(optarg, "%d,%d", &ind_count, &ind_interval) != 2 ||
+			    ind_count <= 0 || ind_interval <= 0)
+				return usage(argv[0]);
+			break;
+		case 'x':
+			cmd = optarg;
+			break;
+		default:
+			return usage(argv[0]);
+		}
+	}
+
+	if (optind < argc && sim_load_script(argv[optind]))
+		return 1;
+
+	uloop_init();
+	signal(SIGINT, handle_exit_signal);
+	signal(SIGTERM, handle_exit_signal);
+	srandom(time(NULL));
+
+	if (sim_open_pty(link))
+		return 1;
+
+	if (ind_count && indications.n)
+		uloop_timeout_set(&ind_timer, ind_interval);
+
+	if (cmd) {
+		if (sim_run_command(cmd))
+			return 1;
+	} else {
+		printf("%s\n", getenv("QMI_SIM_DEVICE"));
+		fflush(stdout);
+	}
+
+	start = sim_time();
+	uloop_run();
+	sim_print_stats(sim_time() - start);
+
+	if (link)
+		unlink(link);
+
+	return exit_status;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+# Runs commands on two simulated modems at once, both have to end up with
+# the same result.
+# Usage: test-devices.sh <qmi-sim> <uqmi>
+
+SIM="$1"
+UQMI="$2"
+
+dir=$(mktemp -d) || exit 1
+"$SIM" -l "$dir/a" >/dev/null 2>&1 &
+pids=$!
+"$SIM" -l "$dir/b" >/dev/null 2>&1 &
+pids="$pids $!"
+trap 'kill $pids 2>/dev/null; rm -rf "$dir"' EXIT
+
+i=0
+while [ ! -e "$dir/a" ] || [ ! -e "$dir/b" ]; do
+	i=$((i + 1))
+	[ $i -lt 50 ] || { echo "qmi-sim did not come up" >&2; exit 1; }
+	sleep 0.1
+done
+
+fail=0
+
+# every device prints the same lines, tagged with its name
+check() {
+	out=$("$UQMI" -t 2000 -d "$dir/a" -d "$dir/b" "$@")
+	a=$(echo "$out" | grep "^{\"device\":\"$dir/a\"" | sed 's/^{"device":"[^"]*"//')
+	b=$(echo "$out" | grep "^{\"device\":\"$dir/b\"" | sed 's/^{"device":"[^"]*"//')
+
+	if [ -z "$a" ] || [ "$a" != "$b" ]; then
+		echo "FAIL: $*" >&2
+		echo "$out" >&2
+		fail=1
+	fi
+}
+
+# the arguments are cut up by the parsers
+check --get-profile-settings 3gpp,1
+check --set-client-id wds,1 --get-current-settings
+
+exit $fail
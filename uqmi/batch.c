@@ -0,0 +1,332 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * uqmi --batch runs one line of actions after the other on the already
+ * opened device and its client IDs. A line holds the arguments of a uqmi
+ * call, words may be quoted with ' or ", and the leading -- of the long
+ * options can be left out:
+ *
+ *   get-signal-info
+ *   set-client-id wds,12 --get-data-status
+ *   # comment
+ *
+ * Whatever input is at hand (up to BATCH_MAX_LINES lines) is parsed before
+ * it is run, so that queries on consecutive lines go out together. The
+ * results are printed as one JSON object per action and line.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "uqmi.h"
+#include "commands.h"
+
+#define BATCH_BUF_LEN		4096
+#define BATCH_MAX_LINES		256
+#define BATCH_MAX_ARGS		64
+
+struct batch_input {
+	int fd;
+	bool eof;
+	/* the rest of an overlong line is skipped */
+	bool skip;
+	int ofs, len;
+	char buf[BATCH_BUF_LEN + 1];
+};
+
+static bool batch_input_ready(struct batch_input *in, bool wait)
+{
+	struct pollfd pfd = { .fd = in->fd, .events = POLLIN };
+
+	return poll(&pfd, 1, wait ? -1 : 0) > 0;
+}
+
+/*
+ * Returns the next line, NULL at the end of the input or, unless wait is
+ * set, when no complete line is available yet. Overlong lines come back
+ * as an empty string with *error set.
+ */
+static char *batch_read_line(struct batch_input *in, bool wait, bool *error)
+{
+	char *line, *nl;
+	int len;
+
+	*error = false;
+	while (1) {
+		line = in->buf + in->ofs;
+		nl = memchr(line, '\n', in->len - in->ofs);
+		if (nl || (in->eof && in->ofs < in->len)) {
+			if (!nl)
+				nl = in->buf + in->len;
+
+			*nl = 0;
+			in->ofs = nl + 1 - in->buf;
+			if (in->ofs > in->len)
+				in->ofs = in->len;
+
+			if (in->skip) {
+				in->skip = false;
+				continue;
+			}
+
+			return line;
+		}
+
+		if (in->eof)
+			return NULL;
+
+		memmove(in->buf, line, in->len - in->ofs);
+		in->len -= in->ofs;
+		in->ofs = 0;
+
+		if (in->len == BATCH_BUF_LEN) {
+			in->len = 0;
+			if (!in->skip) {
+				in->skip = true;
+				*error = true;
+				in->buf[0] = 0;
+				return in->buf;
+			}
+		}
+
+		if (!batch_input_ready(in, wait)) {
+			/* interrupted by a signal while waiting */
+			if (!wait || cancel_all_requests)
+				return NULL;
+			continue;
+		}
+
+		len = read(in->fd, in->buf + in->len, BATCH_BUF_LEN - in->len);
+		if (len < 0 && errno == EINTR)
+			continue;
+
+		if (len <= 0)
+			in->eof = true;
+		else
+			in->len += len;
+	}
+}
+
+static const struct option *batch_find_option(const struct option *opts, const char *name)
+{
+	for (; opts->name; opts++)
+		if (!strcmp(opts->name, name))
+			return opts;
+
+	return NULL;
+}
+
+static const struct option *batch_find_short(const struct option *opts, char val)
+{
+	for (; opts->name; opts++)
+		if (opts->val == val)
+			return opts;
+
+	return NULL;
+}
+
+/* split a line into words in place: 1 for a word, 0 at the end, -1 on unbalanced quotes */
+static int batch_next_word(char **line, char **word)
+{
+	char *p = *line, *out;
+	char quote = 0;
+
+	p += strspn(p, " \t\r");
+	if (!*p)
+		return 0;
+
+	*word = out = p;
+	for (; *p; p++) {
+		if (quote) {
+			if (*p == quote)
+				quote = 0;
+			else
+				*out++ = *p;
+		} else if (*p == '\'' || *p == '"') {
+			quote = *p;
+		} else if (*p == ' ' || *p == '\t' || *p == '\r') {
+			p++;
+			break;
+		} else {
+			*out++ = *p;
+		}
+	}
+
+	*out = 0;
+	*line = p;
+	return quote ? -1 : 1;
+}
+
+/*
+ * Turns the words of a line into uqmi arguments, stored in args. Returns
+ * the number of arguments or -1, with the reason in *error.
+ */
+static int batch_parse_line(char *line, const struct option *opts, char **args,
+			    const char **error)
+{
+	const struct option *opt;
+	bool want_arg = false;
+	char *word, *eq;
+	int argc = 0;
+	int ret;
+
+	while ((ret = batch_next_word(&line, &word)) > 0) {
+		if (argc == BATCH_MAX_ARGS) {
+			*error = "Too many arguments";
+			goto error;
+		}
+
+		if (want_arg) {
+			want_arg = false;
+			args[argc++] = strdup(word);
+			continue;
+		}
+
+		if (word[0] == '-' && word[1] != '-') {
+			opt = batch_find_short(opts, word[1]);
+			want_arg = opt && opt->has_arg == required_argument && !word[2];
+			args[argc++] = strdup(word);
+			continue;
+		}
+
+		if (word[0] == '-')
+			word += 2;
+
+		eq = strchr(word, '=');
+		if (eq)
+			*eq = 0;
+
+		opt = batch_find_option(opts, word);
+		if (!opt) {
+			*error = "Unknown action";
+			goto error;
+		}
+
+		if (eq)
+			*eq = '=';
+
+		want_arg = opt->has_arg == required_argument && !eq;
+		args[argc] = malloc(strlen(word) + 3);
+		if (args[argc])
+			sprintf(args[argc], "--%s", word);
+		argc++;
+	}
+
+	if (!ret)
+		return argc;
+
+	*error = "Unbalanced quotes";
+error:
+	while (argc > 0)
+		free(args[--argc]);
+	return -1;
+}
+
+int uqmi_batch_run(struct qmi_dev *qmi, const char *path,
+		   const struct option *opts, uqmi_batch_cb cb)
+{
+	struct batch_input *in;
+	char **args, *line, *argv[BATCH_MAX_ARGS + 2];
+	const char *error = NULL;
+	int n_args = 0, n_lines = 0;
+	int line_no = 0;
+	bool ret = true;
+	bool overlong;
+	int i, argc = 0;
+
+	in = calloc(1, sizeof(*in));
+	args = calloc(BATCH_MAX_LINES * BATCH_MAX_ARGS, sizeof(*args));
+	if (!in || !args)
+		goto out;
+
+	in->fd = strcmp(path, "-") ? open(path, O_RDONLY | O_CLOEXEC) : STDIN_FILENO;
+	if (in->fd < 0) {
+		fprintf(stderr, "Failed to open %s: %s\n", path, strerror(errno));
+		ret = false;
+		goto out;
+	}
+
+	while (!cancel_all_requests) {
+		line = batch_read_line(in, !n_lines, &overlong);
+		if (line) {
+			line_no++;
+			line += strspn(line, " \t\r");
+			if (!overlong && (!*line || *line == '#'))
+				continue;
+
+			uqmi_cmd_line = line_no;
+			argc = -1;
+			error = "Line too long";
+			if (!overlong)
+				argc = batch_parse_line(line, opts, &args[n_args], &error);
+
+			if (argc > 0) {
+				argv[0] = "uqmi";
+				memcpy(&argv[1], &args[n_args], argc * sizeof(*argv));
+				argv[argc + 1] = NULL;
+				n_args += argc;
+				optind = 0;
+				if (!cb(argc + 1, argv)) {
+					n_lines++;
+					if (n_lines < BATCH_MAX_LINES)
+						continue;
+				} else {
+					uqmi_drop_commands(line_no);
+					error = "Invalid arguments";
+					argc = -1;
+				}
+			}
+		}
+
+		uqmi_cmd_line = 0;
+		if (n_lines && !uqmi_run_batch(qmi))
+			ret = false;
+
+		for (i = 0; i < n_args; i++)
+			free(args[i]);
+		n_args = 0;
+		n_lines = 0;
+
+		if (line && argc < 0) {
+			uqmi_print_error(line_no, error);
+			ret = false;
+		}
+
+		fflush(stdout);
+		if (!line && in->eof)
+			break;
+	}
+
+	if (in->fd != STDIN_FILENO)
+		close(in->fd);
+
+out:
+	free(args);
+	free(in);
+	return ret ? 0 : -1;
+}
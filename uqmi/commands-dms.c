@@ -27,17 +27,6 @@ static struct {
 	char* puk;
 } dms_req_data;
 
-const char *oper_modes[] = {
-	[QMI_DMS_OPERATING_MODE_ONLINE] = "online",
-	[QMI_DMS_OPERATING_MODE_LOW_POWER] = "low_power",
-	[QMI_DMS_OPERATING_MODE_FACTORY_TEST] = "factory_test",
-	[QMI_DMS_OPERATING_MODE_OFFLINE] = "offline",
-	[QMI_DMS_OPERATING_MODE_RESET] = "reset",
-	[QMI_DMS_OPERATING_MODE_SHUTTING_DOWN] = "shutting_down",
-	[QMI_DMS_OPERATING_MODE_PERSISTENT_LOW_POWER] = "persistent_low_power",
-	[QMI_DMS_OPERATING_MODE_MODE_ONLY_LOW_POWER] = "mode_only_low_power",
-};
-
 static void cmd_dms_get_capabilities_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
 {
 	void *t, *networks;
@@ -51,38 +40,33 @@ static void cmd_dms_get_capabilities_cb(struct qmi_dev *qmi, struct qmi_request
 		[QMI_DMS_RADIO_INTERFACE_LTE] = "lte",
 		[QMI_DMS_RADIO_INTERFACE_5GNR] = "5gnr",
 	};
-	const char *service_cap[] = {
-		[QMI_DMS_DATA_SERVICE_CAPABILITY_NONE] = "none",
-		[QMI_DMS_DATA_SERVICE_CAPABILITY_CS] = "cs",
-		[QMI_DMS_DATA_SERVICE_CAPABILITY_PS] = "ps",
-		[QMI_DMS_DATA_SERVICE_CAPABILITY_SIMULTANEOUS_CS_PS] = "simultaneous_cs_ps",
-		[QMI_DMS_DATA_SERVICE_CAPABILITY_NON_SIMULTANEOUS_CS_PS] = "non_simultaneous_cs_ps",
-	};
+	const char *service_cap;
 
 	qmi_parse_dms_get_capabilities_response(msg, &res);
 
-	t = blobmsg_open_table(&status, NULL);
+	t = uqmi_open_table(NULL);
 
-	blobmsg_add_u32(&status, "max_tx_channel_rate", (int32_t) res.data.info.max_tx_channel_rate);
-	blobmsg_add_u32(&status, "max_rx_channel_rate", (int32_t) res.data.info.max_rx_channel_rate);
-	if ((int)res.data.info.data_service_capability >= 0 && res.data.info.data_service_capability < ARRAY_SIZE(service_cap))
-		blobmsg_add_string(&status, "data_service", service_cap[res.data.info.data_service_capability]);
+	uqmi_add_u32("max_tx_channel_rate", (int32_t) res.data.info.max_tx_channel_rate);
+	uqmi_add_u32("max_rx_channel_rate", (int32_t) res.data.info.max_rx_channel_rate);
+	service_cap = qmi_enum_name(&qmi_dms_data_service_capability_names, res.data.info.data_service_capability);
+	if (service_cap)
+		uqmi_add_string("data_service", service_cap);
 
 	if(res.data.info.sim_capability == QMI_DMS_SIM_CAPABILITY_NOT_SUPPORTED)
-		blobmsg_add_string(&status, "sim", "not supported");
+		uqmi_add_string("sim", "not supported");
 	else if(res.data.info.sim_capability == QMI_DMS_SIM_CAPABILITY_SUPPORTED)
-		blobmsg_add_string(&status, "sim", "supported");
+		uqmi_add_string("sim", "supported");
 
-	networks = blobmsg_open_array(&status, "networks");
+	networks = uqmi_open_array("networks");
 	for (i = 0; i < res.data.info.radio_interface_list_n; i++) {
 		if ((int)res.data.info.radio_interface_list[i] >= 0 && res.data.info.radio_interface_list[i] < ARRAY_SIZE(radio_cap))
-			blobmsg_add_string(&status, NULL, radio_cap[res.data.info.radio_interface_list[i]]);
+			uqmi_add_string(NULL, radio_cap[res.data.info.radio_interface_list[i]]);
 		else
-			blobmsg_add_string(&status, NULL, "unknown");
+			uqmi_add_string(NULL, "unknown");
 	}
-	blobmsg_close_array(&status, networks);
+	uqmi_close_array(networks);
 
-	blobmsg_close_table(&status, t);
+	uqmi_close_table(t);
 }
 
 static enum qmi_cmd_result
@@ -118,18 +102,49 @@ static void cmd_dms_get_pin_status_cb(struct qmi_dev *qmi, struct qmi_request *r
 	void *c;
 
 	qmi_parse_dms_uim_get_pin_status_response(msg, &res);
-	c = blobmsg_open_table(&status, NULL);
+	c = uqmi_open_table(NULL);
 	if (res.set.pin1_status) {
-		blobmsg_add_string(&status, "pin1_status", get_pin_status(res.data.pin1_status.current_status));
-		blobmsg_add_u32(&status, "pin1_verify_tries", (int32_t) res.data.pin1_status.verify_retries_left);
-		blobmsg_add_u32(&status, "pin1_unblock_tries", (int32_t) res.data.pin1_status.unblock_retries_left);
+		uqmi_add_string("pin1_status", get_pin_status(res.data.pin1_status.current_status));
+		uqmi_add_u32("pin1_verify_tries", (int32_t) res.data.pin1_status.verify_retries_left);
+		uqmi_add_u32("pin1_unblock_tries", (int32_t) res.data.pin1_status.unblock_retries_left);
 	}
 	if (res.set.pin2_status) {
-		blobmsg_add_string(&status, "pin2_status", get_pin_status(res.data.pin2_status.current_status));
-		blobmsg_add_u32(&status, "pin2_verify_tries", (int32_t) res.data.pin2_status.verify_retries_left);
-		blobmsg_add_u32(&status, "pin2_unblock_tries", (int32_t) res.data.pin2_status.unblock_retries_left);
+		uqmi_add_string("pin2_status", get_pin_status(res.data.pin2_status.current_status));
+		uqmi_add_u32("pin2_verify_tries", (int32_t) res.data.pin2_status.verify_retries_left);
+		uqmi_add_u32("pin2_unblock_tries", (int32_t) res.data.pin2_status.unblock_retries_left);
 	}
-	blobmsg_close_table(&status, c);
+	uqmi_close_table(c);
+}
+
+static void cmd_dms_event_report_ind_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	struct qmi_dms_event_report_indication res;
+	void *c;
+
+	qmi_parse_dms_event_report_indication(msg, &res);
+	c = uqmi_open_table(NULL);
+	if (res.set.power_state) {
+		uqmi_add_u32("power_state", res.data.power_state.power_state_flags);
+		uqmi_add_u32("battery_level", res.data.power_state.battery_level);
+	}
+	if (res.set.pin1_status) {
+		uqmi_add_string("pin1_status", get_pin_status(res.data.pin1_status.current_status));
+		uqmi_add_u32("pin1_verify_tries", (int32_t) res.data.pin1_status.verify_retries_left);
+		uqmi_add_u32("pin1_unblock_tries", (int32_t) res.data.pin1_status.unblock_retries_left);
+	}
+	if (res.set.pin2_status) {
+		uqmi_add_string("pin2_status", get_pin_status(res.data.pin2_status.current_status));
+		uqmi_add_u32("pin2_verify_tries", (int32_t) res.data.pin2_status.verify_retries_left);
+		uqmi_add_u32("pin2_unblock_tries", (int32_t) res.data.pin2_status.unblock_retries_left);
+	}
+	if (res.set.activation_state)
+		uqmi_add_u32("activation_state", res.data.activation_state);
+	if (res.set.operating_mode)
+		uqmi_add_string("operating_mode", enum_name(&qmi_dms_operating_mode_names,
+							    res.data.operating_mode));
+	if (res.set.uim_state)
+		uqmi_add_u32("uim_state", res.data.uim_state);
+	uqmi_close_table(c);
 }
 
 static enum qmi_cmd_result
@@ -321,7 +336,7 @@ static void cmd_dms_get_iccid_cb(struct qmi_dev *qmi, struct qmi_request *req, s
 
 	qmi_parse_dms_uim_get_iccid_response(msg, &res);
 	if (res.data.iccid)
-		blobmsg_add_string(&status, NULL, res.data.iccid);
+		uqmi_add_string(NULL, res.data.iccid);
 }
 
 static enum qmi_cmd_result
@@ -337,7 +352,7 @@ static void cmd_dms_get_imsi_cb(struct qmi_dev *qmi, struct qmi_request *req, st
 
 	qmi_parse_dms_uim_get_imsi_response(msg, &res);
 	if (res.data.imsi)
-		blobmsg_add_string(&status, NULL, res.data.imsi);
+		uqmi_add_string(NULL, res.data.imsi);
 }
 
 static enum qmi_cmd_result
@@ -353,7 +368,7 @@ static void cmd_dms_get_msisdn_cb(struct qmi_dev *qmi, struct qmi_request *req,
 
 	qmi_parse_dms_get_msisdn_response(msg, &res);
 	if (res.data.msisdn)
-		blobmsg_add_string(&status, NULL, res.data.msisdn);
+		uqmi_add_string(NULL, res.data.msisdn);
 }
 
 static enum qmi_cmd_result
@@ -369,7 +384,7 @@ static void cmd_dms_get_imei_cb(struct qmi_dev *qmi, struct qmi_request *req, st
 
 	qmi_parse_dms_get_ids_response(msg, &res);
 	if (res.data.imei)
-		blobmsg_add_string(&status, NULL, res.data.imei);
+		uqmi_add_string(NULL, res.data.imei);
 }
 
 static enum qmi_cmd_result
@@ -393,10 +408,7 @@ cmd_dms_get_operating_mode_cb(struct qmi_dev *qmi, struct qmi_request *req, stru
 	struct qmi_dms_get_operating_mode_response res;
 
 	qmi_parse_dms_get_operating_mode_response(msg, &res);
-	if (res.data.mode < ARRAY_SIZE(oper_modes))
-		blobmsg_add_string(&status, NULL, oper_modes[res.data.mode]);
-	else
-		blobmsg_add_string(&status, NULL, "unknown");
+	uqmi_add_string(NULL, enum_name(&qmi_dms_operating_mode_names, res.data.mode));
 }
 
 static enum qmi_cmd_result
@@ -413,21 +425,15 @@ cmd_dms_set_operating_mode_prepare(struct qmi_dev *qmi, struct qmi_request *req,
 	static struct qmi_dms_set_operating_mode_request sreq = {
 		QMI_INIT(mode, QMI_DMS_OPERATING_MODE_ONLINE),
 	};
-	int i;
+	int mode;
 
-	for (i = 0; i < ARRAY_SIZE(oper_modes); i++) {
-		if (!oper_modes[i])
-			continue;
+	if (qmi_enum_value(&qmi_dms_operating_mode_names, arg, &mode) ||
+	    mode == QMI_DMS_OPERATING_MODE_UNKNOWN)
+		return uqmi_add_error("Invalid argument");
 
-		if (strcmp(arg, oper_modes[i]) != 0)
-			continue;
-
-		sreq.data.mode = i;
-		qmi_set_dms_set_operating_mode_request(msg, &sreq);
-		return QMI_CMD_REQUEST;
-	}
-
-	return uqmi_add_error("Invalid argument");
+	sreq.data.mode = mode;
+	qmi_set_dms_set_operating_mode_request(msg, &sreq);
+	return QMI_CMD_REQUEST;
 }
 
 #define cmd_dms_set_fcc_authentication_cb no_cb
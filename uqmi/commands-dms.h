@@ -20,27 +20,27 @@
  */
 
 #define __uqmi_dms_commands												\
-	__uqmi_command(dms_get_capabilities, get-capabilities, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_get_pin_status, get-pin-status, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_verify_pin1, verify-pin1, required, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_verify_pin2, verify-pin2, required, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_set_pin1_protection, set-pin1-protection, required, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_set_pin2_protection, set-pin2-protection, required, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_set_pin, pin, required, CMD_TYPE_OPTION), \
-	__uqmi_command(dms_change_pin1, change-pin1, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_change_pin2, change-pin2, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_unblock_pin1, unblock-pin1, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_unblock_pin2, unblock-pin2, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_set_puk, puk, required, CMD_TYPE_OPTION), \
-	__uqmi_command(dms_set_new_pin, new-pin, required, CMD_TYPE_OPTION), \
-	__uqmi_command(dms_get_iccid, get-iccid, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_get_imsi, get-imsi, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_get_imei, get-imei, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_get_msisdn, get-msisdn, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_get_operating_mode, get-device-operating-mode, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_set_operating_mode, set-device-operating-mode, required, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_reset, reset-dms, no, QMI_SERVICE_DMS), \
-	__uqmi_command(dms_set_fcc_authentication, fcc-auth, no, QMI_SERVICE_DMS) \
+	__uqmi_command(dms_get_capabilities, get-capabilities, no, QMI_SERVICE_DMS, CMD_SERVICE, 0), \
+	__uqmi_command(dms_get_pin_status, get-pin-status, no, QMI_SERVICE_DMS, CMD_SERVICE, 0), \
+	__uqmi_command(dms_verify_pin1, verify-pin1, required, QMI_SERVICE_DMS, CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(dms_verify_pin2, verify-pin2, required, QMI_SERVICE_DMS, CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(dms_set_pin1_protection, set-pin1-protection, required, QMI_SERVICE_DMS, CMD_STATE(dms_req_data) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(dms_set_pin2_protection, set-pin2-protection, required, QMI_SERVICE_DMS, CMD_STATE(dms_req_data) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(dms_set_pin, pin, required, CMD_TYPE_OPTION, 0, CMD_STATE(dms_req_data)), \
+	__uqmi_command(dms_change_pin1, change-pin1, no, QMI_SERVICE_DMS, CMD_STATE(dms_req_data) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(dms_change_pin2, change-pin2, no, QMI_SERVICE_DMS, CMD_STATE(dms_req_data) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(dms_unblock_pin1, unblock-pin1, no, QMI_SERVICE_DMS, CMD_STATE(dms_req_data) | CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(dms_unblock_pin2, unblock-pin2, no, QMI_SERVICE_DMS, CMD_STATE(dms_req_data) | CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(dms_set_puk, puk, required, CMD_TYPE_OPTION, 0, CMD_STATE(dms_req_data)), \
+	__uqmi_command(dms_set_new_pin, new-pin, required, CMD_TYPE_OPTION, 0, CMD_STATE(dms_req_data)), \
+	__uqmi_command(dms_get_iccid, get-iccid, no, QMI_SERVICE_DMS, CMD_SERVICE, 0), \
+	__uqmi_command(dms_get_imsi, get-imsi, no, QMI_SERVICE_DMS, CMD_SERVICE, 0), \
+	__uqmi_command(dms_get_imei, get-imei, no, QMI_SERVICE_DMS, CMD_SERVICE, 0), \
+	__uqmi_command(dms_get_msisdn, get-msisdn, no, QMI_SERVICE_DMS, CMD_SERVICE, 0), \
+	__uqmi_command(dms_get_operating_mode, get-device-operating-mode, no, QMI_SERVICE_DMS, CMD_SERVICE, 0), \
+	__uqmi_command(dms_set_operating_mode, set-device-operating-mode, required, QMI_SERVICE_DMS, CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(dms_reset, reset-dms, no, QMI_SERVICE_DMS, CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(dms_set_fcc_authentication, fcc-auth, no, QMI_SERVICE_DMS, CMD_SERVICE, CMD_MODEM) \
 
 #define dms_helptext \
 		"  --get-capabilities:               List device capabilities\n" \
@@ -22,6 +22,7 @@
 #include "uqmi.h"
 #include "qmi-message.h"
 #include "commands.h"
+#include "qmi-bands.h"
 
 #include <libubox/blobmsg.h>
 
@@ -31,74 +32,30 @@
 
 static struct qmi_nas_get_tx_rx_info_request tx_rx_req;
 static struct qmi_nas_set_system_selection_preference_request sel_req;
+static struct qmi_nas_network_scan_request scan_req = {
+	QMI_INIT(network_type,
+		 QMI_NAS_NETWORK_SCAN_TYPE_GSM |
+		 QMI_NAS_NETWORK_SCAN_TYPE_UMTS |
+		 QMI_NAS_NETWORK_SCAN_TYPE_LTE |
+		 QMI_NAS_NETWORK_SCAN_TYPE_TD_SCDMA),
+};
 static struct	{
 	bool mcc_is_set;
 	bool mnc_is_set;
 } plmn_code_flag;
 
 static void
-print_earfcn_info(uint32_t earfcn)
+print_band_info(enum qmi_band_rat rat, uint32_t channel)
 {
-	/* https://www.sqimway.com/lte_band.php */
-	static const struct {
-		uint32_t    min;
-		uint32_t    max;
-		uint16_t    band;
-		uint16_t    freq;
-		const char *duplex;
-	} earfcn_ranges[] = {
-		{     0,   599, 1,  2100, "FDD" },
-		{   600,  1199, 2,  1800, "FDD" },
-		{  1200,  1949, 3,  1800, "FDD" },
-		{  1950,  2399, 4,  1700, "FDD" },
-		{  2400,  2649, 5,  850,  "FDD" },
-		{  2650,  2749, 6,  800,  "FDD" },
-		{  2750,  3449, 7,  2600, "FDD" },
-		{  3450,  3799, 8,  900,  "FDD" },
-		{  3800,  4149, 9,  1800, "FDD" },
-		{  4150,  4749, 10, 1700, "FDD" },
-		{  4750,  4999, 11, 1500, "FDD" },
-		{  5000,  5179, 12, 700,  "FDD" },
-		{  5180,  5279, 13, 700,  "FDD" },
-		{  5280,  5379, 14, 700,  "FDD" },
-		{  5730,  5849, 17, 700,  "FDD" },
-		{  5850,  5999, 18, 850,  "FDD" },
-		{  6000,  6149, 19, 850,  "FDD" },
-		{  6150,  6449, 20, 800,  "FDD" },
-		{  6450,  6599, 21, 1500, "FDD" },
-		{  6600,  7399, 22, 3500, "FDD" },
-		{  7500,  7699, 23, 2000, "FDD" },
-		{  7700,  8039, 24, 1600, "FDD" },
-		{  8040,  8689, 25, 1900, "FDD" },
-		{  8690,  9039, 26, 850,  "FDD" },
-		{  9040,  9209, 27, 800,  "FDD" },
-		{  9210,  9659, 28, 700,  "FDD" },
-		{  9660,  9769, 29, 700,  "SDL" },
-		{  9770,  9869, 30, 2300, "FDD" },
-		{  9870,  9919, 31, 450,  "FDD" },
-		{  9920, 10359, 32, 1500, "SDL" },
-		{ 36000, 36199, 33, 1900, "TDD" },
-		{ 36200, 36349, 34, 2000, "TDD" },
-		{ 36350, 36949, 35, 1900, "TDD" },
-		{ 36950, 37549, 36, 1900, "TDD" },
-		{ 37550, 37749, 37, 1900, "TDD" },
-		{ 37750, 38249, 38, 2600, "TDD" },
-		{ 38250, 38649, 39, 1900, "TDD" },
-		{ 38650, 39649, 40, 2300, "TDD" },
-		{ 39650, 41589, 41, 2500, "TDD" },
-		{ 41590, 43589, 42, 3500, "TDD" },
-		{ 43590, 45589, 43, 3700, "TDD" },
-		{ 45590, 46589, 44, 700,  "TDD" },
-	};
+	const struct qmi_band *band = qmi_band_find(rat, channel);
 
-	for (int i = 0; i < (sizeof(earfcn_ranges) / sizeof(*earfcn_ranges)); i++) {
-		if (earfcn <= earfcn_ranges[i].max && earfcn >= earfcn_ranges[i].min) {
-			blobmsg_add_u32(&status, "band", earfcn_ranges[i].band);
-			blobmsg_add_u32(&status, "frequency", earfcn_ranges[i].freq);
-			blobmsg_add_string(&status, "duplex", earfcn_ranges[i].duplex);
-			return;
-		}
-	}
+	if (!band)
+		return;
+
+	uqmi_add_u32("band", band->band);
+	uqmi_add_u32("frequency", band->mhz);
+	uqmi_add_string("duplex", qmi_band_duplex_name(band));
+	uqmi_add_u32("dl_frequency_khz", qmi_band_freq(band, channel));
 }
 
 static char *
@@ -139,12 +96,8 @@ cmd_nas_do_set_system_selection_prepare(struct qmi_dev *qmi, struct qmi_request
 static enum qmi_cmd_result
 do_sel_network(void)
 {
-	static bool use_sel_req = false;
-
-	if (!use_sel_req) {
-		use_sel_req = true;
+	if (!uqmi_cmd_queued(__UQMI_COMMAND_nas_do_set_system_selection))
 		uqmi_add_command(NULL, __UQMI_COMMAND_nas_do_set_system_selection);
-	}
 
 	return QMI_CMD_DONE;
 }
@@ -196,12 +149,10 @@ cmd_nas_set_network_modes_prepare(struct qmi_dev *qmi, struct qmi_request *req,
 static enum qmi_cmd_result
 cmd_nas_set_network_preference_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
-	QmiNasGsmWcdmaAcquisitionOrderPreference pref = QMI_NAS_GSM_WCDMA_ACQUISITION_ORDER_PREFERENCE_AUTOMATIC;
+	int pref;
 
-	if (!strcmp(arg, "gsm"))
-		pref = QMI_NAS_GSM_WCDMA_ACQUISITION_ORDER_PREFERENCE_GSM;
-	else if (!strcmp(arg, "wcdma"))
-		pref = QMI_NAS_GSM_WCDMA_ACQUISITION_ORDER_PREFERENCE_WCDMA;
+	if (qmi_enum_value(&qmi_nas_gsm_wcdma_acquisition_order_preference_names, arg, &pref))
+		pref = QMI_NAS_GSM_WCDMA_ACQUISITION_ORDER_PREFERENCE_AUTOMATIC;
 
 	qmi_set(&sel_req, gsm_wcdma_acquisition_order_preference, pref);
 	return do_sel_network();
@@ -315,70 +266,70 @@ cmd_nas_get_signal_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct
 	is_5gnr_endc = (res.set.lte_signal_strength && is_5gnr_connected);
 
 	if (is_5gnr_endc) {
-		a = blobmsg_open_array(&status, NULL);
+		a = uqmi_open_array(NULL);
 	}
 
-	c = blobmsg_open_table(&status, NULL);
+	c = uqmi_open_table(NULL);
 	if (res.set.cdma_signal_strength) {
-		blobmsg_add_string(&status, "type", "cdma");
-		blobmsg_add_u32(&status, "rssi", (int32_t) res.data.cdma_signal_strength.rssi);
-		blobmsg_add_u32(&status, "ecio", (int32_t) res.data.cdma_signal_strength.ecio);
+		uqmi_add_string("type", "cdma");
+		uqmi_add_u32("rssi", (int32_t) res.data.cdma_signal_strength.rssi);
+		uqmi_add_u32("ecio", (int32_t) res.data.cdma_signal_strength.ecio);
 	}
 
 	if (res.set.hdr_signal_strength) {
-		blobmsg_add_string(&status, "type", "hdr");
-		blobmsg_add_u32(&status, "rssi", (int32_t) res.data.hdr_signal_strength.rssi);
-		blobmsg_add_u32(&status, "ecio", (int32_t) res.data.hdr_signal_strength.ecio);
-		blobmsg_add_u32(&status, "io", res.data.hdr_signal_strength.io);
+		uqmi_add_string("type", "hdr");
+		uqmi_add_u32("rssi", (int32_t) res.data.hdr_signal_strength.rssi);
+		uqmi_add_u32("ecio", (int32_t) res.data.hdr_signal_strength.ecio);
+		uqmi_add_u32("io", res.data.hdr_signal_strength.io);
 	}
 
 	if (res.set.gsm_signal_strength) {
-		blobmsg_add_string(&status, "type", "gsm");
-		blobmsg_add_u32(&status, "signal", (int32_t) res.data.gsm_signal_strength);
+		uqmi_add_string("type", "gsm");
+		uqmi_add_u32("signal", (int32_t) res.data.gsm_signal_strength);
 	}
 
 	if (res.set.wcdma_signal_strength) {
-		blobmsg_add_string(&status, "type", "wcdma");
-		blobmsg_add_u32(&status, "rssi", (int32_t) res.data.wcdma_signal_strength.rssi);
-		blobmsg_add_u32(&status, "ecio", (int32_t) res.data.wcdma_signal_strength.ecio);
+		uqmi_add_string("type", "wcdma");
+		uqmi_add_u32("rssi", (int32_t) res.data.wcdma_signal_strength.rssi);
+		uqmi_add_u32("ecio", (int32_t) res.data.wcdma_signal_strength.ecio);
 	}
 
 	if (res.set.lte_signal_strength) {
-		blobmsg_add_string(&status, "type", "lte");
-		blobmsg_add_u32(&status, "rssi", (int32_t) res.data.lte_signal_strength.rssi);
-		blobmsg_add_u32(&status, "rsrq", (int32_t) res.data.lte_signal_strength.rsrq);
-		blobmsg_add_u32(&status, "rsrp", (int32_t) res.data.lte_signal_strength.rsrp);
-		blobmsg_add_double(&status, "snr", (double) res.data.lte_signal_strength.snr*0.1);
+		uqmi_add_string("type", "lte");
+		uqmi_add_u32("rssi", (int32_t) res.data.lte_signal_strength.rssi);
+		uqmi_add_u32("rsrq", (int32_t) res.data.lte_signal_strength.rsrq);
+		uqmi_add_u32("rsrp", (int32_t) res.data.lte_signal_strength.rsrp);
+		uqmi_add_double("snr", (double) res.data.lte_signal_strength.snr*0.1);
 	}
 
 	if (res.set.tdma_signal_strength) {
-		blobmsg_add_string(&status, "type", "tdma");
-		blobmsg_add_u32(&status, "signal", (int32_t) res.data.tdma_signal_strength);
+		uqmi_add_string("type", "tdma");
+		uqmi_add_u32("signal", (int32_t) res.data.tdma_signal_strength);
 	}
 
 	if (is_5gnr_connected) {
 		if (is_5gnr_endc) {
-			blobmsg_close_table(&status, c);
-			c = blobmsg_open_table(&status, NULL);
+			uqmi_close_table(c);
+			c = uqmi_open_table(NULL);
 		}
-		blobmsg_add_string(&status, "type", "5gnr");
+		uqmi_add_string("type", "5gnr");
 		if (res.set._5g_signal_strength) {
 			if (res.data._5g_signal_strength.rsrp != _5GNR_NOT_CONNECTED_VALUE)
-				blobmsg_add_u32(&status, "rsrp", (int32_t) res.data._5g_signal_strength.rsrp);
+				uqmi_add_u32("rsrp", (int32_t) res.data._5g_signal_strength.rsrp);
 			if (res.data._5g_signal_strength.snr != _5GNR_NOT_CONNECTED_VALUE)
-				blobmsg_add_double(&status, "snr", (double) res.data._5g_signal_strength.snr*0.1);
+				uqmi_add_double("snr", (double) res.data._5g_signal_strength.snr*0.1);
 		}
 
 		if (res.set._5g_signal_strength_extended &&
 			(res.data._5g_signal_strength_extended != _5GNR_NOT_CONNECTED_VALUE)) {
-			blobmsg_add_u32(&status, "rsrq", (int32_t) res.data._5g_signal_strength_extended);
+			uqmi_add_u32("rsrq", (int32_t) res.data._5g_signal_strength_extended);
 		}
 	}
 
-	blobmsg_close_table(&status, c);
+	uqmi_close_table(c);
 
 	if (is_5gnr_endc) {
-		blobmsg_close_array(&status, a);
+		uqmi_close_array(a);
 	}
 }
 
@@ -423,27 +374,27 @@ print_system_info(uint8_t svc_status, uint8_t tsvc_status, bool preferred, bool
 		[QMI_NAS_NETWORK_SERVICE_DOMAIN_UNKNOWN] = "unknown",
 		};
 
-	blobmsg_add_string(&status, "service_status", map_service[svc_status]);
-	blobmsg_add_string(&status, "true_service_status", map_service[tsvc_status]);
-	blobmsg_add_u8(&status, "preferred_data_path", preferred);
+	uqmi_add_string("service_status", map_service[svc_status]);
+	uqmi_add_string("true_service_status", map_service[tsvc_status]);
+	uqmi_add_u8("preferred_data_path", preferred);
 
 	if (system_info) {
 		if (domain_valid)
-			blobmsg_add_string(&status, "domain", map_network[domain]);
+			uqmi_add_string("domain", map_network[domain]);
 		if (service_cap_valid)
-			blobmsg_add_string(&status, "service", map_network[service_cap]);
+			uqmi_add_string("service", map_network[service_cap]);
 		if (roaming_status_valid)
-			blobmsg_add_string(&status, "roaming_status", map_roaming[roaming_status]);
+			uqmi_add_string("roaming_status", map_roaming[roaming_status]);
 		if (forbidden_valid)
-			blobmsg_add_u8(&status, "forbidden", forbidden);
+			uqmi_add_u8("forbidden", forbidden);
 		if (network_id_valid) {
-			blobmsg_add_string(&status, "mcc", mcc);
+			uqmi_add_string("mcc", mcc);
 			if ((uint8_t)mnc[2] == 255)
 				mnc[2] = 0;
-			blobmsg_add_string(&status, "mnc", mnc);
+			uqmi_add_string("mnc", mnc);
 		}
 		if (lac_valid)
-			blobmsg_add_u32(&status, "location_area_code", (int32_t) lac);
+			uqmi_add_u32("location_area_code", (int32_t) lac);
 	}
 }
 
@@ -462,9 +413,9 @@ cmd_nas_get_system_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct
 	void *c, *t;
 
 	qmi_parse_nas_get_system_info_response(msg, &res);
-	t = blobmsg_open_table(&status, NULL);
+	t = uqmi_open_table(NULL);
 	if (res.set.gsm_service_status) {
-		c = blobmsg_open_table(&status, "gsm");
+		c = uqmi_open_table("gsm");
 		print_system_info(res.data.gsm_service_status.service_status,
 				  res.data.gsm_service_status.true_service_status,
 				  res.data.gsm_service_status.preferred_data_path,
@@ -483,17 +434,17 @@ cmd_nas_get_system_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct
 				  res.data.gsm_system_info_v2.lac_valid,
 				  res.data.gsm_system_info_v2.lac);
 		if (res.set.gsm_system_info_v2 && res.data.gsm_system_info_v2.cid_valid)
-			blobmsg_add_u32(&status, "cell_id",
+			uqmi_add_u32("cell_id",
 					res.data.gsm_system_info_v2.cid);
 		if (res.set.additional_gsm_system_info &&
 		    res.data.additional_gsm_system_info.geo_system_index != 0xFFFF)
-			blobmsg_add_u32(&status, "geo_system_index",
+			uqmi_add_u32("geo_system_index",
 					res.data.additional_gsm_system_info.geo_system_index);
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 
 	if (res.set.wcdma_service_status) {
-		c = blobmsg_open_table(&status, "wcdma");
+		c = uqmi_open_table("wcdma");
 		print_system_info(res.data.wcdma_service_status.service_status,
 				  res.data.wcdma_service_status.true_service_status,
 				  res.data.wcdma_service_status.preferred_data_path,
@@ -512,18 +463,18 @@ cmd_nas_get_system_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct
 				  res.data.wcdma_system_info_v2.lac_valid,
 				  res.data.wcdma_system_info_v2.lac);
 		if (res.set.wcdma_system_info_v2 && res.data.wcdma_system_info_v2.cid_valid) {
-			blobmsg_add_u32(&status, "rnc_id",res.data.wcdma_system_info_v2.cid/65536);
-			blobmsg_add_u32(&status, "cell_id",res.data.wcdma_system_info_v2.cid%65536);
+			uqmi_add_u32("rnc_id",res.data.wcdma_system_info_v2.cid/65536);
+			uqmi_add_u32("cell_id",res.data.wcdma_system_info_v2.cid%65536);
 		}
 		if (res.set.additional_wcdma_system_info &&
 		    res.data.additional_wcdma_system_info.geo_system_index != 0xFFFF)
-			blobmsg_add_u32(&status, "geo_system_index",
+			uqmi_add_u32("geo_system_index",
 					res.data.additional_wcdma_system_info.geo_system_index);
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 
 	if (res.set.lte_service_status) {
-		c = blobmsg_open_table(&status, "lte");
+		c = uqmi_open_table("lte");
 		print_system_info(res.data.lte_service_status.service_status,
 				  res.data.lte_service_status.true_service_status,
 				  res.data.lte_service_status.preferred_data_path,
@@ -542,40 +493,40 @@ cmd_nas_get_system_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct
 				  res.data.lte_system_info_v2.lac_valid,
 				  res.data.lte_system_info_v2.lac);
 		if (res.set.lte_system_info_v2 && res.data.lte_system_info_v2.tac_valid)
-			blobmsg_add_u32(&status, "tracking_area_code",
+			uqmi_add_u32("tracking_area_code",
 					res.data.lte_system_info_v2.tac);
 		if (res.set.lte_system_info_v2 && res.data.lte_system_info_v2.cid_valid) {
-			blobmsg_add_u32(&status, "enodeb_id",res.data.lte_system_info_v2.cid/256);
-			blobmsg_add_u32(&status, "cell_id",res.data.lte_system_info_v2.cid%256);
+			uqmi_add_u32("enodeb_id",res.data.lte_system_info_v2.cid/256);
+			uqmi_add_u32("cell_id",res.data.lte_system_info_v2.cid%256);
 		}
 		if (res.set.additional_lte_system_info &&
 		    res.data.additional_lte_system_info.geo_system_index != 0xFFFF)
-			blobmsg_add_u32(&status, "geo_system_index",
+			uqmi_add_u32("geo_system_index",
 					res.data.additional_lte_system_info.geo_system_index);
 		if (res.set.lte_voice_support)
-			blobmsg_add_u8(&status, "voice_support", res.data.lte_voice_support);
+			uqmi_add_u8("voice_support", res.data.lte_voice_support);
 		if (res.set.ims_voice_support)
-			blobmsg_add_u8(&status, "ims_voice_support", res.data.ims_voice_support);
+			uqmi_add_u8("ims_voice_support", res.data.ims_voice_support);
 		if (res.set.lte_cell_access_status)
-			blobmsg_add_string(&status, "cell_access_status",
+			uqmi_add_string("cell_access_status",
 					   cell_status[res.data.lte_cell_access_status]);
 		if (res.set.network_selection_registration_restriction)
-			blobmsg_add_u32(&status, "registration_restriction",
+			uqmi_add_u32("registration_restriction",
 					res.data.network_selection_registration_restriction);
 		if (res.set.lte_registration_domain)
-			blobmsg_add_u32(&status, "registration_domain",
+			uqmi_add_u32("registration_domain",
 					res.data.lte_registration_domain);
 		if (res.set.eutra_with_nr5g_availability)
-			blobmsg_add_u8(&status, "5g_nsa_available",
+			uqmi_add_u8("5g_nsa_available",
 				       res.data.eutra_with_nr5g_availability);
 		if (res.set.dcnr_restriction_info)
-			blobmsg_add_u8(&status, "dcnr_restriction", res.data.dcnr_restriction_info);
+			uqmi_add_u8("dcnr_restriction", res.data.dcnr_restriction_info);
 
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 
 	if (res.set.nr5g_service_status_info) {
-		c = blobmsg_open_table(&status, "5gnr");
+		c = uqmi_open_table("5gnr");
 		print_system_info(res.data.nr5g_service_status_info.service_status,
 				  res.data.nr5g_service_status_info.true_service_status,
 				  res.data.nr5g_service_status_info.preferred_data_path,
@@ -594,17 +545,50 @@ cmd_nas_get_system_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct
 				  res.data.nr5g_system_info.lac_valid,
 				  res.data.nr5g_system_info.lac);
 		if (res.set.nr5g_system_info && res.data.nr5g_system_info.tac_valid)
-			blobmsg_add_u32(&status, "tracking_area_code",
+			uqmi_add_u32("tracking_area_code",
 					res.data.nr5g_system_info.tac);
 		if (res.set.nr5g_system_info && res.data.nr5g_system_info.cid_valid) {
-			blobmsg_add_u32(&status, "enodeb_id",res.data.nr5g_system_info.cid/256);
-			blobmsg_add_u32(&status, "cell_id",res.data.nr5g_system_info.cid%256);
+			uqmi_add_u32("enodeb_id",res.data.nr5g_system_info.cid/256);
+			uqmi_add_u32("cell_id",res.data.nr5g_system_info.cid%256);
 		}
 
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 
-	blobmsg_close_table(&status, t);
+	uqmi_close_table(t);
+}
+
+/*
+ * The system info indication has the TLVs of the response, but moves the
+ * TD-SCDMA, NR5G and EN-DC ones to other ids. Renumber those in place and
+ * print it like the response.
+ */
+static void
+cmd_nas_system_info_ind_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	static const uint8_t tlv_map[][2] = {
+		{ 0x24, 0x00 },	/* PLMN not changed, not in the response */
+		{ 0x25, 0x24 }, { 0x26, 0x25 }, { 0x27, 0x26 }, { 0x28, 0x27 },
+		{ 0x4c, 0x4a }, { 0x4d, 0x4b },
+		{ 0x50, 0x4e }, { 0x51, 0x4f }, { 0x52, 0x50 },
+	};
+	unsigned int len;
+	struct tlv *tlv;
+	void *buf;
+	int tlv_len, i;
+
+	buf = qmi_msg_get_tlv_buf(msg, &tlv_len);
+	len = tlv_len;
+	while ((tlv = tlv_get_next(&buf, &len)) != NULL) {
+		for (i = 0; i < ARRAY_SIZE(tlv_map); i++) {
+			if (tlv->type == tlv_map[i][0]) {
+				tlv->type = tlv_map[i][1];
+				break;
+			}
+		}
+	}
+
+	cmd_nas_get_system_info_cb(qmi, req, msg);
 }
 
 static enum qmi_cmd_result
@@ -628,33 +612,28 @@ print_channel_info(int32_t cell_id, int32_t channel, uint32_t bw)
 		[QMI_NAS_DL_BANDWIDTH_UNKNOWN] = "unknown",
 	};
 
-	blobmsg_add_u32(&status, "cell_id", cell_id);
-	blobmsg_add_u32(&status, "channel", channel);
-	print_earfcn_info(channel);
-	blobmsg_add_string(&status, "bandwidth", map_bandwidth[bw]);
+	uqmi_add_u32("cell_id", cell_id);
+	uqmi_add_u32("channel", channel);
+	print_band_info(QMI_BAND_RAT_LTE, channel);
+	uqmi_add_string("bandwidth", map_bandwidth[bw]);
 }
 
 static void
 cmd_nas_get_lte_cphy_ca_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
 {
 	struct qmi_nas_get_lte_cphy_ca_info_response res;
-	static const char *scell_state[] = {
-		[QMI_NAS_SCELL_STATE_DECONFIGURED] = "deconfigured",
-		[QMI_NAS_SCELL_STATE_DEACTIVATED] = "deactivated",
-		[QMI_NAS_SCELL_STATE_ACTIVATED] = "activated",
-	};
 	char idx_buf[16];
 	void *t, *c;
 	int i;
 
 	qmi_parse_nas_get_lte_cphy_ca_info_response(msg, &res);
-	t = blobmsg_open_table(&status, NULL);
+	t = uqmi_open_table(NULL);
 	if (res.set.phy_ca_agg_pcell_info) {
-		c = blobmsg_open_table(&status, "primary");
+		c = uqmi_open_table("primary");
 		print_channel_info(res.data.phy_ca_agg_pcell_info.physical_cell_id,
 				   res.data.phy_ca_agg_pcell_info.rx_channel,
 				   res.data.phy_ca_agg_pcell_info.dl_bandwidth);
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 	if (res.set.phy_ca_agg_scell_info && res.data.phy_ca_agg_secondary_cells_n) {
 		for (i = 0; i < res.data.phy_ca_agg_secondary_cells_n; i++) {
@@ -662,13 +641,14 @@ cmd_nas_get_lte_cphy_ca_info_cb(struct qmi_dev *qmi, struct qmi_request *req, st
 				break;
 			sprintf(idx_buf, "secondary_%d",
 				res.data.phy_ca_agg_secondary_cells[i].cell_index);
-			c = blobmsg_open_table(&status, idx_buf);
+			c = uqmi_open_table(idx_buf);
 			print_channel_info(res.data.phy_ca_agg_secondary_cells[i].physical_cell_id,
 					   res.data.phy_ca_agg_secondary_cells[i].rx_channel,
 					   res.data.phy_ca_agg_secondary_cells[i].dl_bandwidth);
-			blobmsg_add_string(&status, "state",
-					   scell_state[res.data.phy_ca_agg_secondary_cells[i].state]);
-			blobmsg_close_table(&status, c);
+			uqmi_add_string("state",
+					   enum_name(&qmi_nas_scell_state_names,
+						     res.data.phy_ca_agg_secondary_cells[i].state));
+			uqmi_close_table(c);
 		}
 	} else {
 		if (res.set.scell_index)
@@ -676,16 +656,17 @@ cmd_nas_get_lte_cphy_ca_info_cb(struct qmi_dev *qmi, struct qmi_request *req, st
 		else
 			sprintf(idx_buf, "secondary");
 		if (res.set.phy_ca_agg_scell_info && res.data.phy_ca_agg_scell_info.rx_channel != 0) {
-			c = blobmsg_open_table(&status, idx_buf);
+			c = uqmi_open_table(idx_buf);
 			print_channel_info(res.data.phy_ca_agg_scell_info.physical_cell_id,
 					   res.data.phy_ca_agg_scell_info.rx_channel,
 					   res.data.phy_ca_agg_scell_info.dl_bandwidth);
-			blobmsg_add_string(&status, "state",
-					   scell_state[res.data.phy_ca_agg_scell_info.state]);
-			blobmsg_close_table(&status, c);
+			uqmi_add_string("state",
+					   enum_name(&qmi_nas_scell_state_names,
+						     res.data.phy_ca_agg_scell_info.state));
+			uqmi_close_table(c);
 		}
 	}
-	blobmsg_close_table(&status, t);
+	uqmi_close_table(t);
 }
 
 static enum qmi_cmd_result
@@ -698,21 +679,21 @@ cmd_nas_get_lte_cphy_ca_info_prepare(struct qmi_dev *qmi, struct qmi_request *re
 static void
 print_chain_info(int8_t radio, bool tuned, int32_t rssi, int32_t ecio, int32_t rsrp, int32_t rscp, uint32_t phase)
 {
-	blobmsg_add_u8(&status, "tuned", tuned);
-	blobmsg_add_double(&status, "rssi", (double) rssi*0.1);
+	uqmi_add_u8("tuned", tuned);
+	uqmi_add_double("rssi", (double) rssi*0.1);
 	if (radio == QMI_NAS_RADIO_INTERFACE_5GNR) {
-		blobmsg_add_double(&status, "rsrp", (double) rsrp*-0.1);
+		uqmi_add_double("rsrp", (double) rsrp*-0.1);
 	}
 	else if (radio == QMI_NAS_RADIO_INTERFACE_LTE) {
-		blobmsg_add_double(&status, "rsrq", (double) ecio*-0.1);
-		blobmsg_add_double(&status, "rsrp", (double) rsrp*-0.1);
+		uqmi_add_double("rsrq", (double) ecio*-0.1);
+		uqmi_add_double("rsrp", (double) rsrp*-0.1);
 	}
 	else if (radio == QMI_NAS_RADIO_INTERFACE_UMTS) {
-		blobmsg_add_double(&status, "ecio", (double) ecio*-0.1);
-		blobmsg_add_double(&status, "rscp", (double) rscp*-0.1);
+		uqmi_add_double("ecio", (double) ecio*-0.1);
+		uqmi_add_double("rscp", (double) rscp*-0.1);
 	}
 	if (phase != 0xFFFFFFFF)
-		blobmsg_add_double(&status, "phase", (double) phase*0.01);
+		uqmi_add_double("phase", (double) phase*0.01);
 }
 
 static void
@@ -722,9 +703,9 @@ cmd_nas_get_tx_rx_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct q
 	void *c, *t;
 
 	qmi_parse_nas_get_tx_rx_info_response(msg, &res);
-	t = blobmsg_open_table(&status, NULL);
+	t = uqmi_open_table(NULL);
 	if (res.set.rx_chain_0_info) {
-		c = blobmsg_open_table(&status, "rx_chain_0");
+		c = uqmi_open_table("rx_chain_0");
 		print_chain_info(tx_rx_req.data.radio_interface,
 				 res.data.rx_chain_0_info.is_radio_tuned,
 				 res.data.rx_chain_0_info.rx_power,
@@ -732,10 +713,10 @@ cmd_nas_get_tx_rx_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct q
 				 res.data.rx_chain_0_info.rsrp,
 				 res.data.rx_chain_0_info.rscp,
 				 res.data.rx_chain_0_info.phase);
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 	if (res.set.rx_chain_1_info) {
-		c = blobmsg_open_table(&status, "rx_chain_1");
+		c = uqmi_open_table("rx_chain_1");
 		print_chain_info(tx_rx_req.data.radio_interface,
 				 res.data.rx_chain_1_info.is_radio_tuned,
 				 res.data.rx_chain_1_info.rx_power,
@@ -743,10 +724,10 @@ cmd_nas_get_tx_rx_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct q
 				 res.data.rx_chain_1_info.rsrp,
 				 res.data.rx_chain_1_info.rscp,
 				 res.data.rx_chain_1_info.phase);
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 	if (res.set.rx_chain_2_info) {
-		c = blobmsg_open_table(&status, "rx_chain_2");
+		c = uqmi_open_table("rx_chain_2");
 		print_chain_info(tx_rx_req.data.radio_interface,
 				 res.data.rx_chain_2_info.is_radio_tuned,
 				 res.data.rx_chain_2_info.rx_power,
@@ -754,10 +735,10 @@ cmd_nas_get_tx_rx_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct q
 				 res.data.rx_chain_2_info.rsrp,
 				 res.data.rx_chain_2_info.rscp,
 				 res.data.rx_chain_2_info.phase);
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 	if (res.set.rx_chain_3_info) {
-		c = blobmsg_open_table(&status, "rx_chain_3");
+		c = uqmi_open_table("rx_chain_3");
 		print_chain_info(tx_rx_req.data.radio_interface,
 				 res.data.rx_chain_3_info.is_radio_tuned,
 				 res.data.rx_chain_3_info.rx_power,
@@ -765,34 +746,27 @@ cmd_nas_get_tx_rx_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct q
 				 res.data.rx_chain_3_info.rsrp,
 				 res.data.rx_chain_3_info.rscp,
 				 res.data.rx_chain_3_info.phase);
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 	if (res.set.tx_info) {
-		c = blobmsg_open_table(&status, "tx");
-		blobmsg_add_u8(&status, "traffic", res.data.tx_info.is_in_traffic);
+		c = uqmi_open_table("tx");
+		uqmi_add_u8("traffic", res.data.tx_info.is_in_traffic);
 		if (res.data.tx_info.is_in_traffic)
-			blobmsg_add_double(&status, "tx_power",
+			uqmi_add_double("tx_power",
 					   (double) res.data.tx_info.tx_power*0.1);
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
-	blobmsg_close_table(&status, t);
+	uqmi_close_table(t);
 }
 
 
 static enum qmi_cmd_result
 cmd_nas_get_tx_rx_info_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
-	int radio = 0;
-
-	if (!strcmp(arg, "5gnr"))
-		radio = QMI_NAS_RADIO_INTERFACE_5GNR;
-	else if (!strcmp(arg, "lte"))
-		radio = QMI_NAS_RADIO_INTERFACE_LTE;
-	else if (!strcmp(arg, "umts"))
-		radio = QMI_NAS_RADIO_INTERFACE_UMTS;
-	else if (!strcmp(arg, "gsm"))
-		radio = QMI_NAS_RADIO_INTERFACE_GSM;
-	else
+	int radio;
+
+	if (qmi_enum_value(&qmi_nas_radio_interface_names, arg, &radio) ||
+	    radio <= QMI_NAS_RADIO_INTERFACE_NONE)
 		return uqmi_add_error("Invalid argument");
 
 	qmi_set(&tx_rx_req, radio_interface, radio);
@@ -803,18 +777,18 @@ cmd_nas_get_tx_rx_info_prepare(struct qmi_dev *qmi, struct qmi_request *req, str
 static void
 print_lte_info(int32_t cell_id, int16_t rsrq, int16_t rsrp, int16_t rssi)
 {
-	blobmsg_add_u32(&status, "physical_cell_id", cell_id);
-	blobmsg_add_double(&status, "rsrq", ((double)rsrq)/10);
-	blobmsg_add_double(&status, "rsrp", ((double)rsrp)/10);
-	blobmsg_add_double(&status, "rssi", ((double)rssi)/10);
+	uqmi_add_u32("physical_cell_id", cell_id);
+	uqmi_add_double("rsrq", ((double)rsrq)/10);
+	uqmi_add_double("rsrp", ((double)rsrp)/10);
+	uqmi_add_double("rssi", ((double)rssi)/10);
 }
 
 static void
 print_sel_info(int32_t priority, int32_t high, int32_t low)
 {
-	blobmsg_add_u32(&status, "cell_reselection_priority", priority);
-	blobmsg_add_u32(&status, "cell_reselection_low", low);
-	blobmsg_add_u32(&status, "cell_reselection_high", high);
+	uqmi_add_u32("cell_reselection_priority", priority);
+	uqmi_add_u32("cell_reselection_low", low);
+	uqmi_add_u32("cell_reselection_high", high);
 }
 
 static void
@@ -825,113 +799,115 @@ cmd_nas_get_cell_location_info_cb(struct qmi_dev *qmi, struct qmi_request *req,
 	int i, j;
 
 	qmi_parse_nas_get_cell_location_info_response(msg, &res);
-	t = blobmsg_open_table(&status, NULL);
+	t = uqmi_open_table(NULL);
 
 	if (res.set.umts_info_v2) {
-		c = blobmsg_open_table(&status, "umts_info");
-		blobmsg_add_u32(&status, "location_area_code", res.data.umts_info_v2.lac);
-		blobmsg_add_u32(&status, "cell_id", res.data.umts_info_v2.cell_id);
-		blobmsg_add_u32(&status, "channel",
+		c = uqmi_open_table("umts_info");
+		uqmi_add_u32("location_area_code", res.data.umts_info_v2.lac);
+		uqmi_add_u32("cell_id", res.data.umts_info_v2.cell_id);
+		uqmi_add_u32("channel",
 				res.data.umts_info_v2.utra_absolute_rf_channel_number);
-		blobmsg_add_u32(&status, "primary_scrambling_code",
+		print_band_info(QMI_BAND_RAT_UMTS, res.data.umts_info_v2.utra_absolute_rf_channel_number);
+		uqmi_add_u32("primary_scrambling_code",
 				res.data.umts_info_v2.primary_scrambling_code);
-		blobmsg_add_u32(&status, "rscp", res.data.umts_info_v2.rscp);
-		blobmsg_add_u32(&status, "ecio", res.data.umts_info_v2.ecio);
+		uqmi_add_u32("rscp", res.data.umts_info_v2.rscp);
+		uqmi_add_u32("ecio", res.data.umts_info_v2.ecio);
 		for (j = 0; j < res.data.umts_info_v2.cell_n; j++) {
-			cell = blobmsg_open_table(&status, NULL);
-			blobmsg_add_u32(&status, "channel",
+			cell = uqmi_open_table(NULL);
+			uqmi_add_u32("channel",
 					res.data.umts_info_v2.cell[j].utra_absolute_rf_channel_number);
-			blobmsg_add_u32(&status, "primary_scrambling_code",
+			print_band_info(QMI_BAND_RAT_UMTS, res.data.umts_info_v2.cell[j].utra_absolute_rf_channel_number);
+			uqmi_add_u32("primary_scrambling_code",
 					res.data.umts_info_v2.cell[j].primary_scrambling_code);
-			blobmsg_add_u32(&status, "rscp", res.data.umts_info_v2.cell[j].rscp);
-			blobmsg_add_u32(&status, "ecio", res.data.umts_info_v2.cell[j].ecio);
-			blobmsg_close_table(&status, cell);
+			uqmi_add_u32("rscp", res.data.umts_info_v2.cell[j].rscp);
+			uqmi_add_u32("ecio", res.data.umts_info_v2.cell[j].ecio);
+			uqmi_close_table(cell);
 		}
 		for (j = 0; j < res.data.umts_info_v2.neighboring_geran_n; j++) {
-			cell = blobmsg_open_table(&status, "neighboring_geran");
-			blobmsg_add_u32(&status, "channel",
+			cell = uqmi_open_table("neighboring_geran");
+			uqmi_add_u32("channel",
 					res.data.umts_info_v2.neighboring_geran[j].geran_absolute_rf_channel_number);
-			blobmsg_add_u8(&status, "network_color_code",
+			uqmi_add_u8("network_color_code",
 				       res.data.umts_info_v2.neighboring_geran[j].network_color_code);
-			blobmsg_add_u8(&status, "base_station_color_code",
+			uqmi_add_u8("base_station_color_code",
 				       res.data.umts_info_v2.neighboring_geran[j].base_station_color_code);
-			blobmsg_add_u32(&status, "rssi",
+			uqmi_add_u32("rssi",
 					res.data.umts_info_v2.neighboring_geran[j].rssi);
-			blobmsg_close_table(&status, cell);
+			uqmi_close_table(cell);
 		}
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 	if (res.set.intrafrequency_lte_info_v2) {
-		c = blobmsg_open_table(&status, "intrafrequency_lte_info");
-		blobmsg_add_u32(&status, "tracking_area_code",
+		c = uqmi_open_table("intrafrequency_lte_info");
+		uqmi_add_u32("tracking_area_code",
 				res.data.intrafrequency_lte_info_v2.tracking_area_code);
-		blobmsg_add_u32(&status, "enodeb_id",
+		uqmi_add_u32("enodeb_id",
 				res.data.intrafrequency_lte_info_v2.global_cell_id/256);
-		blobmsg_add_u32(&status, "cell_id",
+		uqmi_add_u32("cell_id",
 				res.data.intrafrequency_lte_info_v2.global_cell_id%256);
-		blobmsg_add_u32(&status, "channel",
+		uqmi_add_u32("channel",
 				res.data.intrafrequency_lte_info_v2.eutra_absolute_rf_channel_number);
-		print_earfcn_info(res.data.intrafrequency_lte_info_v2.eutra_absolute_rf_channel_number);
-		blobmsg_add_u32(&status, "serving_cell_id",
+		print_band_info(QMI_BAND_RAT_LTE, res.data.intrafrequency_lte_info_v2.eutra_absolute_rf_channel_number);
+		uqmi_add_u32("serving_cell_id",
 				res.data.intrafrequency_lte_info_v2.serving_cell_id);
 		if (res.data.intrafrequency_lte_info_v2.ue_in_idle) {
-			blobmsg_add_u32(&status, "cell_reselection_priority",
+			uqmi_add_u32("cell_reselection_priority",
 					res.data.intrafrequency_lte_info_v2.cell_reselection_priority);
-			blobmsg_add_u32(&status, "s_non_intra_search_threshold",
+			uqmi_add_u32("s_non_intra_search_threshold",
 					res.data.intrafrequency_lte_info_v2.s_non_intra_search_threshold);
-			blobmsg_add_u32(&status, "serving_cell_low_threshold",
+			uqmi_add_u32("serving_cell_low_threshold",
 					res.data.intrafrequency_lte_info_v2.serving_cell_low_threshold);
-			blobmsg_add_u32(&status, "s_intra_search_threshold",
+			uqmi_add_u32("s_intra_search_threshold",
 					res.data.intrafrequency_lte_info_v2.s_intra_search_threshold);
 		}
 		for (i = 0; i < res.data.intrafrequency_lte_info_v2.cell_n; i++) {
-			cell = blobmsg_open_table(&status, NULL);
+			cell = uqmi_open_table(NULL);
 			print_lte_info(res.data.intrafrequency_lte_info_v2.cell[i].physical_cell_id,
 				       res.data.intrafrequency_lte_info_v2.cell[i].rsrq,
 				       res.data.intrafrequency_lte_info_v2.cell[i].rsrp,
 				       res.data.intrafrequency_lte_info_v2.cell[i].rssi);
 			if (res.data.intrafrequency_lte_info_v2.ue_in_idle)
-				blobmsg_add_u32(&status, "cell_selection_rx_level",
+				uqmi_add_u32("cell_selection_rx_level",
 						res.data.intrafrequency_lte_info_v2.cell[i].cell_selection_rx_level);
-			blobmsg_close_table(&status, cell);
+			uqmi_close_table(cell);
 		}
-		blobmsg_close_table(&status, c);
+		uqmi_close_table(c);
 	}
 	if (res.set.interfrequency_lte_info) {
 		if (res.data.interfrequency_lte_info.frequency_n > 0)
-			c = blobmsg_open_table(&status, "interfrequency_lte_info");
+			c = uqmi_open_table("interfrequency_lte_info");
 		for (i = 0; i < res.data.interfrequency_lte_info.frequency_n; i++) {
-			freq = blobmsg_open_table(&status, NULL);
-			blobmsg_add_u32(&status, "channel",
+			freq = uqmi_open_table(NULL);
+			uqmi_add_u32("channel",
 					res.data.interfrequency_lte_info.frequency[i].eutra_absolute_rf_channel_number);
-			print_earfcn_info(res.data.interfrequency_lte_info.frequency[i].eutra_absolute_rf_channel_number);
+			print_band_info(QMI_BAND_RAT_LTE, res.data.interfrequency_lte_info.frequency[i].eutra_absolute_rf_channel_number);
 			if (res.data.interfrequency_lte_info.ue_in_idle) {
 				print_sel_info(res.data.interfrequency_lte_info.frequency[i].cell_reselection_priority,
 					       res.data.interfrequency_lte_info.frequency[i].cell_selection_rx_level_high_threshold,
 					       res.data.interfrequency_lte_info.frequency[i].cell_selection_rx_level_low_threshold);
 			}
 			for (j = 0; j < res.data.interfrequency_lte_info.frequency[i].cell_n; j++) {
-				cell = blobmsg_open_table(&status, NULL);
+				cell = uqmi_open_table(NULL);
 				print_lte_info(res.data.interfrequency_lte_info.frequency[i].cell[j].physical_cell_id,
 					       res.data.interfrequency_lte_info.frequency[i].cell[j].rsrq,
 					       res.data.interfrequency_lte_info.frequency[i].cell[j].rsrp,
 					       res.data.interfrequency_lte_info.frequency[i].cell[j].rssi);
 				if (res.data.interfrequency_lte_info.ue_in_idle)
-					blobmsg_add_u32(&status, "cell_selection_rx_level",
+					uqmi_add_u32("cell_selection_rx_level",
 							res.data.interfrequency_lte_info.frequency[i].cell[j].cell_selection_rx_level);
-				blobmsg_close_table(&status, cell);
+				uqmi_close_table(cell);
 			}
-			blobmsg_close_table(&status, freq);
+			uqmi_close_table(freq);
 		}
 		if (res.data.interfrequency_lte_info.frequency_n > 0)
-			blobmsg_close_table(&status, c);
+			uqmi_close_table(c);
 	}
 	if (res.set.lte_info_neighboring_gsm) {
 		if (res.data.lte_info_neighboring_gsm.frequency_n > 0)
-			c = blobmsg_open_table(&status, "lte_info_neighboring_gsm");
+			c = uqmi_open_table("lte_info_neighboring_gsm");
 		for (i = 0; i < res.data.lte_info_neighboring_gsm.frequency_n; i++) {
-			freq = blobmsg_open_table(&status, NULL);
-			blobmsg_add_u32(&status, "ncc_permitted",
+			freq = uqmi_open_table(NULL);
+			uqmi_add_u32("ncc_permitted",
 					res.data.lte_info_neighboring_gsm.frequency[i].ncc_permitted);
 			if (res.data.lte_info_neighboring_gsm.ue_in_idle) {
 				print_sel_info(res.data.lte_info_neighboring_gsm.frequency[i].cell_reselection_priority,
@@ -939,94 +915,96 @@ cmd_nas_get_cell_location_info_cb(struct qmi_dev *qmi, struct qmi_request *req,
 					       res.data.lte_info_neighboring_gsm.frequency[i].cell_reselection_low_threshold);
 			}
 			for (j = 0; j < res.data.lte_info_neighboring_gsm.frequency[i].cell_n; j++) {
-				cell = blobmsg_open_table(&status, NULL);
-				blobmsg_add_u32(&status, "channel",
+				cell = uqmi_open_table(NULL);
+				uqmi_add_u32("channel",
 						res.data.lte_info_neighboring_gsm.frequency[i].cell[j].geran_absolute_rf_channel_number);
-				blobmsg_add_u32(&status, "base_station_identity_code",
+				uqmi_add_u32("base_station_identity_code",
 						res.data.lte_info_neighboring_gsm.frequency[i].cell[j].base_station_identity_code);
-				blobmsg_add_double(&status, "rssi",
+				uqmi_add_double("rssi",
 						   ((double)res.data.lte_info_neighboring_gsm.frequency[i].cell[j].rssi)/10);
 				if (res.data.lte_info_neighboring_gsm.ue_in_idle)
-					blobmsg_add_u32(&status, "cell_selection_rx_level",
+					uqmi_add_u32("cell_selection_rx_level",
 							res.data.lte_info_neighboring_gsm.frequency[i].cell[j].cell_selection_rx_level);
-				blobmsg_close_table(&status, cell);
+				uqmi_close_table(cell);
 			}
-			blobmsg_close_table(&status, freq);
+			uqmi_close_table(freq);
 		}
 		if (res.data.lte_info_neighboring_gsm.frequency_n > 0)
-			blobmsg_close_table(&status, c);
+			uqmi_close_table(c);
 	}
 	if (res.set.lte_info_neighboring_wcdma) {
 		if (res.data.lte_info_neighboring_wcdma.frequency_n > 0)
-			c = blobmsg_open_table(&status, "lte_info_neighboring_wcdma");
+			c = uqmi_open_table("lte_info_neighboring_wcdma");
 		for (i = 0; i < res.data.lte_info_neighboring_wcdma.frequency_n; i++) {
-			freq = blobmsg_open_table(&status, NULL);
-			blobmsg_add_u32(&status, "channel",
+			freq = uqmi_open_table(NULL);
+			uqmi_add_u32("channel",
 					res.data.lte_info_neighboring_wcdma.frequency[i].utra_absolute_rf_channel_number);
+			print_band_info(QMI_BAND_RAT_UMTS, res.data.lte_info_neighboring_wcdma.frequency[i].utra_absolute_rf_channel_number);
 			if (res.data.lte_info_neighboring_wcdma.ue_in_idle) {
 				print_sel_info(res.data.lte_info_neighboring_wcdma.frequency[i].cell_reselection_priority,
 					       res.data.lte_info_neighboring_wcdma.frequency[i].cell_reselection_high_threshold,
 					       res.data.lte_info_neighboring_wcdma.frequency[i].cell_reselection_low_threshold);
 			}
 			for (j = 0; j < res.data.lte_info_neighboring_wcdma.frequency[i].cell_n; j++) {
-				cell = blobmsg_open_table(&status, NULL);
-				blobmsg_add_u32(&status, "primary_scrambling_code",
+				cell = uqmi_open_table(NULL);
+				uqmi_add_u32("primary_scrambling_code",
 						res.data.lte_info_neighboring_wcdma.frequency[i].cell[j].primary_scrambling_code);
-				blobmsg_add_double(&status, "rscp",
+				uqmi_add_double("rscp",
 						   ((double)res.data.lte_info_neighboring_wcdma.frequency[i].cell[j].cpich_rscp)/10);
-				blobmsg_add_double(&status, "ecno",
+				uqmi_add_double("ecno",
 						   ((double)res.data.lte_info_neighboring_wcdma.frequency[i].cell[j].cpich_ecno)/10);
 				if (res.data.lte_info_neighboring_wcdma.ue_in_idle)
-					blobmsg_add_u32(&status, "cell_selection_rx_level",
+					uqmi_add_u32("cell_selection_rx_level",
 							res.data.lte_info_neighboring_wcdma.frequency[i].cell[j].cell_selection_rx_level);
-				blobmsg_close_table(&status, cell);
+				uqmi_close_table(cell);
 			}
-			blobmsg_close_table(&status, freq);
+			uqmi_close_table(freq);
 		}
 		if (res.data.lte_info_neighboring_wcdma.frequency_n > 0)
-			blobmsg_close_table(&status, c);
+			uqmi_close_table(c);
 	}
 	if (res.set.umts_info_neighboring_lte) {
 		if (res.data.umts_info_neighboring_lte.frequency_n > 0)
-			c = blobmsg_open_table(&status, "umts_info_neighboring_lte");
+			c = uqmi_open_table("umts_info_neighboring_lte");
 		for (i = 0; i < res.data.umts_info_neighboring_lte.frequency_n; i++) {
-			freq = blobmsg_open_table(&status, NULL);
-			blobmsg_add_u32(&status, "channel",
+			freq = uqmi_open_table(NULL);
+			uqmi_add_u32("channel",
 					res.data.umts_info_neighboring_lte.frequency[i].eutra_absolute_rf_channel_number);
-			print_earfcn_info(res.data.umts_info_neighboring_lte.frequency[i].eutra_absolute_rf_channel_number);
-			blobmsg_add_u32(&status, "physical_cell_id",
+			print_band_info(QMI_BAND_RAT_LTE, res.data.umts_info_neighboring_lte.frequency[i].eutra_absolute_rf_channel_number);
+			uqmi_add_u32("physical_cell_id",
 					res.data.umts_info_neighboring_lte.frequency[i].physical_cell_id);
-			blobmsg_add_double(&status, "rsrp",
+			uqmi_add_double("rsrp",
 					   (double) res.data.umts_info_neighboring_lte.frequency[i].rsrp);
-			blobmsg_add_double(&status, "rsrq",
+			uqmi_add_double("rsrq",
 					   (double) res.data.umts_info_neighboring_lte.frequency[i].rsrq);
-			blobmsg_add_u32(&status, "cell_selection_rx_level",
+			uqmi_add_u32("cell_selection_rx_level",
 					res.data.umts_info_neighboring_lte.frequency[i].cell_selection_rx_level);
-			blobmsg_close_table(&status, freq);
+			uqmi_close_table(freq);
 		}
 		if (res.data.umts_info_neighboring_lte.frequency_n > 0)
-			blobmsg_close_table(&status, c);
+			uqmi_close_table(c);
 	}
 	if (res.set.nr5g_cell_information) {
-		c = blobmsg_open_table(&status, "nr5g_cell_information");
-		blobmsg_add_u32(&status, "enodeb_id",
+		c = uqmi_open_table("nr5g_cell_information");
+		uqmi_add_u32("enodeb_id",
 				res.data.nr5g_cell_information.global_cell_id/256);
-		blobmsg_add_u32(&status, "cell_id",
+		uqmi_add_u32("cell_id",
 				res.data.nr5g_cell_information.global_cell_id%256);
-		blobmsg_add_u32(&status, "physical_cell_id",
+		uqmi_add_u32("physical_cell_id",
 				res.data.nr5g_cell_information.physical_cell_id);
-		blobmsg_add_double(&status, "rsrq", ((double)res.data.nr5g_cell_information.rsrq)/10);
-		blobmsg_add_double(&status, "rsrp", ((double)res.data.nr5g_cell_information.rsrp)/10);
-		blobmsg_add_double(&status, "snr", ((double)res.data.nr5g_cell_information.snr)/10);
-		blobmsg_close_table(&status, c);
+		uqmi_add_double("rsrq", ((double)res.data.nr5g_cell_information.rsrq)/10);
+		uqmi_add_double("rsrp", ((double)res.data.nr5g_cell_information.rsrp)/10);
+		uqmi_add_double("snr", ((double)res.data.nr5g_cell_information.snr)/10);
+		uqmi_close_table(c);
 	}
 	if (res.set.nr5g_arfcn) {
-		c = blobmsg_open_table(&status, "nr5g_arfcn");
-		blobmsg_add_u32(&status, "arfcn",
+		c = uqmi_open_table("nr5g_arfcn");
+		uqmi_add_u32("arfcn",
 				res.data.nr5g_arfcn);
-		blobmsg_close_table(&status, c);
+		print_band_info(QMI_BAND_RAT_NR, res.data.nr5g_arfcn);
+		uqmi_close_table(c);
 	}
-	blobmsg_close_table(&status, t);
+	uqmi_close_table(t);
 }
 
 static enum qmi_cmd_result
@@ -1036,6 +1014,342 @@ cmd_nas_get_cell_location_info_prepare(struct qmi_dev *qmi, struct qmi_request *
 	return QMI_CMD_REQUEST;
 }
 
+/*
+ * --get-neighbor-cells lists the cells of the cell location info as one
+ * flat array, sorted by RAT, channel and PCI/PSC/BSIC. The list is kept,
+ * and --get-cell-changes <dB> only prints the cells added, removed or
+ * with a value changed by at least <dB> since the kept list, which it then
+ * replaces. The list lasts for the life of the process, i.e. across
+ * --batch lines and uqmi --server clients.
+ */
+#define NAS_CELL_NONE	INT16_MIN
+
+struct nas_cell {
+	int8_t rat;
+	uint16_t id;
+	uint32_t channel;
+	/* 0.1 dB(m) */
+	int16_t rssi;
+	int16_t rsrp;
+	int16_t rsrq;
+	int16_t rscp;
+	int16_t ecio;
+	int16_t snr;
+};
+
+struct nas_cells {
+	struct nas_cell *cell;
+	int n, size;
+};
+
+static struct nas_cells nas_cells_prev;
+
+static struct nas_cell *
+nas_cells_add(struct nas_cells *cells, int8_t rat, uint32_t channel, uint16_t id)
+{
+	struct nas_cell *cell;
+
+	if (cells->n == cells->size) {
+		int size = cells->size ? cells->size * 2 : 32;
+
+		cell = realloc(cells->cell, size * sizeof(*cell));
+		if (!cell)
+			return NULL;
+
+		cells->cell = cell;
+		cells->size = size;
+	}
+
+	cell = &cells->cell[cells->n++];
+	cell->rat = rat;
+	cell->channel = channel;
+	cell->id = id;
+	cell->rssi = cell->rsrp = cell->rsrq = NAS_CELL_NONE;
+	cell->rscp = cell->ecio = cell->snr = NAS_CELL_NONE;
+
+	return cell;
+}
+
+static int
+nas_cell_cmp(const void *a, const void *b)
+{
+	const struct nas_cell *ca = a, *cb = b;
+
+	if (ca->rat != cb->rat)
+		return ca->rat - cb->rat;
+	if (ca->channel != cb->channel)
+		return ca->channel < cb->channel ? -1 : 1;
+	return ca->id - cb->id;
+}
+
+static void
+nas_cells_decode(struct nas_cells *cells, struct qmi_nas_get_cell_location_info_response *res)
+{
+	struct nas_cell *cell;
+	int i, j;
+
+	if (res->set.umts_info_v2) {
+		typeof(res->data.umts_info_v2) *umts = &res->data.umts_info_v2;
+
+		for (i = 0; i < umts->cell_n; i++) {
+			cell = nas_cells_add(cells, QMI_NAS_RADIO_INTERFACE_UMTS,
+					     umts->cell[i].utra_absolute_rf_channel_number,
+					     umts->cell[i].primary_scrambling_code);
+			if (!cell)
+				return;
+			cell->rscp = umts->cell[i].rscp * 10;
+			cell->ecio = umts->cell[i].ecio * 10;
+		}
+
+		for (i = 0; i < umts->neighboring_geran_n; i++) {
+			cell = nas_cells_add(cells, QMI_NAS_RADIO_INTERFACE_GSM,
+					     umts->neighboring_geran[i].geran_absolute_rf_channel_number,
+					     umts->neighboring_geran[i].network_color_code << 3 |
+					     umts->neighboring_geran[i].base_station_color_code);
+			if (!cell)
+				return;
+			cell->rssi = umts->neighboring_geran[i].rssi * 10;
+		}
+	}
+
+	if (res->set.intrafrequency_lte_info_v2) {
+		typeof(res->data.intrafrequency_lte_info_v2) *lte = &res->data.intrafrequency_lte_info_v2;
+
+		for (i = 0; i < lte->cell_n; i++) {
+			cell = nas_cells_add(cells, QMI_NAS_RADIO_INTERFACE_LTE,
+					     lte->eutra_absolute_rf_channel_number,
+					     lte->cell[i].physical_cell_id);
+			if (!cell)
+				return;
+			cell->rssi = lte->cell[i].rssi;
+			cell->rsrp = lte->cell[i].rsrp;
+			cell->rsrq = lte->cell[i].rsrq;
+		}
+	}
+
+	if (res->set.interfrequency_lte_info) {
+		typeof(res->data.interfrequency_lte_info) *lte = &res->data.interfrequency_lte_info;
+
+		for (i = 0; i < lte->frequency_n; i++) {
+			for (j = 0; j < lte->frequency[i].cell_n; j++) {
+				cell = nas_cells_add(cells, QMI_NAS_RADIO_INTERFACE_LTE,
+						     lte->frequency[i].eutra_absolute_rf_channel_number,
+						     lte->frequency[i].cell[j].physical_cell_id);
+				if (!cell)
+					return;
+				cell->rssi = lte->frequency[i].cell[j].rssi;
+				cell->rsrp = lte->frequency[i].cell[j].rsrp;
+				cell->rsrq = lte->frequency[i].cell[j].rsrq;
+			}
+		}
+	}
+
+	if (res->set.lte_info_neighboring_gsm) {
+		typeof(res->data.lte_info_neighboring_gsm) *gsm = &res->data.lte_info_neighboring_gsm;
+
+		for (i = 0; i < gsm->frequency_n; i++) {
+			for (j = 0; j < gsm->frequency[i].cell_n; j++) {
+				cell = nas_cells_add(cells, QMI_NAS_RADIO_INTERFACE_GSM,
+						     gsm->frequency[i].cell[j].geran_absolute_rf_channel_number,
+						     gsm->frequency[i].cell[j].base_station_identity_code);
+				if (!cell)
+					return;
+				cell->rssi = gsm->frequency[i].cell[j].rssi;
+			}
+		}
+	}
+
+	if (res->set.lte_info_neighboring_wcdma) {
+		typeof(res->data.lte_info_neighboring_wcdma) *wcdma = &res->data.lte_info_neighboring_wcdma;
+
+		for (i = 0; i < wcdma->frequency_n; i++) {
+			for (j = 0; j < wcdma->frequency[i].cell_n; j++) {
+				cell = nas_cells_add(cells, QMI_NAS_RADIO_INTERFACE_UMTS,
+						     wcdma->frequency[i].utra_absolute_rf_channel_number,
+						     wcdma->frequency[i].cell[j].primary_scrambling_code);
+				if (!cell)
+					return;
+				cell->rscp = wcdma->frequency[i].cell[j].cpich_rscp;
+				cell->ecio = wcdma->frequency[i].cell[j].cpich_ecno;
+			}
+		}
+	}
+
+	if (res->set.umts_info_neighboring_lte) {
+		typeof(res->data.umts_info_neighboring_lte) *lte = &res->data.umts_info_neighboring_lte;
+
+		for (i = 0; i < lte->frequency_n; i++) {
+			cell = nas_cells_add(cells, QMI_NAS_RADIO_INTERFACE_LTE,
+					     lte->frequency[i].eutra_absolute_rf_channel_number,
+					     lte->frequency[i].physical_cell_id);
+			if (!cell)
+				return;
+			cell->rsrp = lte->frequency[i].rsrp * 10;
+			cell->rsrq = lte->frequency[i].rsrq * 10;
+		}
+	}
+
+	if (res->set.nr5g_cell_information) {
+		cell = nas_cells_add(cells, QMI_NAS_RADIO_INTERFACE_5GNR,
+				     res->set.nr5g_arfcn ? res->data.nr5g_arfcn : 0,
+				     res->data.nr5g_cell_information.physical_cell_id);
+		if (!cell)
+			return;
+		cell->rsrp = res->data.nr5g_cell_information.rsrp;
+		cell->rsrq = res->data.nr5g_cell_information.rsrq;
+		cell->snr = res->data.nr5g_cell_information.snr;
+	}
+
+	qsort(cells->cell, cells->n, sizeof(*cells->cell), nas_cell_cmp);
+}
+
+static void
+nas_cell_add_value(const char *name, int16_t val)
+{
+	if (val != NAS_CELL_NONE)
+		uqmi_add_double(name, (double) val / 10);
+}
+
+static void
+nas_cell_print(const struct nas_cell *cell, bool values)
+{
+	void *c = uqmi_open_table(NULL);
+
+	uqmi_add_string("rat", print_radio_interface(cell->rat));
+	uqmi_add_u32("channel", cell->channel);
+	print_band_info(qmi_band_rat_from_radio_interface(cell->rat), cell->channel);
+	uqmi_add_u32("id", cell->id);
+	if (values) {
+		nas_cell_add_value("rssi", cell->rssi);
+		nas_cell_add_value("rsrp", cell->rsrp);
+		nas_cell_add_value("rsrq", cell->rsrq);
+		nas_cell_add_value("rscp", cell->rscp);
+		nas_cell_add_value("ecio", cell->ecio);
+		nas_cell_add_value("snr", cell->snr);
+	}
+	uqmi_close_table(c);
+}
+
+static bool
+nas_cell_value_changed(int16_t a, int16_t b, int threshold)
+{
+	/* a threshold of 0 reports every change */
+	if (a == NAS_CELL_NONE || b == NAS_CELL_NONE || !threshold)
+		return a != b;
+
+	return abs(a - b) >= threshold;
+}
+
+static bool
+nas_cell_changed(const struct nas_cell *a, const struct nas_cell *b, int threshold)
+{
+	return nas_cell_value_changed(a->rssi, b->rssi, threshold) ||
+	       nas_cell_value_changed(a->rsrp, b->rsrp, threshold) ||
+	       nas_cell_value_changed(a->rsrq, b->rsrq, threshold) ||
+	       nas_cell_value_changed(a->rscp, b->rscp, threshold) ||
+	       nas_cell_value_changed(a->ecio, b->ecio, threshold) ||
+	       nas_cell_value_changed(a->snr, b->snr, threshold);
+}
+
+/* both lists are sorted, so a single pass over them finds the differences */
+static void
+nas_cells_print_changes(const struct nas_cells *prev, const struct nas_cells *cur,
+			int threshold)
+{
+	void *added, *removed, *changed;
+	int cmp, i, j;
+
+	added = uqmi_open_array("added");
+	for (i = 0, j = 0; j < cur->n; j++) {
+		while (i < prev->n && nas_cell_cmp(&prev->cell[i], &cur->cell[j]) < 0)
+			i++;
+		if (i == prev->n || nas_cell_cmp(&prev->cell[i], &cur->cell[j]) > 0)
+			nas_cell_print(&cur->cell[j], true);
+	}
+	uqmi_close_array(added);
+
+	removed = uqmi_open_array("removed");
+	for (i = 0, j = 0; i < prev->n; i++) {
+		while (j < cur->n && nas_cell_cmp(&cur->cell[j], &prev->cell[i]) < 0)
+			j++;
+		if (j == cur->n || nas_cell_cmp(&cur->cell[j], &prev->cell[i]) > 0)
+			nas_cell_print(&prev->cell[i], false);
+	}
+	uqmi_close_array(removed);
+
+	changed = uqmi_open_array("changed");
+	for (i = 0, j = 0; i < prev->n && j < cur->n; ) {
+		cmp = nas_cell_cmp(&prev->cell[i], &cur->cell[j]);
+		if (cmp < 0) {
+			i++;
+		} else if (cmp > 0) {
+			j++;
+		} else {
+			if (nas_cell_changed(&prev->cell[i], &cur->cell[j], threshold))
+				nas_cell_print(&cur->cell[j], true);
+			i++;
+			j++;
+		}
+	}
+	uqmi_close_array(changed);
+}
+
+/* < 0: print all cells, otherwise the changes by at least threshold (0.1 dB) */
+static void
+nas_cells_update(struct qmi_msg *msg, int threshold)
+{
+	struct qmi_nas_get_cell_location_info_response res;
+	struct nas_cells cur = {};
+	void *c;
+	int i;
+
+	qmi_parse_nas_get_cell_location_info_response(msg, &res);
+	nas_cells_decode(&cur, &res);
+
+	if (threshold < 0) {
+		c = uqmi_open_array(NULL);
+		for (i = 0; i < cur.n; i++)
+			nas_cell_print(&cur.cell[i], true);
+		uqmi_close_array(c);
+	} else {
+		c = uqmi_open_table(NULL);
+		nas_cells_print_changes(&nas_cells_prev, &cur, threshold);
+		uqmi_close_table(c);
+	}
+
+	free(nas_cells_prev.cell);
+	nas_cells_prev = cur;
+}
+
+static void
+cmd_nas_get_neighbor_cells_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	nas_cells_update(msg, -1);
+}
+
+#define cmd_nas_get_neighbor_cells_prepare cmd_nas_get_cell_location_info_prepare
+
+/* the threshold comes with the request, queries of several lines overlap */
+static void
+cmd_nas_get_cell_changes_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	nas_cells_update(msg, (long) req->cb_data);
+}
+
+static enum qmi_cmd_result
+cmd_nas_get_cell_changes_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
+{
+	char *err;
+	double db = strtod(arg, &err);
+
+	if (*err || db < 0)
+		return uqmi_add_error("Invalid argument");
+
+	req->cb_data = (void *) (long) (db * 10 + 0.5);
+	qmi_set_nas_get_cell_location_info_request(msg);
+	return QMI_CMD_REQUEST;
+}
+
 static enum qmi_cmd_result
 cmd_nas_get_signal_info_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
@@ -1046,7 +1360,9 @@ cmd_nas_get_signal_info_prepare(struct qmi_dev *qmi, struct qmi_request *req, st
 static void
 cmd_nas_get_serving_system_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
 {
-	struct qmi_nas_get_serving_system_response res;
+	struct qmi_nas_get_serving_system_response_view view;
+	struct qmi_nas_get_serving_system_response res = {};
+	struct qmi_arena *arena = qmi_default_arena();
 	static const char *reg_states[] = {
 		[QMI_NAS_REGISTRATION_STATE_NOT_REGISTERED] = "not_registered",
 		[QMI_NAS_REGISTRATION_STATE_REGISTERED] = "registered",
@@ -1056,36 +1372,41 @@ cmd_nas_get_serving_system_cb(struct qmi_dev *qmi, struct qmi_request *req, stru
 	};
 	void *c, *a;
 
-	qmi_parse_nas_get_serving_system_response(msg, &res);
+	/* only decode the TLVs printed below */
+	qmi_arena_reset(arena);
+	qmi_view_nas_get_serving_system_response(msg, &view);
+	qmi_view_nas_get_serving_system_response_serving_system(&view, &res, arena);
+	qmi_view_nas_get_serving_system_response_current_plmn(&view, &res, arena);
+	qmi_view_nas_get_serving_system_response_roaming_indicator(&view, &res, arena);
 
-	c = blobmsg_open_table(&status, NULL);
+	c = uqmi_open_table(NULL);
 	if (res.set.serving_system) {
 		int state = res.data.serving_system.registration_state;
 
 		if (state > QMI_NAS_REGISTRATION_STATE_UNKNOWN)
 			state = QMI_NAS_REGISTRATION_STATE_UNKNOWN;
 
-		blobmsg_add_string(&status, "registration", reg_states[state]);
+		uqmi_add_string("registration", reg_states[state]);
 
-		a = blobmsg_open_array(&status, "radio_interface");
+		a = uqmi_open_array("radio_interface");
 		for (int i = 0; i < res.data.serving_system.radio_interfaces_n; i++) {
 			int8_t r_i = res.data.serving_system.radio_interfaces[i];
 
-			blobmsg_add_string(&status, "radio", print_radio_interface(r_i));
+			uqmi_add_string("radio", print_radio_interface(r_i));
 		}
-		blobmsg_close_array(&status, a);
+		uqmi_close_array(a);
 	}
 	if (res.set.current_plmn) {
-		blobmsg_add_u32(&status, "plmn_mcc", res.data.current_plmn.mcc);
-		blobmsg_add_u32(&status, "plmn_mnc", res.data.current_plmn.mnc);
+		uqmi_add_u32("plmn_mcc", res.data.current_plmn.mcc);
+		uqmi_add_u32("plmn_mnc", res.data.current_plmn.mnc);
 		if (res.data.current_plmn.description)
-			blobmsg_add_string(&status, "plmn_description", res.data.current_plmn.description);
+			uqmi_add_string("plmn_description", res.data.current_plmn.description);
 	}
 
 	if (res.set.roaming_indicator)
-		blobmsg_add_u8(&status, "roaming", !res.data.roaming_indicator);
+		uqmi_add_u8("roaming", !res.data.roaming_indicator);
 
-	blobmsg_close_table(&status, c);
+	uqmi_close_table(c);
 }
 
 static enum qmi_cmd_result
@@ -1099,24 +1420,22 @@ static void
 cmd_nas_get_plmn_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
 {
 	struct qmi_nas_get_system_selection_preference_response res;
-	static const char *modes[] = {
-		[QMI_NAS_NETWORK_SELECTION_PREFERENCE_AUTOMATIC] = "automatic",
-		[QMI_NAS_NETWORK_SELECTION_PREFERENCE_MANUAL] = "manual",
-	};
 	void *c;
 
 	qmi_parse_nas_get_system_selection_preference_response(msg, &res);
 
-	c = blobmsg_open_table(&status, NULL);
+	c = uqmi_open_table(NULL);
 	if (res.set.network_selection_preference) {
-		blobmsg_add_string(&status, "mode", modes[res.data.network_selection_preference]);
+		uqmi_add_string("mode",
+				   enum_name(&qmi_nas_network_selection_preference_names,
+					     res.data.network_selection_preference));
 	}
 	if (res.set.manual_network_selection) {
-		blobmsg_add_u32(&status, "mcc", res.data.manual_network_selection.mcc);
-		blobmsg_add_u32(&status, "mnc", res.data.manual_network_selection.mnc);
+		uqmi_add_u32("mcc", res.data.manual_network_selection.mcc);
+		uqmi_add_u32("mnc", res.data.manual_network_selection.mnc);
 	}
 
-	blobmsg_close_table(&status, c);
+	uqmi_close_table(c);
 }
 
 static enum qmi_cmd_result
@@ -1126,10 +1445,51 @@ cmd_nas_get_plmn_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qm
 	return QMI_CMD_REQUEST;
 }
 
+/*
+ * With --stream, every entry of the scan result is a line of its own,
+ * {"network_info":{...}} or {"radio_access_technology":{...}}, written out
+ * as soon as it is decoded.
+ */
+static void *
+nas_scan_open_list(const char *name)
+{
+	return uqmi_stream ? NULL : uqmi_open_array(name);
+}
+
+static void
+nas_scan_close_list(void *c)
+{
+	if (!uqmi_stream)
+		uqmi_close_array(c);
+}
+
+static void *
+nas_scan_open_entry(const char *list, void **record)
+{
+	if (!uqmi_stream)
+		return uqmi_open_table(NULL);
+
+	*record = uqmi_open_table(NULL);
+	return uqmi_open_table(list);
+}
+
+static void
+nas_scan_close_entry(void *info, void *record)
+{
+	uqmi_close_table(info);
+	if (uqmi_stream)
+		uqmi_close_table(record);
+}
+
 static void
 cmd_nas_network_scan_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
 {
-	static struct qmi_nas_network_scan_response res;
+	struct qmi_nas_network_scan_response_view view;
+	struct qmi_nas_network_scan_response *res = NULL;
+	typeof(*res->data.network_information) net;
+	typeof(*res->data.radio_access_technology) rat;
+	struct qmi_arena *arena = qmi_default_arena();
+	struct qmi_tlv_iter iter;
 	const char *network_status[] = {
 		"current_serving",
 		"available",
@@ -1140,58 +1500,98 @@ cmd_nas_network_scan_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi
 		"preferred",
 		"not_preferred",
 	};
-	void *t, *c, *info, *stat;
-	int i, j;
-
-	qmi_parse_nas_network_scan_response(msg, &res);
-
-	t = blobmsg_open_table(&status, NULL);
-
-	c = blobmsg_open_array(&status, "network_info");
-	for (i = 0; i < res.data.network_information_n; i++) {
-		info = blobmsg_open_table(&status, NULL);
-		blobmsg_add_u32(&status, "mcc", res.data.network_information[i].mcc);
-		blobmsg_add_u32(&status, "mnc", res.data.network_information[i].mnc);
-		if (res.data.network_information[i].description)
-			blobmsg_add_string(&status, "description", res.data.network_information[i].description);
-		stat = blobmsg_open_array(&status, "status");
+	void *t, *c, *info, *stat, *record = NULL;
+	int j;
+
+	/* scans can list many networks, decode them one at a time */
+	qmi_view_nas_network_scan_response(msg, &view);
+
+	/* a top level array makes each entry a line of its own */
+	t = uqmi_stream ? uqmi_open_array(NULL) : uqmi_open_table(NULL);
+
+	c = nas_scan_open_list("network_info");
+	qmi_view_nas_network_scan_response_network_information_iter(&view, &iter);
+	qmi_arena_reset(arena);
+	while (!qmi_view_nas_network_scan_response_network_information_next(&iter, &net, arena)) {
+		info = nas_scan_open_entry("network_info", &record);
+		uqmi_add_u32("mcc", net.mcc);
+		uqmi_add_u32("mnc", net.mnc);
+		if (net.description)
+			uqmi_add_string("description", net.description);
+		stat = uqmi_open_array("status");
 		for (j = 0; j < ARRAY_SIZE(network_status); j++) {
-			if (!(res.data.network_information[i].network_status & (1 << j)))
+			if (!(net.network_status & (1 << j)))
 				continue;
 
-			blobmsg_add_string(&status, NULL, network_status[j]);
+			uqmi_add_string(NULL, network_status[j]);
 		}
-		blobmsg_close_array(&status, stat);
-		blobmsg_close_table(&status, info);
+		uqmi_close_array(stat);
+		nas_scan_close_entry(info, record);
+		qmi_arena_reset(arena);
 	}
-	blobmsg_close_array(&status, c);
-
-	c = blobmsg_open_array(&status, "radio_access_technology");
-	for (i = 0; i < res.data.radio_access_technology_n; i++) {
-		int8_t r_i = res.data.radio_access_technology[i].radio_interface;
-
-		info = blobmsg_open_table(&status, NULL);
-		blobmsg_add_u32(&status, "mcc", res.data.radio_access_technology[i].mcc);
-		blobmsg_add_u32(&status, "mnc", res.data.radio_access_technology[i].mnc);
-		blobmsg_add_string(&status, "radio", print_radio_interface(r_i));
-		blobmsg_close_table(&status, info);
+	nas_scan_close_list(c);
+
+	c = nas_scan_open_list("radio_access_technology");
+	qmi_view_nas_network_scan_response_radio_access_technology_iter(&view, &iter);
+	while (!qmi_view_nas_network_scan_response_radio_access_technology_next(&iter, &rat, NULL)) {
+		info = nas_scan_open_entry("radio_access_technology", &record);
+		uqmi_add_u32("mcc", rat.mcc);
+		uqmi_add_u32("mnc", rat.mnc);
+		uqmi_add_string("radio", print_radio_interface(rat.radio_interface));
+		nas_scan_close_entry(info, record);
 	}
-	blobmsg_close_array(&status, c);
+	nas_scan_close_list(c);
 
-	blobmsg_close_table(&status, t);
+	if (uqmi_stream)
+		uqmi_close_array(t);
+	else
+		uqmi_close_table(t);
 }
 
 static enum qmi_cmd_result
 cmd_nas_network_scan_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
-	struct qmi_nas_network_scan_request sreq = {
-		QMI_INIT(network_type,
-	             QMI_NAS_NETWORK_SCAN_TYPE_GSM |
-	             QMI_NAS_NETWORK_SCAN_TYPE_UMTS |
-	             QMI_NAS_NETWORK_SCAN_TYPE_LTE |
-	             QMI_NAS_NETWORK_SCAN_TYPE_TD_SCDMA),
+	qmi_set_nas_network_scan_request(msg, &scan_req);
+	return QMI_CMD_REQUEST;
+}
+
+#define cmd_nas_set_scan_modes_cb no_cb
+static enum qmi_cmd_result
+cmd_nas_set_scan_modes_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
+{
+	static const struct {
+		const char *name;
+		QmiNasNetworkScanType val;
+	} modes[] = {
+		{ "gsm", QMI_NAS_NETWORK_SCAN_TYPE_GSM },
+		{ "umts", QMI_NAS_NETWORK_SCAN_TYPE_UMTS },
+		{ "lte", QMI_NAS_NETWORK_SCAN_TYPE_LTE },
+		{ "td-scdma", QMI_NAS_NETWORK_SCAN_TYPE_TD_SCDMA },
 	};
+	QmiNasNetworkScanType val = 0;
+	char *word;
+	int i;
 
-	qmi_set_nas_network_scan_request(msg, &sreq);
-	return QMI_CMD_REQUEST;
+	for (word = strtok(arg, ",");
+	     word;
+	     word = strtok(NULL, ",")) {
+		bool found = false;
+
+		for (i = 0; i < ARRAY_SIZE(modes); i++) {
+			if (strcmp(word, modes[i].name) != 0 &&
+				strcmp(word, "all") != 0)
+				continue;
+
+			val |= modes[i].val;
+			found = true;
+		}
+
+		if (!found) {
+			uqmi_add_error("Invalid network mode");
+			return QMI_CMD_EXIT;
+		}
+	}
+
+	qmi_set(&scan_req, network_type, val);
+	return QMI_CMD_DONE;
 }
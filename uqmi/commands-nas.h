@@ -20,22 +20,25 @@
  */
 
 #define __uqmi_nas_commands \
-	__uqmi_command(nas_do_set_system_selection, __set-system-selection, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_set_network_modes, set-network-modes, required, CMD_TYPE_OPTION), \
-	__uqmi_command(nas_initiate_network_register, network-register, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_set_plmn, set-plmn, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_get_plmn, get-plmn, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_set_mcc, mcc, required, CMD_TYPE_OPTION), \
-	__uqmi_command(nas_set_mnc, mnc, required, CMD_TYPE_OPTION), \
-	__uqmi_command(nas_network_scan, network-scan, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_get_signal_info, get-signal-info, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_get_serving_system, get-serving-system, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_set_network_preference, set-network-preference, required, CMD_TYPE_OPTION), \
-	__uqmi_command(nas_set_roaming, set-network-roaming, required, CMD_TYPE_OPTION), \
-	__uqmi_command(nas_get_system_info, get-system-info, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_get_lte_cphy_ca_info, get-lte-cphy-ca-info, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_get_cell_location_info, get-cell-location-info, no, QMI_SERVICE_NAS), \
-	__uqmi_command(nas_get_tx_rx_info, get-tx-rx-info, required, QMI_SERVICE_NAS) \
+	__uqmi_command(nas_do_set_system_selection, __set-system-selection, no, QMI_SERVICE_NAS, CMD_STATE(sel_req) | CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(nas_set_network_modes, set-network-modes, required, CMD_TYPE_OPTION, 0, CMD_STATE(sel_req)), \
+	__uqmi_command(nas_initiate_network_register, network-register, no, QMI_SERVICE_NAS, CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(nas_set_plmn, set-plmn, no, QMI_SERVICE_NAS, CMD_STATE(plmn_code_flag) | CMD_STATE(sel_req) | CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(nas_get_plmn, get-plmn, no, QMI_SERVICE_NAS, CMD_SERVICE, 0), \
+	__uqmi_command(nas_set_mcc, mcc, required, CMD_TYPE_OPTION, 0, CMD_STATE(plmn_code_flag) | CMD_STATE(sel_req)), \
+	__uqmi_command(nas_set_mnc, mnc, required, CMD_TYPE_OPTION, 0, CMD_STATE(plmn_code_flag) | CMD_STATE(sel_req)), \
+	__uqmi_command(nas_network_scan, network-scan, no, QMI_SERVICE_NAS, CMD_STATE(scan_req) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(nas_set_scan_modes, scan-modes, required, CMD_TYPE_OPTION, 0, CMD_STATE(scan_req)), \
+	__uqmi_command(nas_get_signal_info, get-signal-info, no, QMI_SERVICE_NAS, CMD_SERVICE, 0), \
+	__uqmi_command(nas_get_serving_system, get-serving-system, no, QMI_SERVICE_NAS, CMD_SERVICE, 0), \
+	__uqmi_command(nas_set_network_preference, set-network-preference, required, CMD_TYPE_OPTION, 0, CMD_STATE(sel_req)), \
+	__uqmi_command(nas_set_roaming, set-network-roaming, required, CMD_TYPE_OPTION, 0, CMD_STATE(sel_req)), \
+	__uqmi_command(nas_get_system_info, get-system-info, no, QMI_SERVICE_NAS, CMD_SERVICE, 0), \
+	__uqmi_command(nas_get_lte_cphy_ca_info, get-lte-cphy-ca-info, no, QMI_SERVICE_NAS, CMD_SERVICE, 0), \
+	__uqmi_command(nas_get_cell_location_info, get-cell-location-info, no, QMI_SERVICE_NAS, CMD_SERVICE, 0), \
+	__uqmi_command(nas_get_neighbor_cells, get-neighbor-cells, no, QMI_SERVICE_NAS, CMD_SERVICE, 0), \
+	__uqmi_command(nas_get_cell_changes, get-cell-changes, required, QMI_SERVICE_NAS, CMD_SERVICE, 0), \
+	__uqmi_command(nas_get_tx_rx_info, get-tx-rx-info, required, QMI_SERVICE_NAS, CMD_STATE(tx_rx_req) | CMD_SERVICE, 0) \
 
 #define nas_helptext \
 		"  --set-network-modes <modes>:      Set usable network modes (Syntax: <mode1>[,<mode2>,...])\n" \
@@ -45,6 +48,8 @@
 		"  --set-network-roaming <mode>:     Set roaming preference:\n" \
 		"                                    Available modes: any, off, only\n" \
 		"  --network-scan:                   Initiate network scan\n" \
+		"    --scan-modes <modes>:           Limit the scan to some network modes (Syntax: <mode1>[,<mode2>,...])\n" \
+		"                                    Available modes: all, lte, umts, gsm, td-scdma\n" \
 		"  --network-register:               Initiate network register\n" \
 		"  --set-plmn:                       Register at specified network\n" \
 		"    --mcc <mcc>:                    Mobile Country Code (0 - auto)\n" \
@@ -55,5 +60,9 @@
 		"  --get-system-info:                Get system info\n" \
 		"  --get-lte-cphy-ca-info:           Get LTE Cphy CA Info\n" \
 		"  --get-cell-location-info:         Get Cell Location Info\n" \
+		"  --get-neighbor-cells:             Get the cells of the Cell Location Info as a\n" \
+		"                                    list sorted by radio, channel and id\n" \
+		"  --get-cell-changes <dB>:          Get the cells added, removed or changed by\n" \
+		"                                    <dB> since the last list of this process\n" \
 		"  --get-tx-rx-info <radio>:         Get TX/RX Info (gsm, umts, lte, 5gnr)\n" \
 
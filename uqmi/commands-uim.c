@@ -24,7 +24,6 @@
 static int uim_slot = 0;
 static int channel_id = -1;
 static uint8_t aid[16];
-static uint8_t apdu[1024];
 
 #define cmd_uim_verify_pin1_cb no_cb
 static enum qmi_cmd_result
@@ -65,7 +64,7 @@ cmd_uim_verify_pin2_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct
 static void cmd_uim_get_sim_state_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
 {
 	struct qmi_uim_get_card_status_response res;
-	void * const card_table = blobmsg_open_table(&status, NULL);
+	void * const card_table = uqmi_open_table(NULL);
 	static const char *card_application_states[] = {
 		[QMI_UIM_CARD_APPLICATION_STATE_UNKNOWN] = "unknown",
 		[QMI_UIM_CARD_APPLICATION_STATE_DETECTED] = "detected",
@@ -115,21 +114,21 @@ static void cmd_uim_get_sim_state_cb(struct qmi_dev *qmi, struct qmi_request *re
 		if (card_application_state > QMI_UIM_CARD_APPLICATION_STATE_READY)
 			card_application_state = QMI_UIM_CARD_APPLICATION_STATE_UNKNOWN;
 
-		blobmsg_add_u32(&status, "card_slot", i + 1); /* Slot is idx + 1 */
-		blobmsg_add_string(&status, "card_application_state", card_application_states[card_application_state]);
-		blobmsg_add_string(&status, "pin1_status", get_pin_status(pin1_state));
-		blobmsg_add_u32(&status, "pin1_verify_tries", pin1_retries);
-		blobmsg_add_u32(&status, "pin1_unlock_tries", puk1_retries);
+		uqmi_add_u32("card_slot", i + 1); /* Slot is idx + 1 */
+		uqmi_add_string("card_application_state", card_application_states[card_application_state]);
+		uqmi_add_string("pin1_status", get_pin_status(pin1_state));
+		uqmi_add_u32("pin1_verify_tries", pin1_retries);
+		uqmi_add_u32("pin1_unlock_tries", puk1_retries);
 		if (has_pin2) {
-			blobmsg_add_string(&status, "pin2_status", get_pin_status(pin2_state));
-			blobmsg_add_u32(&status, "pin2_verify_tries", pin2_retries);
-			blobmsg_add_u32(&status, "pin2_unlock_tries", puk2_retries);
+			uqmi_add_string("pin2_status", get_pin_status(pin2_state));
+			uqmi_add_u32("pin2_verify_tries", pin2_retries);
+			uqmi_add_u32("pin2_unlock_tries", puk2_retries);
 		}
 
 		break; /* handle only first preset SIM card for now */
 	}
 
-	blobmsg_close_table(&status, card_table);
+	uqmi_close_table(card_table);
 }
 
 static enum qmi_cmd_result
@@ -213,11 +212,11 @@ static void cmd_uim_open_logical_channel_cb(struct qmi_dev *qmi, struct qmi_requ
 
 	qmi_parse_uim_open_logical_channel_response(msg, &res);
 
-	c = blobmsg_open_table(&status, NULL);
-	blobmsg_add_u32(&status, "channel_id", res.data.channel_id);
-	blobmsg_add_u32(&status, "sw1", res.data.card_result.sw1);
-	blobmsg_add_u32(&status, "sw2", res.data.card_result.sw2);
-	blobmsg_close_table(&status, c);
+	c = uqmi_open_table(NULL);
+	uqmi_add_u32("channel_id", res.data.channel_id);
+	uqmi_add_u32("sw1", res.data.card_result.sw1);
+	uqmi_add_u32("sw2", res.data.card_result.sw2);
+	uqmi_close_table(c);
 }
 
 static enum qmi_cmd_result
@@ -286,9 +285,9 @@ static void cmd_uim_send_apdu_cb(struct qmi_dev *qmi, struct qmi_request *req, s
 
 	uqmi_hexstring_create(hexstr, res.data.apdu_response, res.data.apdu_response_n);
 
-	c = blobmsg_open_table(&status, NULL);
-	blobmsg_add_string(&status, "response", (char *)hexstr);
-	blobmsg_close_table(&status, c);
+	c = uqmi_open_table(NULL);
+	uqmi_add_string("response", (char *)hexstr);
+	uqmi_close_table(c);
 
 	free(hexstr);
 }
@@ -299,8 +298,9 @@ cmd_uim_send_apdu_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct q
 	struct qmi_uim_send_apdu_request data = {
 		QMI_INIT(slot, uim_slot),
 		QMI_INIT(channel_id, channel_id),
-		QMI_INIT_ARRAY(apdu, apdu, (strlen(arg) / 2)),
 	};
+	uint8_t *apdu;
+	int len, ret;
 
 	if (!uim_slot) {
 		uqmi_add_error("UIM-Slot not set. Use --uim-slot <slot> to set it.");
@@ -312,12 +312,25 @@ cmd_uim_send_apdu_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct q
 		return QMI_CMD_EXIT;
 	}
 
-	if (strlen(arg) % 2 || strlen(arg) > sizeof(apdu) * 2 ||
-	    !uqmi_hexstring_parse(apdu, (uint8_t *)arg, strlen(arg))) {
+	/* extended APDUs may be up to 64k, size the buffer to the argument */
+	len = strlen(arg);
+	apdu = malloc(len / 2 + 1);
+	if (len % 2 || len / 2 > 0xffff || !apdu ||
+	    !uqmi_hexstring_parse(apdu, (uint8_t *)arg, len)) {
+		free(apdu);
 		uqmi_add_error("Invalid APDU argument");
 		return QMI_CMD_EXIT;
 	}
 
-	qmi_set_uim_send_apdu_request(msg, &data);
+	data.data.apdu = apdu;
+	data.data.apdu_n = len / 2;
+	ret = qmi_set_uim_send_apdu_request(msg, &data);
+	free(apdu);
+
+	if (ret) {
+		uqmi_add_error("APDU too long");
+		return QMI_CMD_EXIT;
+	}
+
 	return QMI_CMD_REQUEST;
 }
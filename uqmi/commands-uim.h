@@ -20,16 +20,16 @@
  */
 
 #define __uqmi_uim_commands												\
-	__uqmi_command(uim_slot, uim-slot, required, CMD_TYPE_OPTION), \
-	__uqmi_command(uim_verify_pin1, uim-verify-pin1, required, QMI_SERVICE_UIM), \
-	__uqmi_command(uim_verify_pin2, uim-verify-pin2, required, QMI_SERVICE_UIM), \
-	__uqmi_command(uim_get_sim_state, uim-get-sim-state, no, QMI_SERVICE_UIM), \
-	__uqmi_command(uim_power_off, uim-power-off, no, QMI_SERVICE_UIM), \
-	__uqmi_command(uim_power_on, uim-power-on, no, QMI_SERVICE_UIM), \
-	__uqmi_command(uim_channel_id, uim-channel-id, required, CMD_TYPE_OPTION), \
-	__uqmi_command(uim_open_logical_channel, uim-channel-open, required, QMI_SERVICE_UIM), \
-	__uqmi_command(uim_close_logical_channel, uim-channel-close, no, QMI_SERVICE_UIM), \
-	__uqmi_command(uim_send_apdu, uim-apdu-send, required, QMI_SERVICE_UIM) \
+	__uqmi_command(uim_slot, uim-slot, required, CMD_TYPE_OPTION, 0, CMD_STATE(uim_slot)), \
+	__uqmi_command(uim_verify_pin1, uim-verify-pin1, required, QMI_SERVICE_UIM, CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(uim_verify_pin2, uim-verify-pin2, required, QMI_SERVICE_UIM, CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(uim_get_sim_state, uim-get-sim-state, no, QMI_SERVICE_UIM, CMD_SERVICE, 0), \
+	__uqmi_command(uim_power_off, uim-power-off, no, QMI_SERVICE_UIM, CMD_STATE(uim_slot) | CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(uim_power_on, uim-power-on, no, QMI_SERVICE_UIM, CMD_STATE(uim_slot) | CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(uim_channel_id, uim-channel-id, required, CMD_TYPE_OPTION, 0, CMD_STATE(channel_id)), \
+	__uqmi_command(uim_open_logical_channel, uim-channel-open, required, QMI_SERVICE_UIM, CMD_STATE(aid) | CMD_STATE(uim_slot) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(uim_close_logical_channel, uim-channel-close, no, QMI_SERVICE_UIM, CMD_STATE(channel_id) | CMD_STATE(uim_slot) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(uim_send_apdu, uim-apdu-send, required, QMI_SERVICE_UIM, CMD_STATE(channel_id) | CMD_STATE(uim_slot) | CMD_SERVICE, CMD_SERVICE) \
 
 
 #define uim_helptext \
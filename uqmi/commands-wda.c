@@ -235,26 +235,26 @@ cmd_wda_get_data_format_cb(struct qmi_dev *qmi, struct qmi_request *req, struct
 	void *root;
 
 	qmi_parse_wda_get_data_format_response(msg, &res);
-	root = blobmsg_open_table(&status, NULL);
-	blobmsg_add_u8(&status, "qos-format", res.data.qos_format);
-	blobmsg_add_string(&status, "link-layer-protocol",
+	root = uqmi_open_table(NULL);
+	uqmi_add_u8("qos-format", res.data.qos_format);
+	uqmi_add_string("link-layer-protocol",
 			   wda_link_layer_protocol_to_string(res.data.link_layer_protocol));
-	blobmsg_add_string(&status, "data-aggregation-protocol",
+	uqmi_add_string("data-aggregation-protocol",
 			   wda_data_aggregation_protocol_to_string(res.data.uplink_data_aggregation_protocol));
-	blobmsg_add_u32(&status, "uplink-data-aggregation-max-datagrams",
+	uqmi_add_u32("uplink-data-aggregation-max-datagrams",
 			res.data.uplink_data_aggregation_max_datagrams);
-	blobmsg_add_u32(&status, "uplink-data-aggregation-max-size",
+	uqmi_add_u32("uplink-data-aggregation-max-size",
 			res.data.uplink_data_aggregation_max_size);
-	blobmsg_add_string(&status, "downlink-data-aggregation-protocol",
+	uqmi_add_string("downlink-data-aggregation-protocol",
 			   wda_data_aggregation_protocol_to_string(res.data.downlink_data_aggregation_protocol));
-	blobmsg_add_u32(&status, "downlink-data-aggregation-max-datagrams",
+	uqmi_add_u32("downlink-data-aggregation-max-datagrams",
 			res.data.downlink_data_aggregation_max_datagrams);
-	blobmsg_add_u32(&status, "downlink-data-aggregation-max-size",
+	uqmi_add_u32("downlink-data-aggregation-max-size",
 			res.data.downlink_data_aggregation_max_size);
-	blobmsg_add_u32(&status, "download-minimum-padding",
+	uqmi_add_u32("download-minimum-padding",
 			res.data.download_minimum_padding);
-	blobmsg_add_u8(&status, "flow-control", res.data.flow_control);
-	blobmsg_close_table(&status, root);
+	uqmi_add_u8("flow-control", res.data.flow_control);
+	uqmi_close_table(root);
 }
 
 static enum qmi_cmd_result
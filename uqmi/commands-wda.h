@@ -20,15 +20,15 @@
  */
 
 #define __uqmi_wda_commands \
-	__uqmi_command(wda_set_data_format, wda-set-data-format, required, QMI_SERVICE_WDA), \
-	__uqmi_command(wda_downlink_data_aggregation_protocol, dl-aggregation-protocol, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wda_downlink_data_aggregation_max_datagrams, dl-datagram-max-count, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wda_downlink_data_aggregation_max_size, dl-datagram-max-size, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wda_uplink_data_aggregation_protocol, ul-aggregation-protocol, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wda_uplink_data_aggregation_max_datagrams, ul-datagram-max-count, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wda_uplink_data_aggregation_max_size, ul-datagram-max-size, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wda_flow_control, flow-control, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wda_get_data_format, wda-get-data-format, no, QMI_SERVICE_WDA)
+	__uqmi_command(wda_set_data_format, wda-set-data-format, required, QMI_SERVICE_WDA, CMD_STATE(wda_aggregation_info) | CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(wda_downlink_data_aggregation_protocol, dl-aggregation-protocol, required, CMD_TYPE_OPTION, 0, CMD_STATE(wda_aggregation_info)), \
+	__uqmi_command(wda_downlink_data_aggregation_max_datagrams, dl-datagram-max-count, required, CMD_TYPE_OPTION, 0, CMD_STATE(wda_aggregation_info)), \
+	__uqmi_command(wda_downlink_data_aggregation_max_size, dl-datagram-max-size, required, CMD_TYPE_OPTION, 0, CMD_STATE(wda_aggregation_info)), \
+	__uqmi_command(wda_uplink_data_aggregation_protocol, ul-aggregation-protocol, required, CMD_TYPE_OPTION, 0, CMD_STATE(wda_aggregation_info)), \
+	__uqmi_command(wda_uplink_data_aggregation_max_datagrams, ul-datagram-max-count, required, CMD_TYPE_OPTION, 0, CMD_STATE(wda_aggregation_info)), \
+	__uqmi_command(wda_uplink_data_aggregation_max_size, ul-datagram-max-size, required, CMD_TYPE_OPTION, 0, CMD_STATE(wda_aggregation_info)), \
+	__uqmi_command(wda_flow_control, flow-control, required, CMD_TYPE_OPTION, 0, CMD_STATE(wda_aggregation_info)), \
+	__uqmi_command(wda_get_data_format, wda-get-data-format, no, QMI_SERVICE_WDA, CMD_SERVICE, 0)
 
 
 #define wda_helptext \
@@ -34,15 +34,6 @@ static const struct {
 	{ "both", QMI_WDS_AUTHENTICATION_PAP | QMI_WDS_AUTHENTICATION_CHAP },
 };
 
-static const struct {
-	const char *ipfam_name;
-	const QmiWdsIpFamily mode;
-} ipfam_modes[] = {
-	{ "ipv4", QMI_WDS_IP_FAMILY_IPV4 },
-	{ "ipv6", QMI_WDS_IP_FAMILY_IPV6 },
-	{ "unspecified", QMI_WDS_IP_FAMILY_UNSPECIFIED },
-};
-
 static const struct {
 	const char *pdp_name;
 	const QmiWdsPdpType type;
@@ -53,14 +44,6 @@ static const struct {
 	{ "ipv4v6", QMI_WDS_PDP_TYPE_IPV4_OR_IPV6 },
 };
 
-static const struct {
-	const char *profile_name;
-	const QmiWdsProfileType profile;
-} profile_types[] = {
-	{ "3gpp", QMI_WDS_PROFILE_TYPE_3GPP },
-	{ "3gpp2", QMI_WDS_PROFILE_TYPE_3GPP2 },
-};
-
 struct uqmi_wds_profile_identifier {
 	QmiWdsProfileType type;
 	uint32_t index;
@@ -89,17 +72,26 @@ static struct qmi_wds_create_profile_request wds_cp_req = {
 static int
 uqmi_wds_profile_type_parse(const char *type_string, QmiWdsProfileType *type)
 {
-	int i;
+	int val;
 
-	for (i = 0; i < ARRAY_SIZE(profile_types); i++) {
-		if (strcasecmp(profile_types[i].profile_name, type_string) != 0)
-			continue;
+	if (qmi_enum_value(&qmi_wds_profile_type_names, type_string, &val))
+		return -1;
 
-		*type = profile_types[i].profile;
-		return 0;
-	}
+	*type = val;
+	return 0;
+}
+
+static int
+uqmi_wds_ip_family_parse(const char *arg, QmiWdsIpFamily *family)
+{
+	int val;
+
+	if (qmi_enum_value(&qmi_wds_ip_family_names, arg, &val) ||
+	    val == QMI_WDS_IP_FAMILY_UNKNOWN)
+		return -1;
 
-	return -1;
+	*family = val;
+	return 0;
 }
 
 static int
@@ -191,17 +183,15 @@ cmd_wds_set_autoconnect_prepare(struct qmi_dev *qmi, struct qmi_request *req, st
 static enum qmi_cmd_result
 cmd_wds_set_ip_family_pref_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
-	int i;
-	for (i = 0; i < ARRAY_SIZE(ipfam_modes); i++) {
-		if (strcasecmp(ipfam_modes[i].ipfam_name, arg) != 0)
-			continue;
+	QmiWdsIpFamily family;
 
-		qmi_set(&wds_sn_req, ip_family_preference, ipfam_modes[i].mode);
-		return QMI_CMD_DONE;
+	if (uqmi_wds_ip_family_parse(arg, &family)) {
+		uqmi_add_error("Invalid value (valid: ipv4, ipv6, unspecified)");
+		return QMI_CMD_EXIT;
 	}
 
-	uqmi_add_error("Invalid value (valid: ipv4, ipv6, unspecified)");
-	return QMI_CMD_EXIT;
+	qmi_set(&wds_sn_req, ip_family_preference, family);
+	return QMI_CMD_DONE;
 }
 
 #define cmd_wds_set_pdp_type_cb no_cb
@@ -257,7 +247,7 @@ cmd_wds_start_network_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qm
 
 	qmi_parse_wds_start_network_response(msg, &res);
 	if (res.set.packet_data_handle)
-		blobmsg_add_u32(&status, NULL, res.data.packet_data_handle);
+		uqmi_add_u32(NULL, res.data.packet_data_handle);
 }
 
 static enum qmi_cmd_result
@@ -311,16 +301,16 @@ cmd_wds_get_profile_list_cb(struct qmi_dev *qmi, struct qmi_request *req, struct
 
 	qmi_parse_wds_get_profile_list_response(msg, &res);
 
-	root = blobmsg_open_table(&status, NULL);
-	p = blobmsg_open_array(&status, "profiles");
+	root = uqmi_open_table(NULL);
+	p = uqmi_open_array("profiles");
 	for (i = 0; i < res.data.profile_list_n; i++) {
-		t = blobmsg_open_table(&status, NULL);
-		blobmsg_add_u32(&status, "index", res.data.profile_list[i].profile_index);
-		blobmsg_add_string(&status, "name", res.data.profile_list[i].profile_name);
-		blobmsg_close_table(&status, t);
+		t = uqmi_open_table(NULL);
+		uqmi_add_u32("index", res.data.profile_list[i].profile_index);
+		uqmi_add_string("name", res.data.profile_list[i].profile_name);
+		uqmi_close_table(t);
 	}
-	blobmsg_close_array(&status, p);
-	blobmsg_close_table(&status, root);
+	uqmi_close_array(p);
+	uqmi_close_table(root);
 }
 
 static enum qmi_cmd_result
@@ -350,49 +340,69 @@ cmd_wds_create_profile_cb(struct qmi_dev *qmi, struct qmi_request *req, struct q
 	qmi_parse_wds_create_profile_response(msg, &res);
 
 	if (res.set.profile_identifier) {
-		p = blobmsg_open_table(&status, NULL);
-		blobmsg_add_u32(&status, "created-profile", res.data.profile_identifier.profile_index);
-		blobmsg_close_table(&status, p);
+		p = uqmi_open_table(NULL);
+		uqmi_add_u32("created-profile", res.data.profile_identifier.profile_index);
+		uqmi_close_table(p);
 	}
 }
 
 static enum qmi_cmd_result
 cmd_wds_create_profile_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
-	int i;
-	for (i = 0; i < ARRAY_SIZE(profile_types); i++) {
-		if (strcasecmp(profile_types[i].profile_name, arg) != 0)
-			continue;
-
-		qmi_set_ptr(&wds_cp_req, profile_type, profile_types[i].profile);
+	QmiWdsProfileType type;
 
-		qmi_set_wds_create_profile_request(msg, &wds_cp_req);
-		return QMI_CMD_REQUEST;
+	if (uqmi_wds_profile_type_parse(arg, &type)) {
+		uqmi_add_error("Invalid value (valid: 3gpp or 3gpp2)");
+		return QMI_CMD_EXIT;
 	}
 
-	uqmi_add_error("Invalid value (valid: 3gpp or 3gpp2)");
-	return QMI_CMD_EXIT;
+	qmi_set_ptr(&wds_cp_req, profile_type, type);
+
+	qmi_set_wds_create_profile_request(msg, &wds_cp_req);
+	return QMI_CMD_REQUEST;
 }
 
 static void
 cmd_wds_get_packet_service_status_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
 {
-	struct qmi_wds_get_packet_service_status_response res;
-	const char *data_status[] = {
-		[QMI_WDS_CONNECTION_STATUS_UNKNOWN] = "unknown",
-		[QMI_WDS_CONNECTION_STATUS_DISCONNECTED] = "disconnected",
-		[QMI_WDS_CONNECTION_STATUS_CONNECTED] = "connected",
-		[QMI_WDS_CONNECTION_STATUS_SUSPENDED] = "suspended",
-		[QMI_WDS_CONNECTION_STATUS_AUTHENTICATING] = "authenticating",
-	};
-	int s = 0;
+	struct qmi_wds_get_packet_service_status_response_view view;
+	struct qmi_wds_get_packet_service_status_response res = {};
+	int s = QMI_WDS_CONNECTION_STATUS_UNKNOWN;
 
-	qmi_parse_wds_get_packet_service_status_response(msg, &res);
-	if (res.set.connection_status &&
-	    res.data.connection_status < ARRAY_SIZE(data_status))
+	qmi_view_wds_get_packet_service_status_response(msg, &view);
+	qmi_view_wds_get_packet_service_status_response_connection_status(&view, &res, NULL);
+	if (res.set.connection_status)
 		s = res.data.connection_status;
 
-	blobmsg_add_string(&status, NULL, data_status[s]);
+	uqmi_add_string(NULL, enum_name(&qmi_wds_connection_status_names, s));
+}
+
+static void
+cmd_wds_packet_service_status_ind_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	struct qmi_wds_packet_service_status_indication res;
+	void *c;
+
+	qmi_parse_wds_packet_service_status_indication(msg, &res);
+	c = uqmi_open_table(NULL);
+	if (res.set.connection_status) {
+		uqmi_add_string("status", enum_name(&qmi_wds_connection_status_names,
+						    res.data.connection_status.status));
+		uqmi_add_u8("reconfiguration_required",
+			    res.data.connection_status.reconfiguration_required);
+	}
+	if (res.set.call_end_reason)
+		uqmi_add_string("call_end_reason", enum_name(&qmi_wds_call_end_reason_names,
+							     res.data.call_end_reason));
+	if (res.set.verbose_call_end_reason) {
+		uqmi_add_u32("verbose_call_end_reason_type",
+			     res.data.verbose_call_end_reason.type);
+		uqmi_add_u32("verbose_call_end_reason",
+			     (int32_t) res.data.verbose_call_end_reason.reason);
+	}
+	if (res.set.ip_family)
+		uqmi_add_u32("ip_family", res.data.ip_family);
+	uqmi_close_table(c);
 }
 
 static enum qmi_cmd_result
@@ -407,24 +417,16 @@ static enum qmi_cmd_result
 cmd_wds_set_autoconnect_settings_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
 	struct qmi_wds_set_autoconnect_settings_request ac_req;
-	const char *modes[] = {
-		[QMI_WDS_AUTOCONNECT_SETTING_DISABLED] = "disabled",
-		[QMI_WDS_AUTOCONNECT_SETTING_ENABLED] = "enabled",
-		[QMI_WDS_AUTOCONNECT_SETTING_PAUSED] = "paused",
-	};
-	int i;
-
-	for (i = 0; i < ARRAY_SIZE(modes); i++) {
-		if (strcasecmp(modes[i], arg) != 0)
-			continue;
+	int mode;
 
-		qmi_set(&ac_req, status, i);
-		qmi_set_wds_set_autoconnect_settings_request(msg, &ac_req);
-		return QMI_CMD_DONE;
+	if (qmi_enum_value(&qmi_wds_autoconnect_setting_names, arg, &mode)) {
+		uqmi_add_error("Invalid value (valid: disabled, enabled, paused)");
+		return QMI_CMD_EXIT;
 	}
 
-	uqmi_add_error("Invalid value (valid: disabled, enabled, paused)");
-	return QMI_CMD_EXIT;
+	qmi_set(&ac_req, status, mode);
+	qmi_set_wds_set_autoconnect_settings_request(msg, &ac_req);
+	return QMI_CMD_DONE;
 }
 
 #define cmd_wds_reset_cb no_cb
@@ -440,19 +442,16 @@ static enum qmi_cmd_result
 cmd_wds_set_ip_family_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
 	struct qmi_wds_set_ip_family_request ipf_req;
+	QmiWdsIpFamily family;
 
-	int i;
-	for (i = 0; i < ARRAY_SIZE(ipfam_modes); i++) {
-		if (strcasecmp(ipfam_modes[i].ipfam_name, arg) != 0)
-			continue;
-
-		qmi_set(&ipf_req, preference, ipfam_modes[i].mode);
-		qmi_set_wds_set_ip_family_request(msg, &ipf_req);
-		return QMI_CMD_REQUEST;
+	if (uqmi_wds_ip_family_parse(arg, &family)) {
+		uqmi_add_error("Invalid value (valid: ipv4, ipv6, unspecified)");
+		return QMI_CMD_EXIT;
 	}
 
-	uqmi_add_error("Invalid value (valid: ipv4, ipv6, unspecified)");
-	return QMI_CMD_EXIT;
+	qmi_set(&ipf_req, preference, family);
+	qmi_set_wds_set_ip_family_request(msg, &ipf_req);
+	return QMI_CMD_REQUEST;
 }
 
 static struct {
@@ -517,7 +516,7 @@ static void wds_to_ipv4(const char *name, const uint32_t addr)
 	char buf[INET_ADDRSTRLEN];
 
 	ip_addr.s_addr = htonl(addr);
-	blobmsg_add_string(&status, name, inet_ntop(AF_INET, &ip_addr, buf, sizeof(buf)));
+	uqmi_add_string(name, inet_ntop(AF_INET, &ip_addr, buf, sizeof(buf)));
 }
 
 static void wds_to_ipv6(const char *name, const uint16_t *addr)
@@ -529,7 +528,7 @@ static void wds_to_ipv6(const char *name, const uint16_t *addr)
 	for (i = 0; i < ARRAY_SIZE(ip_addr); i++)
 		ip_addr[i] = htons(addr[i]);
 
-	blobmsg_add_string(&status, name, inet_ntop(AF_INET6, &ip_addr, buf, sizeof(buf)));
+	uqmi_add_string(name, inet_ntop(AF_INET6, &ip_addr, buf, sizeof(buf)));
 }
 
 static enum qmi_cmd_result
@@ -562,18 +561,18 @@ cmd_wds_get_profile_settings_cb(struct qmi_dev *qmi, struct qmi_request *req, st
 
 	qmi_parse_wds_get_profile_settings_response(msg, &res);
 
-	p = blobmsg_open_table(&status, NULL);
+	p = uqmi_open_table(NULL);
 
-	blobmsg_add_string(&status, "apn", res.data.apn_name);
+	uqmi_add_string("apn", res.data.apn_name);
 	if (res.set.pdp_type && (int) res.data.pdp_type < ARRAY_SIZE(pdp_types))
-		blobmsg_add_string(&status, "pdp-type", pdp_types[res.data.pdp_type].pdp_name);
-	blobmsg_add_string(&status, "username", res.data.username);
-	blobmsg_add_string(&status, "password", res.data.password);
+		uqmi_add_string("pdp-type", pdp_types[res.data.pdp_type].pdp_name);
+	uqmi_add_string("username", res.data.username);
+	uqmi_add_string("password", res.data.password);
         if (res.set.authentication && (int) res.data.authentication < ARRAY_SIZE(auth_modes))
-                blobmsg_add_string(&status, "auth", auth_modes[res.data.authentication].auth_name);
-	blobmsg_add_u8(&status, "no-roaming", res.data.roaming_disallowed_flag);
-	blobmsg_add_u8(&status, "apn-disabled", res.data.apn_disabled_flag);
-	blobmsg_close_table(&status, p);
+                uqmi_add_string("auth", auth_modes[res.data.authentication].auth_name);
+	uqmi_add_u8("no-roaming", res.data.roaming_disallowed_flag);
+	uqmi_add_u8("apn-disabled", res.data.apn_disabled_flag);
+	uqmi_close_table(p);
 }
 
 static void
@@ -585,25 +584,23 @@ cmd_wds_get_current_settings_cb(struct qmi_dev *qmi, struct qmi_request *req, st
 
 	qmi_parse_wds_get_current_settings_response(msg, &res);
 
-	t = blobmsg_open_table(&status, NULL);
+	t = uqmi_open_table(NULL);
 
 	if (res.set.pdp_type && (int) res.data.pdp_type < ARRAY_SIZE(pdp_types))
-		blobmsg_add_string(&status, "pdp-type", pdp_types[res.data.pdp_type].pdp_name);
-
-	if (res.set.ip_family) {
-		for (i = 0; i < ARRAY_SIZE(ipfam_modes); i++) {
-			if (ipfam_modes[i].mode != res.data.ip_family)
-				continue;
-			blobmsg_add_string(&status, "ip-family", ipfam_modes[i].ipfam_name);
-			break;
-		}
+		uqmi_add_string("pdp-type", pdp_types[res.data.pdp_type].pdp_name);
+
+	if (res.set.ip_family && res.data.ip_family != QMI_WDS_IP_FAMILY_UNKNOWN) {
+		const char *family = qmi_enum_name(&qmi_wds_ip_family_names, res.data.ip_family);
+
+		if (family)
+			uqmi_add_string("ip-family", family);
 	}
 
 	if (res.set.mtu)
-		blobmsg_add_u32(&status, "mtu", res.data.mtu);
+		uqmi_add_u32("mtu", res.data.mtu);
 
 	/* IPV4 */
-	v4 = blobmsg_open_table(&status, "ipv4");
+	v4 = uqmi_open_table("ipv4");
 
 	if (res.set.ipv4_address)
 		wds_to_ipv4("ip", res.data.ipv4_address);
@@ -615,33 +612,33 @@ cmd_wds_get_current_settings_cb(struct qmi_dev *qmi, struct qmi_request *req, st
 		wds_to_ipv4("gateway", res.data.ipv4_gateway_address);
 	if (res.set.ipv4_gateway_subnet_mask)
 		wds_to_ipv4("subnet", res.data.ipv4_gateway_subnet_mask);
-	blobmsg_close_table(&status, v4);
+	uqmi_close_table(v4);
 
 	/* IPV6 */
-	v6 = blobmsg_open_table(&status, "ipv6");
+	v6 = uqmi_open_table("ipv6");
 
 	if (res.set.ipv6_address) {
 		wds_to_ipv6("ip", res.data.ipv6_address.address);
-		blobmsg_add_u32(&status, "ip-prefix-length", res.data.ipv6_address.prefix_length);
+		uqmi_add_u32("ip-prefix-length", res.data.ipv6_address.prefix_length);
 	}
 	if (res.set.ipv6_gateway_address) {
 		wds_to_ipv6("gateway", res.data.ipv6_gateway_address.address);
-		blobmsg_add_u32(&status, "gw-prefix-length", res.data.ipv6_gateway_address.prefix_length);
+		uqmi_add_u32("gw-prefix-length", res.data.ipv6_gateway_address.prefix_length);
 	}
 	if (res.set.ipv6_primary_dns_address)
 		wds_to_ipv6("dns1", res.data.ipv6_primary_dns_address);
 	if (res.set.ipv6_secondary_dns_address)
 		wds_to_ipv6("dns2", res.data.ipv6_secondary_dns_address);
 
-	blobmsg_close_table(&status, v6);
+	uqmi_close_table(v6);
 
-	d = blobmsg_open_table(&status, "domain-names");
+	d = uqmi_open_table("domain-names");
 	for (i = 0; i < res.data.domain_name_list_n; i++) {
-		blobmsg_add_string(&status, NULL, res.data.domain_name_list[i]);
+		uqmi_add_string(NULL, res.data.domain_name_list[i]);
 	}
-	blobmsg_close_table(&status, d);
+	uqmi_close_table(d);
 
-	blobmsg_close_table(&status, t);
+	uqmi_close_table(t);
 }
 
 static enum qmi_cmd_result
@@ -665,24 +662,22 @@ cmd_wds_get_current_settings_prepare(struct qmi_dev *qmi, struct qmi_request *re
 static enum qmi_cmd_result
 cmd_wds_get_default_profile_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
-	int i;
-	for (i = 0; i < ARRAY_SIZE(profile_types); i++) {
-		if (strcasecmp(profile_types[i].profile_name, arg) != 0)
-			continue;
-
-		struct qmi_wds_get_default_profile_number_request type_family = {
-			QMI_INIT_SEQUENCE(profile_type,
-				.type = profile_types[i].profile,
-				.family = QMI_WDS_PROFILE_FAMILY_TETHERED,
-			)
-		};
+	QmiWdsProfileType type;
 
-		qmi_set_wds_get_default_profile_number_request(msg, &type_family);
-		return QMI_CMD_REQUEST;
+	if (uqmi_wds_profile_type_parse(arg, &type)) {
+		uqmi_add_error("Invalid value (valid: 3gpp or 3gpp2)");
+		return QMI_CMD_EXIT;
 	}
 
-	uqmi_add_error("Invalid value (valid: 3gpp or 3gpp2)");
-	return QMI_CMD_EXIT;
+	struct qmi_wds_get_default_profile_number_request type_family = {
+		QMI_INIT_SEQUENCE(profile_type,
+			.type = type,
+			.family = QMI_WDS_PROFILE_FAMILY_TETHERED,
+		)
+	};
+
+	qmi_set_wds_get_default_profile_number_request(msg, &type_family);
+	return QMI_CMD_REQUEST;
 }
 
 static void
@@ -692,11 +687,11 @@ cmd_wds_get_default_profile_cb(struct qmi_dev *qmi, struct qmi_request *req, str
 	void *p;
 	qmi_parse_wds_get_default_profile_number_response(msg, &res);
 
-	p = blobmsg_open_table(&status, NULL);
+	p = uqmi_open_table(NULL);
 
-	blobmsg_add_u32(&status, "default-profile", res.data.index);
+	uqmi_add_u32("default-profile", res.data.index);
 
-	blobmsg_close_table(&status, p);
+	uqmi_close_table(p);
 }
 
 #define cmd_wds_set_default_profile_cb no_cb
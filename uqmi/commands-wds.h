@@ -20,33 +20,33 @@
  */
 
 #define __uqmi_wds_commands \
-	__uqmi_command(wds_start_network, start-network, no, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_set_apn, apn, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_set_auth, auth-type, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_set_username, username, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_set_password, password, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_set_ip_family_pref, ip-family, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_set_autoconnect, autoconnect, no, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_set_profile, profile, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_stop_network, stop-network, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_get_packet_service_status, get-data-status, no, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_set_ip_family, set-ip-family, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_set_autoconnect_settings, set-autoconnect, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_reset, reset-wds, no, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_get_profile_settings, get-profile-settings, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_set_default_profile, set-default-profile, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_get_default_profile, get-default-profile, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_get_profile_list, get-profile-list, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_create_profile, create-profile, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_modify_profile, modify-profile, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_delete_profile, delete-profile, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_set_pdp_type, pdp-type, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_no_roaming, no-roaming, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_get_current_settings, get-current-settings, no, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_bind_mux, bind-mux, required, QMI_SERVICE_WDS), \
-	__uqmi_command(wds_ep_type, endpoint-type, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_ep_iface, endpoint-iface, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wds_set_lte_attach_pdn, lte-attach-pdn, required, QMI_SERVICE_WDS)
+	__uqmi_command(wds_start_network, start-network, no, QMI_SERVICE_WDS, CMD_STATE(wds_sn_req) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_set_apn, apn, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_sn_req) | CMD_STATE(wds_mp_req) | CMD_STATE(wds_cp_req)), \
+	__uqmi_command(wds_set_auth, auth-type, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_sn_req) | CMD_STATE(wds_mp_req) | CMD_STATE(wds_cp_req)), \
+	__uqmi_command(wds_set_username, username, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_sn_req) | CMD_STATE(wds_mp_req) | CMD_STATE(wds_cp_req)), \
+	__uqmi_command(wds_set_password, password, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_sn_req) | CMD_STATE(wds_mp_req) | CMD_STATE(wds_cp_req)), \
+	__uqmi_command(wds_set_ip_family_pref, ip-family, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_sn_req)), \
+	__uqmi_command(wds_set_autoconnect, autoconnect, no, CMD_TYPE_OPTION, 0, CMD_STATE(wds_sn_req) | CMD_STATE(wds_stn_req)), \
+	__uqmi_command(wds_set_profile, profile, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_sn_req)), \
+	__uqmi_command(wds_stop_network, stop-network, required, QMI_SERVICE_WDS, CMD_STATE(wds_stn_req) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_get_packet_service_status, get-data-status, no, QMI_SERVICE_WDS, CMD_SERVICE, 0), \
+	__uqmi_command(wds_set_ip_family, set-ip-family, required, QMI_SERVICE_WDS, CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_set_autoconnect_settings, set-autoconnect, required, QMI_SERVICE_WDS, CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_reset, reset-wds, no, QMI_SERVICE_WDS, CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_get_profile_settings, get-profile-settings, required, QMI_SERVICE_WDS, CMD_SERVICE, 0), \
+	__uqmi_command(wds_set_default_profile, set-default-profile, required, QMI_SERVICE_WDS, CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_get_default_profile, get-default-profile, required, QMI_SERVICE_WDS, CMD_SERVICE, 0), \
+	__uqmi_command(wds_get_profile_list, get-profile-list, required, QMI_SERVICE_WDS, CMD_SERVICE, 0), \
+	__uqmi_command(wds_create_profile, create-profile, required, QMI_SERVICE_WDS, CMD_STATE(wds_cp_req) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_modify_profile, modify-profile, required, QMI_SERVICE_WDS, CMD_STATE(wds_mp_req) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_delete_profile, delete-profile, required, QMI_SERVICE_WDS, CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_set_pdp_type, pdp-type, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_mp_req) | CMD_STATE(wds_cp_req)), \
+	__uqmi_command(wds_no_roaming, no-roaming, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_mp_req) | CMD_STATE(wds_cp_req)), \
+	__uqmi_command(wds_get_current_settings, get-current-settings, no, QMI_SERVICE_WDS, CMD_SERVICE, 0), \
+	__uqmi_command(wds_bind_mux, bind-mux, required, QMI_SERVICE_WDS, CMD_STATE(wds_endpoint_info) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wds_ep_type, endpoint-type, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_endpoint_info)), \
+	__uqmi_command(wds_ep_iface, endpoint-iface, required, CMD_TYPE_OPTION, 0, CMD_STATE(wds_endpoint_info)), \
+	__uqmi_command(wds_set_lte_attach_pdn, lte-attach-pdn, required, QMI_SERVICE_WDS, CMD_SERVICE, CMD_SERVICE)
 
 
 #define wds_helptext \
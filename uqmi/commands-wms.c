@@ -65,11 +65,11 @@ static void cmd_wms_list_messages_cb(struct qmi_dev *qmi, struct qmi_request *re
 	int i;
 
 	qmi_parse_wms_list_messages_response(msg, &res);
-	c = blobmsg_open_array(&status, NULL);
+	c = uqmi_open_array(NULL);
 	for (i = 0; i < res.data.message_list_n; i++)
-		blobmsg_add_u32(&status, NULL, res.data.message_list[i].memory_index);
+		uqmi_add_u32(NULL, res.data.message_list[i].memory_index);
 
-	blobmsg_close_array(&status, c);
+	uqmi_close_array(c);
 }
 
 static enum qmi_cmd_result
@@ -231,14 +231,14 @@ static int decode_udh(const unsigned char *data)
 
 		switch (type) {
 		case 0x00:
-			blobmsg_add_u32(&status, "concat_ref", (uint32_t) val[0]);
-			blobmsg_add_u32(&status, "concat_part", (uint32_t) val[2]);
-			blobmsg_add_u32(&status, "concat_parts", (uint32_t) val[1]);
+			uqmi_add_u32("concat_ref", (uint32_t) val[0]);
+			uqmi_add_u32("concat_part", (uint32_t) val[2]);
+			uqmi_add_u32("concat_parts", (uint32_t) val[1]);
 			break;
 		case 0x08:
-			blobmsg_add_u32(&status, "concat_ref", (uint32_t) (val[0] << 8 | val[1]));
-			blobmsg_add_u32(&status, "concat_part", (uint32_t) val[3]);
-			blobmsg_add_u32(&status, "concat_parts", (uint32_t) val[2]);
+			uqmi_add_u32("concat_ref", (uint32_t) (val[0] << 8 | val[1]));
+			uqmi_add_u32("concat_part", (uint32_t) val[3]);
+			uqmi_add_u32("concat_parts", (uint32_t) val[2]);
 			break;
 		default:
 			break;
@@ -250,10 +250,10 @@ static int decode_udh(const unsigned char *data)
 
 static void decode_7bit_field(char *name, const unsigned char *data, int data_len, int bit_offset)
 {
-	char *dest = blobmsg_alloc_string_buffer(&status, name, 3 * data_len + 2);
+	char *dest = uqmi_alloc_string_buffer(name, 3 * data_len + 2);
 	int out_len = pdu_decode_7bit_str(dest, data, CEILDIV(data_len * 7, 8), bit_offset);
 	dest[out_len] = 0;
-	blobmsg_add_string_buffer(&status);
+	uqmi_add_string_buffer();
 }
 
 static char *pdu_add_semioctet(char *str, char val)
@@ -294,18 +294,18 @@ pdu_decode_address(char *str, unsigned char *data, int len)
 
 static void wms_decode_address(char *name, unsigned char *data, int len)
 {
-	char *str = blobmsg_alloc_string_buffer(&status, name, len * 2 + 2);
+	char *str = uqmi_alloc_string_buffer(name, len * 2 + 2);
 	pdu_decode_address(str, data, len);
-	blobmsg_add_string_buffer(&status);
+	uqmi_add_string_buffer();
 }
 
-static void blobmsg_add_hex(struct blob_buf *buf, const char *name, unsigned const char *data, int len)
+static void wms_add_hex(const char *name, unsigned const char *data, int len)
 {
-	char* str = blobmsg_alloc_string_buffer(buf, name, len * 2 + 1);
+	char* str = uqmi_alloc_string_buffer(name, len * 2 + 1);
 	for (int i = 0; i < len; i++) {
 		str += sprintf(str, "%02x", data[i]);
 	}
-	blobmsg_add_string_buffer(buf);
+	uqmi_add_string_buffer();
 }
 
 #define cmd_wms_delete_message_cb no_cb
@@ -341,7 +341,7 @@ static void cmd_wms_get_message_cb(struct qmi_dev *qmi, struct qmi_request *req,
 	void *c;
 
 	qmi_parse_wms_raw_read_response(msg, &res);
-	c = blobmsg_open_table(&status, NULL);
+	c = uqmi_open_table(NULL);
 	data = (unsigned char *) res.data.raw_message_data.raw_data;
 	end = data + res.data.raw_message_data.raw_data_n;
 
@@ -383,7 +383,7 @@ static void cmd_wms_get_message_cb(struct qmi_dev *qmi, struct qmi_request *req,
 	dcs = *(data++);
 
 	if (dcs & 0x10)
-		blobmsg_add_u32(&status, "class", (dcs & 3));
+		uqmi_add_u32("class", (dcs & 3));
 
 	if (sent) {
 		/* Message validity */
@@ -392,7 +392,7 @@ static void cmd_wms_get_message_cb(struct qmi_dev *qmi, struct qmi_request *req,
 		if (data + 6 >= end)
 			goto error;
 
-		str = blobmsg_alloc_string_buffer(&status, "timestamp", 32);
+		str = uqmi_alloc_string_buffer("timestamp", 32);
 
 		/* year */
 		*(str++) = '2';
@@ -416,7 +416,7 @@ static void cmd_wms_get_message_cb(struct qmi_dev *qmi, struct qmi_request *req,
 		str = pdu_add_semioctet(str, data[5]);
 		*str = 0;
 
-		blobmsg_add_string_buffer(&status);
+		uqmi_add_string_buffer();
 
 		data += 7;
 	}
@@ -445,22 +445,22 @@ static void cmd_wms_get_message_cb(struct qmi_dev *qmi, struct qmi_request *req,
 		case 0x04:
 			/* 8 bit data */
 			message_len = MIN(message_len - udh_len, end - data);
-			blobmsg_add_hex(&status, "data", data, message_len);
+			wms_add_hex("data", data, message_len);
 			break;
 		case 0x08:
 			/* 16 bit UCS-2 string */
 			message_len = MIN(message_len - udh_len, end - data);
-			blobmsg_add_hex(&status, "ucs-2", data, message_len);
+			wms_add_hex("ucs-2", data, message_len);
 			break;
 		default:
 			goto error;
 		}
 
-	blobmsg_close_table(&status, c);
+	uqmi_close_table(c);
 	return;
 
 error:
-	blobmsg_close_table(&status, c);
+	uqmi_close_table(c);
 	fprintf(stderr, "There was an error reading message.\n");
 }
 
@@ -492,11 +492,11 @@ static void cmd_wms_get_raw_message_cb(struct qmi_dev *qmi, struct qmi_request *
 
 	qmi_parse_wms_raw_read_response(msg, &res);
 	data = (unsigned char *) res.data.raw_message_data.raw_data;
-	str = blobmsg_alloc_string_buffer(&status, NULL, res.data.raw_message_data.raw_data_n * 3);
+	str = uqmi_alloc_string_buffer(NULL, res.data.raw_message_data.raw_data_n * 3);
 	for (i = 0; i < res.data.raw_message_data.raw_data_n; i++) {
 		str += sprintf(str, &" %02x"[i ? 0 : 1], data[i]);
 	}
-	blobmsg_add_string_buffer(&status);
+	uqmi_add_string_buffer();
 }
 
 #define cmd_wms_get_raw_message_prepare cmd_wms_get_message_prepare
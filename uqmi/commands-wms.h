@@ -20,15 +20,15 @@
  */
 
 #define __uqmi_wms_commands \
-	__uqmi_command(wms_storage, storage, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wms_list_messages, list-messages, no, QMI_SERVICE_WMS), \
-	__uqmi_command(wms_delete_message, delete-message, required, QMI_SERVICE_WMS), \
-	__uqmi_command(wms_get_message, get-message, required, QMI_SERVICE_WMS), \
-	__uqmi_command(wms_get_raw_message, get-raw-message, required, QMI_SERVICE_WMS), \
-	__uqmi_command(wms_send_message_smsc, send-message-smsc, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wms_send_message_target, send-message-target, required, CMD_TYPE_OPTION), \
-	__uqmi_command(wms_send_message_flash, send-message-flash, no, CMD_TYPE_OPTION), \
-	__uqmi_command(wms_send_message, send-message, required, QMI_SERVICE_WMS)
+	__uqmi_command(wms_storage, storage, required, CMD_TYPE_OPTION, 0, CMD_STATE(lmreq) | CMD_STATE(dmreq) | CMD_STATE(gmreq)), \
+	__uqmi_command(wms_list_messages, list-messages, no, QMI_SERVICE_WMS, CMD_STATE(lmreq) | CMD_SERVICE, 0), \
+	__uqmi_command(wms_delete_message, delete-message, required, QMI_SERVICE_WMS, CMD_STATE(dmreq) | CMD_SERVICE, CMD_SERVICE), \
+	__uqmi_command(wms_get_message, get-message, required, QMI_SERVICE_WMS, CMD_STATE(gmreq) | CMD_SERVICE, 0), \
+	__uqmi_command(wms_get_raw_message, get-raw-message, required, QMI_SERVICE_WMS, CMD_STATE(gmreq) | CMD_SERVICE, 0), \
+	__uqmi_command(wms_send_message_smsc, send-message-smsc, required, CMD_TYPE_OPTION, 0, CMD_STATE(_send)), \
+	__uqmi_command(wms_send_message_target, send-message-target, required, CMD_TYPE_OPTION, 0, CMD_STATE(_send)), \
+	__uqmi_command(wms_send_message_flash, send-message-flash, no, CMD_TYPE_OPTION, 0, CMD_STATE(_send)), \
+	__uqmi_command(wms_send_message, send-message, required, QMI_SERVICE_WMS, CMD_STATE(_send) | CMD_SERVICE, CMD_SERVICE)
 
 #define wms_helptext \
 		"  --list-messages:                  List SMS messages\n" \
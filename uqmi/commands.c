@@ -31,6 +31,7 @@
 #include "uqmi.h"
 #include "utils.h"
 #include "commands.h"
+#include "output.h"
 
 struct blob_buf status;
 bool single_line = false;
@@ -39,6 +40,13 @@ static void no_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *
 {
 }
 
+static const char *enum_name(const struct qmi_enum_names *names, int value)
+{
+	const char *name = qmi_enum_name(names, value);
+
+	return name ? name : "unknown";
+}
+
 static void cmd_version_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
 {
 	struct qmi_ctl_get_version_info_response res;
@@ -48,14 +56,14 @@ static void cmd_version_cb(struct qmi_dev *qmi, struct qmi_request *req, struct
 
 	qmi_parse_ctl_get_version_info_response(msg, &res);
 
-	c = blobmsg_open_table(&status, NULL);
+	c = uqmi_open_table(NULL);
 	for (i = 0; i < res.data.service_list_n; i++) {
 		sprintf(name_buf, "service_%d", res.data.service_list[i].service);
-		blobmsg_printf(&status, name_buf, "%d,%d",
+		uqmi_printf(name_buf, "%d,%d",
 			res.data.service_list[i].major_version,
 			res.data.service_list[i].minor_version);
 	}
-	blobmsg_close_table(&status, c);
+	uqmi_close_table(c);
 }
 
 static enum qmi_cmd_result
@@ -65,7 +73,13 @@ cmd_version_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg
 	return QMI_CMD_REQUEST;
 }
 
-#define cmd_sync_cb no_cb
+static void cmd_sync_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	/* the modem has dropped all client IDs */
+	qmi->service_connected = 0;
+	qmi->service_cached = 0;
+}
+
 static enum qmi_cmd_result
 cmd_sync_prepare(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg)
 {
@@ -172,10 +186,12 @@ cmd_ctl_set_data_format_prepare(struct qmi_dev *qmi, struct qmi_request *req, st
 #include "commands-wda.c"
 #include "commands-uim.c"
 
-#define __uqmi_command(_name, _optname, _arg, _type) \
+#define __uqmi_command(_name, _optname, _arg, _type, _in, _out) \
 	[__UQMI_COMMAND_##_name] = { \
 		.name = #_optname, \
 		.type = _type, \
+		.in = _in, \
+		.out = _out, \
 		.prepare = cmd_##_name##_prepare, \
 		.cb = cmd_##_name##_cb, \
 	}
@@ -185,9 +201,51 @@ const struct uqmi_cmd_handler uqmi_cmd_handler[__UQMI_COMMAND_LAST] = {
 };
 #undef __uqmi_command
 
+/* the indications uqmi --monitor knows by name */
+static const struct uqmi_indication uqmi_indications[] = {
+	{ QMI_SERVICE_WDS, 0x0001, "event-report", NULL },
+	{ QMI_SERVICE_WDS, 0x0022, "packet-service-status", cmd_wds_packet_service_status_ind_cb },
+	{ QMI_SERVICE_DMS, 0x0001, "event-report", cmd_dms_event_report_ind_cb },
+	{ QMI_SERVICE_NAS, 0x0024, "serving-system", cmd_nas_get_serving_system_cb },
+	{ QMI_SERVICE_NAS, 0x004C, "network-time", NULL },
+	{ QMI_SERVICE_NAS, 0x004E, "system-info", cmd_nas_system_info_ind_cb },
+	{ QMI_SERVICE_NAS, 0x0051, "signal-info", cmd_nas_get_signal_info_cb },
+	{ QMI_SERVICE_UIM, 0x0032, "card-status", cmd_uim_get_sim_state_cb },
+	{ QMI_SERVICE_UIM, 0x0048, "slot-status", NULL },
+};
+
+const struct uqmi_indication *uqmi_find_indication(QmiService service, uint16_t message)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(uqmi_indications); i++)
+		if (uqmi_indications[i].service == service &&
+		    uqmi_indications[i].message == message)
+			return &uqmi_indications[i];
+
+	return NULL;
+}
+
 static struct uqmi_cmd *cmds;
 static int n_cmds;
 
+/*
+ * State the option commands leave behind for the actions. uqmi --server
+ * puts it back to how it was at startup before running the next client.
+ */
+static const struct {
+	void *data;
+	unsigned int len;
+} uqmi_option_state[__UQMI_STATE_LAST] = {
+#define __uqmi_option_state(_var) [__UQMI_STATE_##_var] = { &_var, sizeof(_var) }
+	__uqmi_option_states
+#undef __uqmi_option_state
+};
+
+static char *saved_state;
+
+int uqmi_cmd_line;
+
 void uqmi_add_command(char *arg, int cmd)
 {
 	int idx = n_cmds++;
@@ -195,30 +253,267 @@ void uqmi_add_command(char *arg, int cmd)
 	cmds = realloc(cmds, n_cmds * sizeof(*cmds));
 	cmds[idx].handler = &uqmi_cmd_handler[cmd];
 	cmds[idx].arg = arg;
+	cmds[idx].line = uqmi_cmd_line;
 }
 
-static void uqmi_print_result(struct blob_attr *data)
+/* whether cmd is queued already for the line of the commands added next */
+bool uqmi_cmd_queued(int cmd)
 {
-	char *str;
+	int i;
 
-	if (!blob_len(data))
-		return;
+	for (i = 0; i < n_cmds; i++)
+		if (cmds[i].line == uqmi_cmd_line &&
+		    cmds[i].handler == &uqmi_cmd_handler[cmd])
+			return true;
 
-	str = blobmsg_format_json_indent(blob_data(data), false, single_line ? -1 : 0);
-	if (!str)
+	return false;
+}
+
+/* drop the commands queued for a batch line that failed to parse */
+void uqmi_drop_commands(int line)
+{
+	while (n_cmds > 0 && cmds[n_cmds - 1].line == line)
+		n_cmds--;
+}
+
+/* results are tagged with the device, see uqmi_run_devices() */
+static bool multi_device;
+
+/*
+ * prepare() may cut up its argument (strtok() and the like), so on several
+ * devices each run gets a copy of its own. The copies stay around until
+ * the end of the run, the option state can point into them.
+ */
+static char **arg_copies;
+static int n_arg_copies;
+
+static char *uqmi_cmd_arg(const struct uqmi_cmd *cmd)
+{
+	char **copies;
+	char *arg;
+
+	if (!multi_device || !cmd->arg)
+		return cmd->arg;
+
+	copies = realloc(arg_copies, (n_arg_copies + 1) * sizeof(*copies));
+	if (!copies)
+		return NULL;
+
+	arg_copies = copies;
+	arg = strdup(cmd->arg);
+	if (arg)
+		arg_copies[n_arg_copies++] = arg;
+
+	return arg;
+}
+
+static void uqmi_free_args(void)
+{
+	while (n_arg_copies > 0)
+		free(arg_copies[--n_arg_copies]);
+
+	free(arg_copies);
+	arg_copies = NULL;
+}
+
+/*
+ * Outside of a batch only the result itself is printed, commands without
+ * any output print nothing. Batch lines get one JSON object per action,
+ * tagged with the line number, and so does every device of a run on
+ * several of them.
+ */
+static void uqmi_print_result(struct qmi_dev *qmi, const struct uqmi_cmd *cmd,
+			      bool error, struct blob_attr *data)
+{
+	/* with --stream, only errors are left in status */
+	bool streamed = uqmi_output_end() > 0;
+	bool tagged = cmd->line || multi_device;
+	char *str = NULL;
+
+	if ((!tagged || streamed) && !blob_len(data))
 		return;
 
-	printf("%s\n", str);
+	if (blob_len(data)) {
+		str = blobmsg_format_json_indent(blob_data(data), false,
+						 single_line || tagged ? -1 : 0);
+		if (!str)
+			return;
+	}
+
+	if (!tagged) {
+		printf("%s\n", str);
+	} else if (str || cmd->handler->type != CMD_TYPE_OPTION) {
+		if (cmd->line)
+			printf("{\"line\":%d", cmd->line);
+		else
+			printf("{\"device\":\"%s\"", qmi->name);
+		if (str)
+			printf(",\"%s\":%s", error ? "error" : "result", str);
+		printf("}\n");
+	}
+
 	free(str);
 }
 
-static bool __uqmi_run_commands(struct qmi_dev *qmi, bool option)
+void uqmi_print_error(int line, const char *msg)
 {
-	static struct qmi_request req;
-	char *buf = qmi->buf;
+	struct uqmi_cmd cmd = { .line = line };
+
+	blob_buf_init(&status, 0);
+	uqmi_add_error(msg);
+	uqmi_print_result(NULL, &cmd, true, status.head);
+}
+
+/*
+ * Actions are sent to the modem as soon as the ones they depend on (see
+ * uqmi_cmd_depends()) got their response, so independent requests are in
+ * flight together and the responses are collected in whatever order they
+ * arrive. Each one gets its own status buffer, which is swapped in while its
+ * prepare and cb run, and the results are printed in command order once the
+ * requests in flight are waited for.
+ */
+struct uqmi_pending {
+	struct qmi_request req;
+	struct qmi_dev *qmi;
+	const struct uqmi_cmd *cmd;
+	enum qmi_cmd_result res;
+	struct blob_buf status;
+};
+
+static struct uqmi_pending *pending;
+static int n_pending;
+
+/* queries of a QMI service, they have no outputs */
+static bool uqmi_cmd_query(const struct uqmi_cmd_handler *handler)
+{
+	/* streamed output goes out as it comes, so it has to come in order */
+	if (uqmi_stream)
+		return false;
+
+	return handler->type > QMI_SERVICE_CTL && !handler->out;
+}
+
+static bool uqmi_cmd_overlap(const struct uqmi_cmd_handler *a, unsigned int a_deps,
+			     const struct uqmi_cmd_handler *b, unsigned int b_deps)
+{
+	if (a_deps & b_deps & ~CMD_MODEM_MASK)
+		return true;
+
+	if (!(a_deps & CMD_MODEM_MASK) || !(b_deps & CMD_MODEM_MASK))
+		return false;
+
+	return ((a_deps | b_deps) & CMD_MODEM) || a->type == b->type;
+}
+
+/* cmd has to wait for the response to prev, which comes before it */
+static bool uqmi_cmd_depends(const struct uqmi_cmd_handler *cmd,
+			     const struct uqmi_cmd_handler *prev)
+{
+	/* an error stops the commands after it, so changes wait for all of them */
+	if (cmd->out)
+		return true;
+
+	return uqmi_cmd_overlap(cmd, cmd->in, prev, prev->out);
+}
+
+static void uqmi_swap_status(struct blob_buf *buf)
+{
+	struct blob_buf tmp = status;
+
+	status = *buf;
+	*buf = tmp;
+}
+
+static void uqmi_pending_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	struct uqmi_pending *p = container_of(req, struct uqmi_pending, req);
+
+	uqmi_swap_status(&p->status);
+	p->cmd->handler->cb(qmi, req, msg);
+	uqmi_swap_status(&p->status);
+}
+
+static enum qmi_cmd_result
+uqmi_cmd_prepare(struct qmi_dev *qmi, struct qmi_request *req, const struct uqmi_cmd *cmd)
+{
+	char *arg = uqmi_cmd_arg(cmd);
+
+	if (cmd->arg && !arg)
+		return uqmi_add_error("Out of memory");
+
+	req->cb_data = NULL;
+	return cmd->handler->prepare(qmi, req, qmi->buf, arg);
+}
+
+static void uqmi_start_pending(struct qmi_dev *qmi, struct uqmi_cmd *cmd)
+{
+	struct uqmi_pending *p = &pending[n_pending++];
+
+	memset(p, 0, sizeof(*p));
+	p->qmi = qmi;
+	p->cmd = cmd;
+	blob_buf_init(&p->status, 0);
+	uqmi_swap_status(&p->status);
+
+	if (cmd->handler->type > QMI_SERVICE_CTL &&
+	    qmi_service_connect(qmi, cmd->handler->type, -1)) {
+		uqmi_add_error("Failed to connect to service");
+		p->res = QMI_CMD_EXIT;
+	} else {
+		p->res = uqmi_cmd_prepare(qmi, &p->req, cmd);
+	}
+
+	if (p->res == QMI_CMD_REQUEST) {
+		qmi_request_start(qmi, &p->req, uqmi_pending_cb);
+		p->req.no_error_cb = true;
+	}
+
+	uqmi_swap_status(&p->status);
+}
+
+static bool uqmi_flush_pending(void)
+{
+	struct qmi_dev *failed_qmi = NULL;
+	int failed_line = -1;
+	bool ret = true;
 	int i;
 
-	for (i = 0; i < n_cmds; i++) {
+	for (i = 0; i < n_pending; i++) {
+		struct uqmi_pending *p = &pending[i];
+		struct qmi_dev *qmi = p->qmi;
+
+		if (qmi == failed_qmi && p->cmd->line == failed_line) {
+			/* the output stops at the first error (of a batch line) */
+			qmi_request_cancel(qmi, &p->req);
+		} else {
+			if (p->res == QMI_CMD_REQUEST && qmi_request_wait(qmi, &p->req)) {
+				uqmi_swap_status(&p->status);
+				uqmi_add_error(qmi_get_error_str(p->req.ret));
+				uqmi_swap_status(&p->status);
+				p->res = QMI_CMD_EXIT;
+			}
+
+			uqmi_print_result(qmi, p->cmd, p->res == QMI_CMD_EXIT, p->status.head);
+			if (p->res == QMI_CMD_EXIT) {
+				failed_qmi = qmi;
+				failed_line = p->cmd->line;
+				ret = false;
+			}
+		}
+
+		blob_buf_free(&p->status);
+	}
+	n_pending = 0;
+
+	return ret;
+}
+
+static bool __uqmi_run_commands(struct qmi_dev *qmi, int first, int last, bool option)
+{
+	static struct qmi_request req;
+	int i, j;
+
+	for (i = first; i < last; i++) {
 		enum qmi_cmd_result res;
 		bool cmd_option = cmds[i].handler->type == CMD_TYPE_OPTION;
 		bool do_break = false;
@@ -226,13 +521,35 @@ static bool __uqmi_run_commands(struct qmi_dev *qmi, bool option)
 		if (cmd_option != option)
 			continue;
 
+		if (!option) {
+			for (j = 0; j < n_pending; j++)
+				if (uqmi_cmd_depends(cmds[i].handler, pending[j].cmd->handler))
+					break;
+
+			if (j < n_pending && !uqmi_flush_pending())
+				return false;
+
+			if (!uqmi_stream) {
+				uqmi_start_pending(qmi, &cmds[i]);
+				if (pending[n_pending - 1].res == QMI_CMD_EXIT) {
+					uqmi_flush_pending();
+					return false;
+				}
+				continue;
+			}
+		}
+
+		if (!uqmi_flush_pending())
+			return false;
+
 		blob_buf_init(&status, 0);
+		uqmi_output_start(cmds[i].line);
 		if (cmds[i].handler->type > QMI_SERVICE_CTL &&
 		    qmi_service_connect(qmi, cmds[i].handler->type, -1)) {
 			uqmi_add_error("Failed to connect to service");
 			res = QMI_CMD_EXIT;
 		} else {
-			res = cmds[i].handler->prepare(qmi, &req, (void *) buf, cmds[i].arg);
+			res = uqmi_cmd_prepare(qmi, &req, &cmds[i]);
 		}
 
 		if (res == QMI_CMD_REQUEST) {
@@ -246,11 +563,51 @@ static bool __uqmi_run_commands(struct qmi_dev *qmi, bool option)
 			do_break = true;
 		}
 
-		uqmi_print_result(status.head);
+		uqmi_print_result(qmi, &cmds[i], do_break, status.head);
 		if (do_break)
 			return false;
 	}
-	return true;
+	return uqmi_flush_pending();
+}
+
+void uqmi_save_commands(void)
+{
+	unsigned int len = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(uqmi_option_state); i++)
+		len += uqmi_option_state[i].len;
+
+	free(saved_state);
+	saved_state = malloc(len);
+	if (!saved_state)
+		return;
+
+	for (i = 0, len = 0; i < ARRAY_SIZE(uqmi_option_state); i++) {
+		memcpy(saved_state + len, uqmi_option_state[i].data, uqmi_option_state[i].len);
+		len += uqmi_option_state[i].len;
+	}
+}
+
+static void uqmi_restore_commands(void)
+{
+	unsigned int len = 0;
+	int i;
+
+	for (i = 0; saved_state && i < ARRAY_SIZE(uqmi_option_state); i++) {
+		memcpy(uqmi_option_state[i].data, saved_state + len, uqmi_option_state[i].len);
+		len += uqmi_option_state[i].len;
+	}
+}
+
+/* drop queued commands and restore the state from uqmi_save_commands() */
+void uqmi_reset_commands(void)
+{
+	free(cmds);
+	cmds = NULL;
+	n_cmds = 0;
+
+	uqmi_restore_commands();
 }
 
 int uqmi_add_error(const char *msg)
@@ -263,12 +620,135 @@ bool uqmi_run_commands(struct qmi_dev *qmi)
 {
 	bool ret;
 
-	ret = __uqmi_run_commands(qmi, true) &&
-	      __uqmi_run_commands(qmi, false);
+	/* in flight requests point into it, so it must not move */
+	pending = calloc(n_cmds, sizeof(*pending));
+	ret = __uqmi_run_commands(qmi, 0, n_cmds, true) &&
+	      __uqmi_run_commands(qmi, 0, n_cmds, false);
 
+	free(pending);
+	pending = NULL;
 	free(cmds);
 	cmds = NULL;
 	n_cmds = 0;
 
 	return ret;
 }
+
+/*
+ * Every batch line runs like a uqmi call of its own: options first, then
+ * the actions, and an error only stops the rest of that line. Lines of
+ * nothing but queries are not waited for, they go out together with the
+ * queries of the lines around them. The option state is put back to what
+ * uqmi_save_commands() saw after each line.
+ */
+bool uqmi_run_batch(struct qmi_dev *qmi)
+{
+	bool ret = true;
+	int first, last, n;
+
+	pending = calloc(n_cmds, sizeof(*pending));
+	for (first = 0; first < n_cmds; first = last) {
+		bool queries = true;
+		int i;
+
+		for (last = first; last < n_cmds && cmds[last].line == cmds[first].line; last++)
+			queries &= uqmi_cmd_query(cmds[last].handler);
+
+		if (queries) {
+			for (i = first; i < last; i++)
+				uqmi_start_pending(qmi, &cmds[i]);
+			continue;
+		}
+
+		if (!uqmi_flush_pending())
+			ret = false;
+
+		/* actions queued by the options of the line are part of it */
+		n = n_cmds;
+		uqmi_cmd_line = cmds[first].line;
+		if (!__uqmi_run_commands(qmi, first, last, true) ||
+		    !__uqmi_run_commands(qmi, first, last, false) ||
+		    !__uqmi_run_commands(qmi, n, n_cmds, false))
+			ret = false;
+
+		uqmi_cmd_line = 0;
+		n_cmds = n;
+		uqmi_restore_commands();
+	}
+
+	if (!uqmi_flush_pending())
+		ret = false;
+
+	free(pending);
+	pending = NULL;
+	uqmi_reset_commands();
+
+	return ret;
+}
+
+/*
+ * Runs the commands on several devices in one go. Each device gets the
+ * options first and then the actions, and an error only stops the rest of
+ * its own commands. A run of queries is sent to every device before any
+ * response is waited for, so it takes as long as the slowest device does.
+ * The other actions go to one device after the other.
+ */
+bool uqmi_run_devices(struct qmi_dev **devs, int n_devs)
+{
+	bool *failed;
+	bool ret = true;
+	int first, last;
+	int i, d, n;
+
+	failed = calloc(n_devs, sizeof(*failed));
+	pending = calloc(n_cmds * n_devs, sizeof(*pending));
+	multi_device = true;
+
+	for (d = 0; d < n_devs; d++)
+		failed[d] = !__uqmi_run_commands(devs[d], 0, n_cmds, true);
+
+	for (first = 0; first < n_cmds; first = last) {
+		last = first + 1;
+		if (cmds[first].handler->type == CMD_TYPE_OPTION)
+			continue;
+
+		if (!uqmi_cmd_query(cmds[first].handler)) {
+			for (d = 0; d < n_devs; d++)
+				if (!failed[d])
+					failed[d] = !__uqmi_run_commands(devs[d], first, last, false);
+			continue;
+		}
+
+		while (last < n_cmds && uqmi_cmd_query(cmds[last].handler))
+			last++;
+
+		for (d = 0; d < n_devs; d++)
+			for (i = first; !failed[d] && i < last; i++)
+				uqmi_start_pending(devs[d], &cmds[i]);
+
+		/* the entries stay around, look for the devices that failed */
+		n = n_pending;
+		uqmi_flush_pending();
+		for (i = 0; i < n; i++) {
+			if (pending[i].res != QMI_CMD_EXIT)
+				continue;
+
+			for (d = 0; d < n_devs; d++)
+				if (devs[d] == pending[i].qmi)
+					failed[d] = true;
+		}
+	}
+
+	for (d = 0; d < n_devs; d++)
+		if (failed[d])
+			ret = false;
+
+	multi_device = false;
+	uqmi_free_args();
+	free(pending);
+	pending = NULL;
+	free(failed);
+	uqmi_reset_commands();
+
+	return ret;
+}
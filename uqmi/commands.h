@@ -42,9 +42,53 @@ enum {
 	CMD_TYPE_OPTION = -1,
 };
 
+/*
+ * State kept by the option commands for the actions that come after them,
+ * see uqmi_option_state in commands.c.
+ */
+#define __uqmi_option_states \
+	__uqmi_option_state(wds_sn_req), \
+	__uqmi_option_state(wds_stn_req), \
+	__uqmi_option_state(wds_mp_req), \
+	__uqmi_option_state(wds_cp_req), \
+	__uqmi_option_state(wds_endpoint_info), \
+	__uqmi_option_state(dms_req_data), \
+	__uqmi_option_state(wda_aggregation_info), \
+	__uqmi_option_state(tx_rx_req), \
+	__uqmi_option_state(sel_req), \
+	__uqmi_option_state(scan_req), \
+	__uqmi_option_state(plmn_code_flag), \
+	__uqmi_option_state(lmreq), \
+	__uqmi_option_state(dmreq), \
+	__uqmi_option_state(gmreq), \
+	__uqmi_option_state(_send), \
+	__uqmi_option_state(uim_slot), \
+	__uqmi_option_state(channel_id), \
+	__uqmi_option_state(aid)
+
+#define __uqmi_option_state(_var) __UQMI_STATE_##_var
+enum uqmi_option_state {
+	__uqmi_option_states,
+	__UQMI_STATE_LAST
+};
+#undef __uqmi_option_state
+
+/*
+ * Inputs and outputs of a command: the option state it reads or sets, and
+ * the state of the modem behind its own service (CMD_SERVICE) or behind
+ * all of them (CMD_MODEM). Queries only have inputs. The actions are
+ * ordered by these, see uqmi_cmd_depends().
+ */
+#define CMD_STATE(_var)		(1U << __UQMI_STATE_##_var)
+#define CMD_SERVICE		(1U << 30)
+#define CMD_MODEM		(1U << 31)
+#define CMD_MODEM_MASK		(CMD_SERVICE | CMD_MODEM)
+
 struct uqmi_cmd_handler {
 	const char *name;
 	int type;
+	unsigned int in;
+	unsigned int out;
 
 	enum qmi_cmd_result (*prepare)(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, char *arg);
 	void (*cb)(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg);
@@ -53,14 +97,23 @@ struct uqmi_cmd_handler {
 struct uqmi_cmd {
 	const struct uqmi_cmd_handler *handler;
 	char *arg;
+	int line;
+};
+
+/* decoder of an indication, NULL prints its TLVs as they are */
+struct uqmi_indication {
+	QmiService service;
+	uint16_t message;
+	const char *name;
+	request_cb cb;
 };
 
 #define __uqmi_commands \
-	__uqmi_command(version, get-versions, no, QMI_SERVICE_CTL), \
-	__uqmi_command(sync, sync, no, QMI_SERVICE_CTL), \
-	__uqmi_command(set_client_id, set-client-id, required, CMD_TYPE_OPTION), \
-	__uqmi_command(get_client_id, get-client-id, required, QMI_SERVICE_CTL), \
-	__uqmi_command(ctl_set_data_format, set-data-format, required, QMI_SERVICE_CTL), \
+	__uqmi_command(version, get-versions, no, QMI_SERVICE_CTL, CMD_SERVICE, 0), \
+	__uqmi_command(sync, sync, no, QMI_SERVICE_CTL, CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(set_client_id, set-client-id, required, CMD_TYPE_OPTION, 0, 0), \
+	__uqmi_command(get_client_id, get-client-id, required, QMI_SERVICE_CTL, CMD_SERVICE, CMD_MODEM), \
+	__uqmi_command(ctl_set_data_format, set-data-format, required, QMI_SERVICE_CTL, CMD_SERVICE, CMD_MODEM), \
 	__uqmi_wds_commands, \
 	__uqmi_dms_commands, \
 	__uqmi_nas_commands, \
@@ -68,7 +121,7 @@ struct uqmi_cmd {
 	__uqmi_wda_commands, \
 	__uqmi_uim_commands
 
-#define __uqmi_command(_name, _optname, _arg, _option) __UQMI_COMMAND_##_name
+#define __uqmi_command(_name, _optname, _arg, _option, _in, _out) __UQMI_COMMAND_##_name
 enum uqmi_command {
 	__uqmi_commands,
 	__UQMI_COMMAND_LAST
@@ -76,10 +129,20 @@ enum uqmi_command {
 #undef __uqmi_command
 
 extern bool single_line;
+/* batch input line of the commands added next, 0 when not in a batch */
+extern int uqmi_cmd_line;
 extern const struct uqmi_cmd_handler uqmi_cmd_handler[];
 extern struct blob_buf status;
 void uqmi_add_command(char *arg, int longidx);
+bool uqmi_cmd_queued(int cmd);
 bool uqmi_run_commands(struct qmi_dev *qmi);
+void uqmi_save_commands(void);
+void uqmi_reset_commands(void);
+bool uqmi_run_batch(struct qmi_dev *qmi);
+bool uqmi_run_devices(struct qmi_dev **devs, int n_devs);
+void uqmi_drop_commands(int line);
+void uqmi_print_error(int line, const char *msg);
 int uqmi_add_error(const char *msg);
+const struct uqmi_indication *uqmi_find_indication(QmiService service, uint16_t message);
 
 #endif
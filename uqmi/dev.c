@@ -25,10 +25,13 @@
 #include <stdio.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/file.h>
+#include <sys/stat.h>
 #include "uqmi.h"
 #include "qmi-errors.h"
-#include "qmi-errors.c"
 #include "mbim.h"
+#include "utils.h"
+#include "capture.h"
 
 bool cancel_all_requests = false;
 
@@ -63,6 +66,133 @@ qmi_get_service_idx(QmiService svc)
 	return -1;
 }
 
+/*
+ * With --cid-cache <dir>, the client IDs allocated for a device are not
+ * released on exit but stored in a file of the directory named after the
+ * device, together with the next transaction ID, and the next uqmi on the
+ * device picks them up instead of allocating new ones.
+ *
+ * The file stays locked while the device is open. A uqmi that finds it
+ * locked does without the cache, so that no two processes ever use the
+ * same client ID. The entries are dropped if the device node changed
+ * (the modem was reset), on a SYNC and when a request on a cached client
+ * ID is rejected or times out.
+ */
+static char *qmi_cid_cache_path(struct qmi_dev *qmi)
+{
+	char *dev, *path, *p;
+
+	dev = realpath(qmi->name, NULL);
+	if (!dev)
+		return NULL;
+
+	path = malloc(strlen(qmi->cid_cache) + strlen(dev) + 2);
+	if (path) {
+		p = path + sprintf(path, "%s/", qmi->cid_cache);
+		for (strcpy(p, dev + 1); *p; p++)
+			if (*p == '/')
+				*p = '_';
+	}
+
+	free(dev);
+	return path;
+}
+
+static void qmi_cid_cache_load(struct qmi_dev *qmi)
+{
+	unsigned long long rdev;
+	long long ctime;
+	char buf[1024];
+	char *path, *line, *next;
+	struct stat st;
+	int svc, cid, tid, idx;
+	int fd, len;
+
+	qmi->cid_cache_fd = -1;
+	if (!qmi->cid_cache || fstat(qmi->sf.fd.fd, &st))
+		return;
+
+	path = qmi_cid_cache_path(qmi);
+	if (!path)
+		return;
+
+	fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	free(path);
+	if (fd < 0)
+		return;
+
+	if (flock(fd, LOCK_EX | LOCK_NB)) {
+		close(fd);
+		return;
+	}
+
+	qmi->cid_cache_fd = fd;
+	len = read(fd, buf, sizeof(buf) - 1);
+	if (len <= 0)
+		return;
+
+	buf[len] = 0;
+	line = strtok_r(buf, "\n", &next);
+	if (!line || sscanf(line, "%llx %lld", &rdev, &ctime) != 2 ||
+	    rdev != st.st_rdev || ctime != st.st_ctime)
+		return;
+
+	while ((line = strtok_r(NULL, "\n", &next)) != NULL) {
+		if (sscanf(line, "%d %d %d", &svc, &cid, &tid) != 3)
+			continue;
+
+		idx = qmi_get_service_idx(svc);
+		if (idx < 0)
+			continue;
+
+		qmi->service_data[idx].connected = true;
+		qmi->service_data[idx].client_id = cid;
+		qmi->service_data[idx].tid = tid;
+		qmi->service_connected |= (1 << idx);
+		qmi->service_cached |= (1 << idx);
+	}
+}
+
+static void qmi_cid_cache_save(struct qmi_dev *qmi)
+{
+	int fd = qmi->cid_cache_fd;
+	struct stat st;
+	int idx;
+
+	if (fd < 0)
+		return;
+
+	if (!fstat(qmi->sf.fd.fd, &st) && !ftruncate(fd, 0) &&
+	    lseek(fd, 0, SEEK_SET) == 0) {
+		dprintf(fd, "%llx %lld\n", (unsigned long long) st.st_rdev,
+			(long long) st.st_ctime);
+		for (idx = 0; idx < __QMI_SERVICE_LAST; idx++) {
+			if (!(qmi->service_cached & (1 << idx)))
+				continue;
+
+			dprintf(fd, "%d %d %d\n", qmi_services[idx],
+				qmi->service_data[idx].client_id,
+				qmi->service_data[idx].tid);
+		}
+	}
+
+	/* also releases the lock */
+	close(fd);
+	qmi->cid_cache_fd = -1;
+}
+
+static void qmi_cid_cache_drop(struct qmi_dev *qmi, uint8_t service)
+{
+	int idx = qmi_get_service_idx(service);
+
+	if (idx < 0 || !(qmi->service_cached & (1 << idx)))
+		return;
+
+	qmi->service_cached &= ~(1 << idx);
+	qmi->service_connected &= ~(1 << idx);
+	qmi->service_data[idx].connected = false;
+}
+
 static bool qmi_message_is_response(struct qmi_msg *msg)
 {
 	if (msg->qmux.service == QMI_SERVICE_CTL) {
@@ -91,7 +221,7 @@ static bool qmi_message_is_indication(struct qmi_msg *msg)
 	return false;
 }
 
-static void __qmi_request_complete(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+static void __qmi_request_complete(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg, int error)
 {
 	void *tlv_buf;
 	int tlv_len;
@@ -101,6 +231,8 @@ static void __qmi_request_complete(struct qmi_dev *qmi, struct qmi_request *req,
 
 	req->pending = false;
 	list_del(&req->list);
+	qmi_req_table_del(&qmi->req_table, req->key);
+	qmi_timer_cancel(&req->timer);
 
 	if (msg) {
 		tlv_buf = qmi_msg_get_tlv_buf(msg, &tlv_len);
@@ -108,9 +240,14 @@ static void __qmi_request_complete(struct qmi_dev *qmi, struct qmi_request *req,
 		if (req->ret)
 			msg = NULL;
 	} else {
-		req->ret = QMI_ERROR_CANCELLED;
+		req->ret = error;
 	}
 
+	/* a cached client ID the modem no longer knows, allocate a new one */
+	if (req->ret == QMI_PROTOCOL_ERROR_INVALID_CLIENT_ID ||
+	    req->ret == QMI_ERROR_TIMEOUT)
+		qmi_cid_cache_drop(qmi, req->service);
+
 	if (req->cb && (msg || !req->no_error_cb))
 		req->cb(qmi, req, msg);
 
@@ -137,7 +274,11 @@ static void qmi_process_msg(struct qmi_dev *qmi, struct qmi_msg *msg)
 					req = list_first_entry(&qmi->req, struct qmi_request, list);
 					qmi_request_cancel(qmi, req);
 				}
+				qmi->service_connected = 0;
+				qmi->service_cached = 0;
 			}
+		} else if (qmi->indication_cb) {
+			qmi->indication_cb(qmi, msg);
 		}
 
 		return;
@@ -151,38 +292,30 @@ static void qmi_process_msg(struct qmi_dev *qmi, struct qmi_msg *msg)
 	else
 		tid = le16_to_cpu(msg->svc.transaction);
 
-	list_for_each_entry(req, &qmi->req, list) {
-		if (req->service != msg->qmux.service)
-			continue;
-
-		if (req->tid != tid)
-			continue;
-
-		__qmi_request_complete(qmi, req, msg);
-		return;
-	}
+	req = qmi_req_table_find(&qmi->req_table,
+				 qmi_req_key(msg->qmux.service, msg->qmux.client, tid));
+	if (req)
+		__qmi_request_complete(qmi, req, msg, 0);
 }
 
 static void qmi_notify_read(struct ustream *us, int bytes)
 {
 	struct qmi_dev *qmi = container_of(us, struct qmi_dev, sf.stream);
 	struct qmi_msg *msg;
+	struct iovec iov;
 	char *buf;
-	int len, msg_len;
-
+	int len, msg_len, hdr_len = 0;
 
 	while (1) {
-		buf = ustream_get_read_buf(us, &len);
-		if (!buf || !len)
+		len = qmi->is_mbim ? sizeof(struct mbim_command_message) :
+				     offsetof(struct qmi_msg, flags);
+		buf = ustream_get_read_buf_len(us, len, &qmi->rx_buf, &qmi->rx_buf_len);
+		if (!buf)
 			return;
 
-		dump_packet("Received packet", buf, len);
 		if (qmi->is_mbim) {
 			struct mbim_command_message *mbim = (void *) buf;
 
-			if (len < sizeof(*mbim))
-				return;
-			msg = (struct qmi_msg *) (buf + sizeof(*mbim));
 			msg_len = le32_to_cpu(mbim->header.length);
 			if (!is_mbim_qmi(mbim)) {
 				/* must consume other MBIM packets */
@@ -190,29 +323,49 @@ static void qmi_notify_read(struct ustream *us, int bytes)
 				return;
 			}
 		} else {
-			if (len < offsetof(struct qmi_msg, flags))
-				return;
 			msg = (struct qmi_msg *) buf;
 			msg_len = le16_to_cpu(msg->qmux.len) + 1;
 		}
 
-		if (len < msg_len)
+		/* large messages may span several read buffers */
+		buf = ustream_get_read_buf_len(us, msg_len, &qmi->rx_buf, &qmi->rx_buf_len);
+		if (!buf)
 			return;
 
+		dump_packet("Received packet", buf, msg_len);
+		if (qmi->is_mbim)
+			hdr_len = sizeof(struct mbim_command_message);
+
+		msg = (struct qmi_msg *) (buf + hdr_len);
+		iov.iov_base = msg;
+		iov.iov_len = msg_len - hdr_len;
+		qmi_capture_frame(qmi->name, false, &iov, 1);
 		qmi_process_msg(qmi, msg);
 		ustream_consume(us, msg_len);
 	}
 }
 
+static void qmi_request_timeout_cb(struct qmi_timer *t)
+{
+	struct qmi_request *req = container_of(t, struct qmi_request, timer);
+
+	__qmi_request_complete(req->qmi, req, NULL, QMI_ERROR_TIMEOUT);
+}
+
 int qmi_request_start(struct qmi_dev *qmi, struct qmi_request *req, request_cb cb)
 {
 	struct qmi_msg *msg = qmi->buf;
 	int len = qmi_complete_request_message(msg);
+	struct iovec iov = { msg, len };
+	void *cb_data = req->cb_data;
 	uint16_t tid;
-	void *buf = (void *) qmi->buf;
+	int ret;
 
 	memset(req, 0, sizeof(*req));
+	req->cb_data = cb_data;
 	req->ret = -1;
+	req->qmi = qmi;
+	req->timer.cb = qmi_request_timeout_cb;
 	req->service = msg->qmux.service;
 	if (req->service == QMI_SERVICE_CTL) {
 		tid = qmi->ctl_tid++;
@@ -228,26 +381,42 @@ int qmi_request_start(struct qmi_dev *qmi, struct qmi_request *req, request_cb c
 		msg->qmux.client = qmi->service_data[idx].client_id;
 	}
 
+	req->key = qmi_req_key(msg->qmux.service, msg->qmux.client, tid);
+	ret = qmi_req_table_add(&qmi->req_table, req->key, req);
+	if (ret)
+		return ret;
+
 	req->tid = tid;
 	req->cb = cb;
 	req->pending = true;
 	list_add(&req->list, &qmi->req);
+	if (qmi->timeout)
+		qmi_timer_set(&req->timer, qmi->timeout);
+
+	dump_packet("Send packet", msg, len);
+	qmi_capture_frame(qmi->name, true, &iov, 1);
 
+	/*
+	 * cdc-wdm turns every write() into a message of its own, the MBIM
+	 * header goes into the headroom of qmi_request_buf() instead
+	 */
 	if (qmi->is_mbim) {
-		buf -= sizeof(struct mbim_command_message);
-		mbim_qmi_cmd((struct mbim_command_message *) buf, len, tid);
-		len += sizeof(struct mbim_command_message);
+		struct mbim_command_message *mbim = (void *) ((char *) msg - sizeof(*mbim));
+
+		mbim_qmi_cmd(mbim, len, tid);
+		dump_packet("Send MBIM header", mbim, sizeof(*mbim));
+		iov.iov_base = mbim;
+		iov.iov_len += sizeof(*mbim);
 	}
 
-	dump_packet("Send packet", buf, len);
-	ustream_write(&qmi->sf.stream, buf, len, false);
+	ustream_fd_writev(&qmi->sf, &iov, 1);
 	return 0;
 }
 
 void qmi_request_cancel(struct qmi_dev *qmi, struct qmi_request *req)
 {
 	req->cb = NULL;
-	__qmi_request_complete(qmi, req, NULL);
+	__qmi_request_complete(qmi, req, NULL, QMI_ERROR_CANCELLED);
 }
 
 /*! Run uloop until the request has been completed
@@ -271,7 +440,8 @@ int qmi_request_wait(struct qmi_dev *qmi, struct qmi_request *req)
 	while (!complete) {
 		cancelled = uloop_cancelled;
 		uloop_cancelled = false;
-		uloop_run();
+		if (!cancel_all_requests)
+			uloop_run();
 
 		if (cancel_all_requests)
 			qmi_request_cancel(qmi, req);
@@ -285,6 +455,28 @@ int qmi_request_wait(struct qmi_dev *qmi, struct qmi_request *req)
 	return req->ret;
 }
 
+static void __qmi_service_disconnect(struct qmi_dev *qmi, int idx)
+{
+	int client_id = qmi->service_data[idx].client_id;
+	struct qmi_ctl_release_cid_request creq = {
+		QMI_INIT_SEQUENCE(release_info,
+			.service = qmi_services[idx],
+			.cid = client_id,
+		)
+	};
+	struct qmi_request req = {};
+	struct qmi_msg *msg = qmi->buf;
+
+	qmi->service_connected &= ~(1 << idx);
+	qmi->service_cached &= ~(1 << idx);
+	qmi->service_data[idx].client_id = -1;
+	qmi->service_data[idx].tid = 0;
+
+	qmi_set_ctl_release_cid_request(msg, &creq);
+	qmi_request_start(qmi, &req, NULL);
+	qmi_request_wait(qmi, &req);
+}
+
 struct qmi_connect_request {
 	struct qmi_request req;
 	int cid;
@@ -307,13 +499,17 @@ int qmi_service_connect(struct qmi_dev *qmi, QmiService svc, int client_id)
 	struct qmi_ctl_allocate_cid_request creq = {
 		QMI_INIT(service, svc)
 	};
-	struct qmi_connect_request req;
+	struct qmi_connect_request req = {};
 	int idx = qmi_get_service_idx(svc);
 	struct qmi_msg *msg = qmi->buf;
 
 	if (idx < 0)
 		return -1;
 
+	/* an explicitly given client ID replaces a cached one */
+	if ((qmi->service_cached & (1 << idx)) && client_id >= 0)
+		__qmi_service_disconnect(qmi, idx);
+
 	if (qmi->service_connected & (1 << idx))
 		return 0;
 
@@ -326,6 +522,8 @@ int qmi_service_connect(struct qmi_dev *qmi, QmiService svc, int client_id)
 			return req.req.ret;
 
 		client_id = req.cid;
+		if (qmi->cid_cache_fd >= 0)
+			qmi->service_cached |= (1 << idx);
 	} else {
 		qmi->service_keep_cid |= (1 << idx);
 	}
@@ -338,27 +536,6 @@ int qmi_service_connect(struct qmi_dev *qmi, QmiService svc, int client_id)
 	return 0;
 }
 
-static void __qmi_service_disconnect(struct qmi_dev *qmi, int idx)
-{
-	int client_id = qmi->service_data[idx].client_id;
-	struct qmi_ctl_release_cid_request creq = {
-		QMI_INIT_SEQUENCE(release_info,
-			.service = qmi_services[idx],
-			.cid = client_id,
-		)
-	};
-	struct qmi_request req;
-	struct qmi_msg *msg = qmi->buf;
-
-	qmi->service_connected &= ~(1 << idx);
-	qmi->service_data[idx].client_id = -1;
-	qmi->service_data[idx].tid = 0;
-
-	qmi_set_ctl_release_cid_request(msg, &creq);
-	qmi_request_start(qmi, &req, NULL);
-	qmi_request_wait(qmi, &req);
-}
-
 int qmi_service_release_client_id(struct qmi_dev *qmi, QmiService svc)
 {
 	int idx = qmi_get_service_idx(svc);
@@ -372,11 +549,12 @@ static void qmi_close_all_services(struct qmi_dev *qmi)
 	int idx;
 
 	qmi->service_keep_cid &= ~qmi->service_release_cid;
+	qmi->service_cached &= ~qmi->service_release_cid;
 	for (idx = 0; connected; idx++, connected >>= 1) {
 		if (!(connected & 1))
 			continue;
 
-		if (qmi->service_keep_cid & (1 << idx))
+		if ((qmi->service_keep_cid | qmi->service_cached) & (1 << idx))
 			continue;
 
 		__qmi_service_disconnect(qmi, idx);
@@ -396,13 +574,6 @@ int qmi_service_get_client_id(struct qmi_dev *qmi, QmiService svc)
 
 int qmi_device_open(struct qmi_dev *qmi, const char *path)
 {
-	static struct {
-		struct mbim_command_message mbim;
-		union {
-			char buf[2048];
-			struct qmi_msg msg;
-		} u;
-	} __packed msgbuf;
 	struct ustream *us = &qmi->sf.stream;
 	int fd;
 
@@ -413,10 +584,12 @@ int qmi_device_open(struct qmi_dev *qmi, const char *path)
 		return -1;
 
 	us->notify_read = qmi_notify_read;
-	ustream_fd_init(&qmi->sf, fd);
+	ustream_fd_init_len(&qmi->sf, fd, sizeof(struct mbim_command_message) + QMI_MSG_MAX_LEN);
 	INIT_LIST_HEAD(&qmi->req);
 	qmi->ctl_tid = 1;
-	qmi->buf = msgbuf.u.buf;
+	qmi->buf = qmi_request_buf();
+	qmi->name = path;
+	qmi_cid_cache_load(qmi);
 
 	return 0;
 }
@@ -426,8 +599,12 @@ void qmi_device_close(struct qmi_dev *qmi)
 	struct qmi_request *req;
 
 	qmi_close_all_services(qmi);
+	qmi_cid_cache_save(qmi);
 	ustream_free(&qmi->sf.stream);
 	close(qmi->sf.fd.fd);
+	free(qmi->rx_buf);
+	qmi->rx_buf = NULL;
+	qmi->rx_buf_len = 0;
 
 	while (!list_empty(&qmi->req)) {
 		req = list_first_entry(&qmi->req, struct qmi_request, list);
@@ -437,24 +614,11 @@ void qmi_device_close(struct qmi_dev *qmi)
 
 QmiService qmi_service_get_by_name(const char *str)
 {
-	static const struct {
-		const char *name;
-		QmiService svc;
-	} services[] = {
-		{ "dms", QMI_SERVICE_DMS },
-		{ "nas", QMI_SERVICE_NAS },
-		{ "pds", QMI_SERVICE_PDS },
-		{ "wds", QMI_SERVICE_WDS },
-		{ "wms", QMI_SERVICE_WMS },
-		{ "wda", QMI_SERVICE_WDA },
-		{ "uim", QMI_SERVICE_UIM },
-	};
-	int i;
+	int svc;
 
-	for (i = 0; i < ARRAY_SIZE(services); i++) {
-		if (!strcasecmp(str, services[i].name))
-			return services[i].svc;
-	}
+	if (qmi_enum_value(&qmi_service_names, str, &svc) ||
+	    qmi_get_service_idx(svc) < 0)
+		return -1;
 
-	return -1;
+	return svc;
 }
@@ -0,0 +1,219 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * uqmi --monitor registers for the indications of the NAS, WDS, DMS and
+ * UIM services and prints every one that arrives as a line of JSON, until
+ * it is interrupted:
+ *
+ *   {"time":1700000000.123,"service":"nas","indication":"signal-info","data":{...}}
+ *
+ * Indications with the same contents as a get-* action are decoded like
+ * its response, the rest are printed as their raw TLVs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <libubox/blobmsg.h>
+#include <libubox/blobmsg_json.h>
+#include <libubox/utils.h>
+
+#include "uqmi.h"
+#include "utils.h"
+#include "commands.h"
+#include "output.h"
+
+static int monitor_wds_register(struct qmi_msg *msg)
+{
+	struct qmi_wds_set_event_report_request req = {
+		QMI_INIT(data_bearer_technology, true),
+		QMI_INIT(dormancy_status, true),
+		QMI_INIT(current_data_bearer_technology, true),
+		QMI_INIT(data_call_status, true),
+	};
+
+	return qmi_set_wds_set_event_report_request(msg, &req);
+}
+
+static int monitor_dms_register(struct qmi_msg *msg)
+{
+	struct qmi_dms_set_event_report_request req = {
+		QMI_INIT(power_state_reporting, true),
+		QMI_INIT(pin_state_reporting, true),
+		QMI_INIT(activation_state_reporting, true),
+		QMI_INIT(operating_mode_reporting, true),
+		QMI_INIT(uim_state_reporting, true),
+	};
+
+	return qmi_set_dms_set_event_report_request(msg, &req);
+}
+
+static int monitor_nas_register(struct qmi_msg *msg)
+{
+	struct qmi_nas_register_indications_request req = {
+		QMI_INIT(serving_system_events, true),
+		QMI_INIT(network_time, true),
+		QMI_INIT(system_info, true),
+		QMI_INIT(signal_info, true),
+	};
+
+	return qmi_set_nas_register_indications_request(msg, &req);
+}
+
+static int monitor_uim_register(struct qmi_msg *msg)
+{
+	struct qmi_uim_register_events_request req = {
+		QMI_INIT(event_registration_mask,
+			 QMI_UIM_EVENT_REGISTRATION_FLAG_CARD_STATUS |
+			 QMI_UIM_EVENT_REGISTRATION_FLAG_PHYSICAL_SLOT_STATUS),
+	};
+
+	return qmi_set_uim_register_events_request(msg, &req);
+}
+
+static const struct {
+	QmiService service;
+	const char *name;
+	int (*set_request)(struct qmi_msg *msg);
+} monitor_services[] = {
+	{ QMI_SERVICE_WDS, "wds", monitor_wds_register },
+	{ QMI_SERVICE_DMS, "dms", monitor_dms_register },
+	{ QMI_SERVICE_NAS, "nas", monitor_nas_register },
+	{ QMI_SERVICE_UIM, "uim", monitor_uim_register },
+};
+
+static const char *monitor_service_name(QmiService service)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(monitor_services); i++)
+		if (monitor_services[i].service == service)
+			return monitor_services[i].name;
+
+	return NULL;
+}
+
+static void monitor_add_tlvs(struct qmi_msg *msg)
+{
+	unsigned int len;
+	struct tlv *tlv;
+	char name[8];
+	void *buf, *c;
+	int tlv_len;
+
+	buf = qmi_msg_get_tlv_buf(msg, &tlv_len);
+	len = tlv_len;
+
+	c = uqmi_open_table(NULL);
+	while ((tlv = tlv_get_next(&buf, &len)) != NULL) {
+		unsigned int data_len = tlv_data_len(tlv);
+		char *str;
+
+		sprintf(name, "0x%02x", tlv->type);
+		str = uqmi_alloc_string_buffer(name, data_len * 2 + 1);
+		uqmi_hexstring_create((uint8_t *) str, tlv->data, data_len);
+		str[data_len * 2] = 0;
+		uqmi_add_string_buffer();
+	}
+	uqmi_close_table(c);
+}
+
+static void monitor_indication_cb(struct qmi_dev *qmi, struct qmi_msg *msg)
+{
+	const struct uqmi_indication *ind;
+	uint16_t message = le16_to_cpu(msg->svc.message);
+	const char *service = monitor_service_name(msg->qmux.service);
+	struct timespec ts;
+	char *data = NULL;
+
+	if (!service)
+		return;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+
+	blob_buf_init(&status, 0);
+	ind = uqmi_find_indication(msg->qmux.service, message);
+	if (ind && ind->cb)
+		ind->cb(qmi, NULL, msg);
+	else
+		monitor_add_tlvs(msg);
+
+	if (blob_len(status.head))
+		data = blobmsg_format_json_indent(blob_data(status.head), false, -1);
+
+	printf("{\"time\":%lld.%03ld,\"service\":\"%s\",",
+	       (long long) ts.tv_sec, ts.tv_nsec / 1000000, service);
+	if (ind)
+		printf("\"indication\":\"%s\"", ind->name);
+	else
+		printf("\"indication\":\"0x%04x\"", message);
+	if (data)
+		printf(",\"data\":%s", data);
+	printf("}\n");
+	fflush(stdout);
+
+	free(data);
+}
+
+static bool monitor_register(struct qmi_dev *qmi, int idx)
+{
+	const char *name = monitor_services[idx].name;
+	struct qmi_request req = {};
+	int ret;
+
+	if (qmi_service_connect(qmi, monitor_services[idx].service, -1)) {
+		fprintf(stderr, "Failed to connect to service %s\n", name);
+		return false;
+	}
+
+	monitor_services[idx].set_request(qmi->buf);
+	qmi_request_start(qmi, &req, NULL);
+	ret = qmi_request_wait(qmi, &req);
+	if (ret) {
+		fprintf(stderr, "Failed to register for %s indications: %s\n",
+			name, qmi_get_error_str(ret));
+		return false;
+	}
+
+	return true;
+}
+
+int uqmi_monitor_run(struct qmi_dev *qmi)
+{
+	int n_registered = 0;
+	int i;
+
+	/* every indication is printed as one line anyway */
+	uqmi_stream = false;
+
+	qmi->indication_cb = monitor_indication_cb;
+	for (i = 0; i < ARRAY_SIZE(monitor_services) && !cancel_all_requests; i++)
+		n_registered += monitor_register(qmi, i);
+
+	if (n_registered && !cancel_all_requests)
+		uloop_run();
+
+	qmi->indication_cb = NULL;
+
+	return n_registered ? 0 : -1;
+}
@@ -0,0 +1,307 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libubox/blobmsg.h>
+
+#include "uqmi.h"
+#include "commands.h"
+#include "output.h"
+
+#define OUTPUT_MAX_DEPTH	16
+
+bool uqmi_stream;
+
+static struct {
+	int line;
+	int records;
+
+	/* elements of a top level array are records of their own */
+	int record_depth;
+	int depth;
+	struct {
+		bool array;
+		bool first;
+	} stack[OUTPUT_MAX_DEPTH];
+
+	char *str_name;
+	char *str;
+	unsigned int str_len;
+} out;
+
+/* same escaping as blobmsg_format_json() */
+static void output_string(const char *str)
+{
+	const unsigned char *p;
+	char escape;
+
+	putchar('"');
+	for (p = (const unsigned char *) str; *p; p++) {
+		switch (*p) {
+		case '\b': escape = 'b'; break;
+		case '\n': escape = 'n'; break;
+		case '\t': escape = 't'; break;
+		case '\r': escape = 'r'; break;
+		case '"': escape = '"'; break;
+		case '\\': escape = '\\'; break;
+		default: escape = 0; break;
+		}
+
+		if (escape)
+			printf("\\%c", escape);
+		else if (*p < ' ')
+			printf("\\u%04x", *p);
+		else
+			putchar(*p);
+	}
+	putchar('"');
+}
+
+/* separator and name of a new element, or the start of a record */
+static void output_element(const char *name)
+{
+	if (out.depth == out.record_depth) {
+		if (out.line)
+			printf("{\"line\":%d,\"result\":", out.line);
+		return;
+	}
+
+	if (!out.stack[out.depth - 1].first)
+		putchar(',');
+	out.stack[out.depth - 1].first = false;
+
+	if (!out.stack[out.depth - 1].array) {
+		output_string(name ? name : "");
+		putchar(':');
+	}
+}
+
+static void output_element_done(void)
+{
+	if (out.depth != out.record_depth)
+		return;
+
+	if (out.line)
+		putchar('}');
+	putchar('\n');
+	/* readers may act on a record before the command is done */
+	fflush(stdout);
+	out.records++;
+}
+
+static void *output_open(const char *name, bool array)
+{
+	if (out.depth == OUTPUT_MAX_DEPTH)
+		return NULL;
+
+	if (array && out.depth == out.record_depth && !out.depth) {
+		out.record_depth = 1;
+	} else {
+		output_element(name);
+		putchar(array ? '[' : '{');
+	}
+
+	out.stack[out.depth].array = array;
+	out.stack[out.depth].first = true;
+	out.depth++;
+
+	return NULL;
+}
+
+static void output_close(void)
+{
+	if (!out.depth)
+		return;
+
+	if (out.depth-- == out.record_depth) {
+		out.record_depth = 0;
+		return;
+	}
+
+	putchar(out.stack[out.depth].array ? ']' : '}');
+	output_element_done();
+}
+
+void *uqmi_open_table(const char *name)
+{
+	if (!uqmi_stream)
+		return blobmsg_open_table(&status, name);
+
+	return output_open(name, false);
+}
+
+void uqmi_close_table(void *cookie)
+{
+	if (!uqmi_stream)
+		blobmsg_close_table(&status, cookie);
+	else
+		output_close();
+}
+
+void *uqmi_open_array(const char *name)
+{
+	if (!uqmi_stream)
+		return blobmsg_open_array(&status, name);
+
+	return output_open(name, true);
+}
+
+void uqmi_close_array(void *cookie)
+{
+	if (!uqmi_stream)
+		blobmsg_close_array(&status, cookie);
+	else
+		output_close();
+}
+
+void uqmi_add_string(const char *name, const char *val)
+{
+	if (!uqmi_stream) {
+		blobmsg_add_string(&status, name, val);
+		return;
+	}
+
+	output_element(name);
+	output_string(val);
+	output_element_done();
+}
+
+void uqmi_add_u32(const char *name, uint32_t val)
+{
+	if (!uqmi_stream) {
+		blobmsg_add_u32(&status, name, val);
+		return;
+	}
+
+	/* blobmsg prints them signed, several fields rely on that */
+	output_element(name);
+	printf("%d", (int32_t) val);
+	output_element_done();
+}
+
+void uqmi_add_u8(const char *name, uint8_t val)
+{
+	if (!uqmi_stream) {
+		blobmsg_add_u8(&status, name, val);
+		return;
+	}
+
+	output_element(name);
+	fputs(val ? "true" : "false", stdout);
+	output_element_done();
+}
+
+void uqmi_add_double(const char *name, double val)
+{
+	if (!uqmi_stream) {
+		blobmsg_add_double(&status, name, val);
+		return;
+	}
+
+	output_element(name);
+	printf("%lf", val);
+	output_element_done();
+}
+
+char *uqmi_alloc_string_buffer(const char *name, unsigned int maxlen)
+{
+	char *str;
+
+	if (!uqmi_stream)
+		return blobmsg_alloc_string_buffer(&status, name, maxlen);
+
+	if (maxlen + 1 > out.str_len) {
+		str = realloc(out.str, maxlen + 1);
+		if (!str)
+			return NULL;
+
+		out.str = str;
+		out.str_len = maxlen + 1;
+	}
+
+	free(out.str_name);
+	out.str_name = name ? strdup(name) : NULL;
+	out.str[0] = 0;
+
+	return out.str;
+}
+
+void uqmi_add_string_buffer(void)
+{
+	if (!uqmi_stream) {
+		blobmsg_add_string_buffer(&status);
+		return;
+	}
+
+	uqmi_add_string(out.str_name, out.str);
+	free(out.str_name);
+	out.str_name = NULL;
+}
+
+void uqmi_printf(const char *name, const char *format, ...)
+{
+	va_list ap;
+	char *str;
+	int len;
+
+	va_start(ap, format);
+	len = vsnprintf(NULL, 0, format, ap);
+	va_end(ap);
+
+	str = uqmi_alloc_string_buffer(name, len);
+	if (!str)
+		return;
+
+	va_start(ap, format);
+	vsnprintf(str, len + 1, format, ap);
+	va_end(ap);
+
+	uqmi_add_string_buffer();
+}
+
+void uqmi_output_start(int line)
+{
+	out.line = line;
+	out.records = 0;
+	out.depth = 0;
+	out.record_depth = 0;
+}
+
+int uqmi_output_end(void)
+{
+	int records;
+
+	/* a callback that bailed out early may have left containers open */
+	while (out.depth)
+		output_close();
+
+	records = out.records;
+
+	if (uqmi_stream)
+		fflush(stdout);
+
+	out.records = 0;
+	return records;
+}
@@ -0,0 +1,57 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+#ifndef __UQMI_OUTPUT_H
+#define __UQMI_OUTPUT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Output of the commands. By default it is collected in the status
+ * blob_buf and printed once the command is done. With --stream it is
+ * written out as JSON while the callback produces it instead, so that
+ * only the open containers are kept in memory: one line per command, or
+ * one line per element for a command that outputs an array.
+ */
+extern bool uqmi_stream;
+
+void *uqmi_open_table(const char *name);
+void uqmi_close_table(void *cookie);
+void *uqmi_open_array(const char *name);
+void uqmi_close_array(void *cookie);
+
+void uqmi_add_string(const char *name, const char *val);
+void uqmi_add_u32(const char *name, uint32_t val);
+void uqmi_add_u8(const char *name, uint8_t val);
+void uqmi_add_double(const char *name, double val);
+void uqmi_printf(const char *name, const char *format, ...)
+	__attribute__((format(printf, 2, 3)));
+
+char *uqmi_alloc_string_buffer(const char *name, unsigned int maxlen);
+void uqmi_add_string_buffer(void);
+
+/* lines are tagged with the batch line, if any */
+void uqmi_output_start(int line);
+/* returns the number of lines written since uqmi_output_start() */
+int uqmi_output_end(void);
+
+#endif
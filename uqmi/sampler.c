@@ -0,0 +1,554 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * uqmi --sample <file> sends the NAS get-signal-info, get-tx-rx-info and
+ * get-lte-cphy-ca-info requests together once per period and writes one
+ * row per period to <file>, until it is interrupted. The responses are
+ * decoded straight into the row, the JSON output of the actions is not
+ * involved.
+ *
+ * Signal values are in 0.1 dB(m) units, with the same sign as in the
+ * output of the actions. The tx/rx info is asked for the radio of the
+ * previous signal info, LTE at first. A period is skipped if the requests
+ * of the previous one are still waiting for their responses.
+ *
+ * Rows are CSV with a header line, or with --sample-format bin, a struct
+ * sample_header followed by struct sample_row in host byte order.
+ */
+
+#include <alloca.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libubox/uloop.h>
+#include <libubox/utils.h>
+
+#include "uqmi.h"
+#include "utils.h"
+#include "qmi-enum-names.h"
+
+#define SAMPLE_NONE		INT16_MIN
+#define SAMPLE_CHAINS		4
+/* the primary cell and up to 4 secondary ones */
+#define SAMPLE_CELLS		5
+
+#define SAMPLE_MAGIC		0x534d5155	/* "UQMS" */
+#define SAMPLE_VERSION		1
+
+struct sample_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t row_len;
+} __packed;
+
+struct sample_row {
+	uint64_t time;		/* ms since the epoch */
+	int8_t rat;		/* QmiNasRadioInterface of the signal info */
+	int8_t chain_rat;	/* and of the rx chains */
+	int16_t rssi;
+	int16_t ecio;
+	int16_t rsrq;
+	int16_t rsrp;
+	int16_t snr;
+	int16_t nr_rsrp;
+	int16_t nr_rsrq;
+	int16_t nr_snr;
+	struct {
+		int16_t rssi;
+		int16_t ecio;
+		int16_t rsrq;
+		int16_t rsrp;
+		int16_t rscp;
+	} chain[SAMPLE_CHAINS];
+	int16_t tx_power;
+	struct {
+		uint16_t pci;
+		uint16_t channel;	/* 0 if the cell is not there */
+		uint8_t bandwidth;	/* QmiNasDlBandwidth */
+		uint8_t state;		/* QmiNasScellState */
+	} cell[SAMPLE_CELLS];
+} __packed;
+
+enum {
+	SAMPLE_REQ_SIGNAL_INFO,
+	SAMPLE_REQ_TX_RX_INFO,
+	SAMPLE_REQ_CA_INFO,
+	__SAMPLE_REQ_MAX
+};
+
+static struct {
+	const struct uqmi_sample_config *cfg;
+	struct qmi_dev *qmi;
+
+	FILE *f;
+	unsigned int written;
+	unsigned int file_idx;
+
+	struct uloop_timeout timer;
+	struct qmi_request req[__SAMPLE_REQ_MAX];
+	int n_pending;
+
+	int8_t chain_rat;
+	struct sample_row row;
+} sample;
+
+static void sample_reset_row(struct sample_row *row)
+{
+	struct timespec ts;
+	int i;
+
+	memset(row, 0, sizeof(*row));
+	clock_gettime(CLOCK_REALTIME, &ts);
+	row->time = (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+	row->rat = QMI_NAS_RADIO_INTERFACE_NONE;
+	row->chain_rat = sample.chain_rat;
+
+	row->rssi = row->ecio = row->rsrq = row->rsrp = row->snr = SAMPLE_NONE;
+	row->nr_rsrp = row->nr_rsrq = row->nr_snr = SAMPLE_NONE;
+	for (i = 0; i < SAMPLE_CHAINS; i++) {
+		row->chain[i].rssi = row->chain[i].ecio = row->chain[i].rsrq = SAMPLE_NONE;
+		row->chain[i].rsrp = row->chain[i].rscp = SAMPLE_NONE;
+	}
+	row->tx_power = SAMPLE_NONE;
+}
+
+static int sample_write_header(void)
+{
+	struct sample_header hdr = {
+		.magic = SAMPLE_MAGIC,
+		.version = SAMPLE_VERSION,
+		.row_len = sizeof(struct sample_row),
+	};
+	int i, len;
+
+	if (sample.cfg->binary)
+		return fwrite(&hdr, sizeof(hdr), 1, sample.f) ? sizeof(hdr) : -1;
+
+	len = fprintf(sample.f, "time,rat,rssi,ecio,rsrq,rsrp,snr,nr_rsrp,nr_rsrq,nr_snr,chain_rat");
+	for (i = 0; i < SAMPLE_CHAINS; i++)
+		len += fprintf(sample.f, ",rx%d_rssi,rx%d_ecio,rx%d_rsrq,rx%d_rsrp,rx%d_rscp",
+			       i, i, i, i, i);
+	len += fprintf(sample.f, ",tx_power");
+	for (i = 0; i < SAMPLE_CELLS; i++)
+		len += fprintf(sample.f, ",cell%d_pci,cell%d_channel,cell%d_bandwidth,cell%d_state",
+			       i, i, i, i);
+	len += fprintf(sample.f, "\n");
+
+	return ferror(sample.f) ? -1 : len;
+}
+
+static int sample_open_file(void)
+{
+	const char *path = sample.cfg->path;
+	char *name = (char *) path;
+	int len;
+
+	if (sample.cfg->file_size) {
+		name = alloca(strlen(path) + 12);
+		sprintf(name, "%s.%u", path, sample.file_idx);
+	}
+
+	sample.f = fopen(name, "we");
+	if (!sample.f) {
+		fprintf(stderr, "Failed to open sample file %s: %s\n", name, strerror(errno));
+		return -1;
+	}
+
+	len = sample_write_header();
+	if (len < 0) {
+		fprintf(stderr, "Failed to write sample file %s\n", name);
+		fclose(sample.f);
+		sample.f = NULL;
+		return -1;
+	}
+
+	sample.written = len;
+	return 0;
+}
+
+static int sample_next_file(void)
+{
+	fclose(sample.f);
+
+	sample.file_idx++;
+	if (sample.cfg->n_files && sample.file_idx >= sample.cfg->n_files)
+		sample.file_idx = 0;
+
+	return sample_open_file();
+}
+
+static char *sample_csv_value(char *p, int16_t val)
+{
+	*p++ = ',';
+	if (val == SAMPLE_NONE)
+		return p;
+
+	return p + sprintf(p, "%s%d.%d", val < 0 ? "-" : "", abs(val) / 10, abs(val) % 10);
+}
+
+static const char *sample_rat_name(int8_t rat)
+{
+	const char *name = qmi_enum_name(&qmi_nas_radio_interface_names, rat);
+
+	return name ? name : "";
+}
+
+static int sample_format_csv(char *buf, const struct sample_row *row)
+{
+	char *p = buf;
+	int i;
+
+	p += sprintf(p, "%llu.%03u,%s", (unsigned long long) row->time / 1000,
+		     (unsigned int) (row->time % 1000), sample_rat_name(row->rat));
+	p = sample_csv_value(p, row->rssi);
+	p = sample_csv_value(p, row->ecio);
+	p = sample_csv_value(p, row->rsrq);
+	p = sample_csv_value(p, row->rsrp);
+	p = sample_csv_value(p, row->snr);
+	p = sample_csv_value(p, row->nr_rsrp);
+	p = sample_csv_value(p, row->nr_rsrq);
+	p = sample_csv_value(p, row->nr_snr);
+	p += sprintf(p, ",%s", sample_rat_name(row->chain_rat));
+
+	for (i = 0; i < SAMPLE_CHAINS; i++) {
+		p = sample_csv_value(p, row->chain[i].rssi);
+		p = sample_csv_value(p, row->chain[i].ecio);
+		p = sample_csv_value(p, row->chain[i].rsrq);
+		p = sample_csv_value(p, row->chain[i].rsrp);
+		p = sample_csv_value(p, row->chain[i].rscp);
+	}
+
+	p = sample_csv_value(p, row->tx_power);
+
+	for (i = 0; i < SAMPLE_CELLS; i++) {
+		if (!row->cell[i].channel) {
+			p += sprintf(p, ",,,,");
+			continue;
+		}
+
+		p += sprintf(p, ",%u,%u,%u,%u", row->cell[i].pci, row->cell[i].channel,
+			     row->cell[i].bandwidth, row->cell[i].state);
+	}
+
+	*p++ = '\n';
+	return p - buf;
+}
+
+static void sample_write(const struct sample_row *row)
+{
+	/* a row of all values at their longest is about 600 bytes */
+	char buf[1024];
+	const void *data = row;
+	int len = sizeof(*row);
+
+	if (!sample.f)
+		return;
+
+	if (!sample.cfg->binary) {
+		len = sample_format_csv(buf, row);
+		data = buf;
+	}
+
+	if (sample.cfg->file_size && sample.written + len > sample.cfg->file_size &&
+	    sample_next_file()) {
+		uloop_end();
+		return;
+	}
+
+	if (fwrite(data, len, 1, sample.f) != 1 || fflush(sample.f)) {
+		fprintf(stderr, "Sample write failed: %s\n", strerror(errno));
+		return;
+	}
+
+	sample.written += len;
+}
+
+static void sample_request_done(void)
+{
+	if (--sample.n_pending)
+		return;
+
+	sample_write(&sample.row);
+}
+
+static void sample_signal_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	struct qmi_nas_get_signal_info_response res;
+	struct sample_row *row = &sample.row;
+
+	if (!msg)
+		goto out;
+
+	qmi_parse_nas_get_signal_info_response(msg, &res);
+
+	/* same precedence as the type printed by --get-signal-info */
+	if (res.set.cdma_signal_strength) {
+		row->rat = QMI_NAS_RADIO_INTERFACE_CDMA_1X;
+		row->rssi = res.data.cdma_signal_strength.rssi * 10;
+		row->ecio = res.data.cdma_signal_strength.ecio * 10;
+	}
+
+	if (res.set.hdr_signal_strength) {
+		row->rat = QMI_NAS_RADIO_INTERFACE_CDMA_1XEVDO;
+		row->rssi = res.data.hdr_signal_strength.rssi * 10;
+		row->ecio = res.data.hdr_signal_strength.ecio * 10;
+	}
+
+	if (res.set.gsm_signal_strength) {
+		row->rat = QMI_NAS_RADIO_INTERFACE_GSM;
+		row->rssi = res.data.gsm_signal_strength * 10;
+	}
+
+	if (res.set.wcdma_signal_strength) {
+		row->rat = QMI_NAS_RADIO_INTERFACE_UMTS;
+		row->rssi = res.data.wcdma_signal_strength.rssi * 10;
+		row->ecio = res.data.wcdma_signal_strength.ecio * 10;
+	}
+
+	if (res.set.lte_signal_strength) {
+		row->rat = QMI_NAS_RADIO_INTERFACE_LTE;
+		row->rssi = res.data.lte_signal_strength.rssi * 10;
+		row->rsrq = res.data.lte_signal_strength.rsrq * 10;
+		row->rsrp = res.data.lte_signal_strength.rsrp * 10;
+		row->snr = res.data.lte_signal_strength.snr;
+	}
+
+	if (res.set.tdma_signal_strength) {
+		row->rat = QMI_NAS_RADIO_INTERFACE_TD_SCDMA;
+		row->rssi = res.data.tdma_signal_strength * 10;
+	}
+
+	/* -32768 is "not connected" for these, which is SAMPLE_NONE already */
+	if (res.set._5g_signal_strength) {
+		row->nr_rsrp = res.data._5g_signal_strength.rsrp;
+		if (row->nr_rsrp != SAMPLE_NONE)
+			row->nr_rsrp *= 10;
+		row->nr_snr = res.data._5g_signal_strength.snr;
+	}
+
+	if (res.set._5g_signal_strength_extended) {
+		row->nr_rsrq = res.data._5g_signal_strength_extended;
+		if (row->nr_rsrq != SAMPLE_NONE)
+			row->nr_rsrq *= 10;
+	}
+
+	if (row->rat == QMI_NAS_RADIO_INTERFACE_NONE &&
+	    (row->nr_rsrp != SAMPLE_NONE || row->nr_snr != SAMPLE_NONE))
+		row->rat = QMI_NAS_RADIO_INTERFACE_5GNR;
+
+	switch (row->rat) {
+	case QMI_NAS_RADIO_INTERFACE_GSM:
+	case QMI_NAS_RADIO_INTERFACE_UMTS:
+	case QMI_NAS_RADIO_INTERFACE_LTE:
+	case QMI_NAS_RADIO_INTERFACE_5GNR:
+		sample.chain_rat = row->rat;
+		break;
+	default:
+		break;
+	}
+
+out:
+	sample_request_done();
+}
+
+static void sample_chain(int i, bool tuned, int32_t rx_power, int32_t ecio,
+			 int32_t rsrp, int32_t rscp)
+{
+	struct sample_row *row = &sample.row;
+
+	if (!tuned)
+		return;
+
+	/* same fields as print_chain_info() */
+	row->chain[i].rssi = rx_power;
+	switch (row->chain_rat) {
+	case QMI_NAS_RADIO_INTERFACE_5GNR:
+		row->chain[i].rsrp = -rsrp;
+		break;
+	case QMI_NAS_RADIO_INTERFACE_LTE:
+		row->chain[i].rsrq = -ecio;
+		row->chain[i].rsrp = -rsrp;
+		break;
+	case QMI_NAS_RADIO_INTERFACE_UMTS:
+		row->chain[i].ecio = -ecio;
+		row->chain[i].rscp = -rscp;
+		break;
+	default:
+		break;
+	}
+}
+
+#define sample_chain_info(_i, _info) \
+	sample_chain(_i, _info.is_radio_tuned, _info.rx_power, _info.ecio, \
+		     _info.rsrp, _info.rscp)
+
+static void sample_tx_rx_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	struct qmi_nas_get_tx_rx_info_response res;
+
+	if (!msg)
+		goto out;
+
+	qmi_parse_nas_get_tx_rx_info_response(msg, &res);
+	if (res.set.rx_chain_0_info)
+		sample_chain_info(0, res.data.rx_chain_0_info);
+	if (res.set.rx_chain_1_info)
+		sample_chain_info(1, res.data.rx_chain_1_info);
+	if (res.set.rx_chain_2_info)
+		sample_chain_info(2, res.data.rx_chain_2_info);
+	if (res.set.rx_chain_3_info)
+		sample_chain_info(3, res.data.rx_chain_3_info);
+
+	if (res.set.tx_info && res.data.tx_info.is_in_traffic)
+		sample.row.tx_power = res.data.tx_info.tx_power;
+
+out:
+	sample_request_done();
+}
+
+static void sample_cell(int i, uint16_t pci, uint16_t channel, uint32_t bandwidth, uint32_t state)
+{
+	sample.row.cell[i].pci = pci;
+	sample.row.cell[i].channel = channel;
+	sample.row.cell[i].bandwidth = bandwidth;
+	sample.row.cell[i].state = state;
+}
+
+static void sample_ca_info_cb(struct qmi_dev *qmi, struct qmi_request *req, struct qmi_msg *msg)
+{
+	struct qmi_nas_get_lte_cphy_ca_info_response res;
+	int i;
+
+	if (!msg)
+		goto out;
+
+	qmi_parse_nas_get_lte_cphy_ca_info_response(msg, &res);
+	if (res.set.phy_ca_agg_pcell_info)
+		sample_cell(0, res.data.phy_ca_agg_pcell_info.physical_cell_id,
+			    res.data.phy_ca_agg_pcell_info.rx_channel,
+			    res.data.phy_ca_agg_pcell_info.dl_bandwidth, 0);
+
+	for (i = 0; i < res.data.phy_ca_agg_secondary_cells_n && i < SAMPLE_CELLS - 1; i++)
+		sample_cell(i + 1, res.data.phy_ca_agg_secondary_cells[i].physical_cell_id,
+			    res.data.phy_ca_agg_secondary_cells[i].rx_channel,
+			    res.data.phy_ca_agg_secondary_cells[i].dl_bandwidth,
+			    res.data.phy_ca_agg_secondary_cells[i].state);
+
+	if (!i && res.set.phy_ca_agg_scell_info)
+		sample_cell(1, res.data.phy_ca_agg_scell_info.physical_cell_id,
+			    res.data.phy_ca_agg_scell_info.rx_channel,
+			    res.data.phy_ca_agg_scell_info.dl_bandwidth,
+			    res.data.phy_ca_agg_scell_info.state);
+
+out:
+	sample_request_done();
+}
+
+static int sample_set_tx_rx_info(struct qmi_msg *msg)
+{
+	struct qmi_nas_get_tx_rx_info_request req = {
+		QMI_INIT(radio_interface, sample.chain_rat),
+	};
+
+	return qmi_set_nas_get_tx_rx_info_request(msg, &req);
+}
+
+static int sample_set_signal_info(struct qmi_msg *msg)
+{
+	return qmi_set_nas_get_signal_info_request(msg);
+}
+
+static int sample_set_ca_info(struct qmi_msg *msg)
+{
+	return qmi_set_nas_get_lte_cphy_ca_info_request(msg);
+}
+
+static const struct {
+	int (*set_request)(struct qmi_msg *msg);
+	request_cb cb;
+} sample_requests[__SAMPLE_REQ_MAX] = {
+	[SAMPLE_REQ_SIGNAL_INFO] = { sample_set_signal_info, sample_signal_info_cb },
+	[SAMPLE_REQ_TX_RX_INFO] = { sample_set_tx_rx_info, sample_tx_rx_info_cb },
+	[SAMPLE_REQ_CA_INFO] = { sample_set_ca_info, sample_ca_info_cb },
+};
+
+static void sample_timer_cb(struct uloop_timeout *t)
+{
+	struct qmi_dev *qmi = sample.qmi;
+	unsigned int timeout = qmi->timeout;
+	int i;
+
+	uloop_timeout_set(t, sample.cfg->interval);
+	if (sample.n_pending)
+		return;
+
+	sample_reset_row(&sample.row);
+
+	/* without -t, a lost response must not stop the sampling for good */
+	if (!timeout)
+		qmi->timeout = sample.cfg->interval;
+
+	/* the responses only come in from the uloop, after all are sent */
+	for (i = 0; i < __SAMPLE_REQ_MAX; i++) {
+		sample_requests[i].set_request(qmi->buf);
+		if (!qmi_request_start(qmi, &sample.req[i], sample_requests[i].cb))
+			sample.n_pending++;
+	}
+
+	qmi->timeout = timeout;
+}
+
+int uqmi_sample_run(struct qmi_dev *qmi, const struct uqmi_sample_config *cfg)
+{
+	int i;
+
+	if (qmi_service_connect(qmi, QMI_SERVICE_NAS, -1)) {
+		fprintf(stderr, "Failed to connect to service nas\n");
+		return -1;
+	}
+
+	memset(&sample, 0, sizeof(sample));
+	sample.cfg = cfg;
+	sample.qmi = qmi;
+	sample.chain_rat = QMI_NAS_RADIO_INTERFACE_LTE;
+	sample.timer.cb = sample_timer_cb;
+
+	if (sample_open_file())
+		return -1;
+
+	sample_timer_cb(&sample.timer);
+	if (!cancel_all_requests)
+		uloop_run();
+
+	uloop_timeout_cancel(&sample.timer);
+	for (i = 0; i < __SAMPLE_REQ_MAX; i++)
+		if (sample.req[i].pending)
+			qmi_request_cancel(qmi, &sample.req[i]);
+
+	if (sample.f)
+		fclose(sample.f);
+
+	return 0;
+}
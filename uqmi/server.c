@@ -0,0 +1,381 @@
+/*
+ * uqmi -- tiny QMI support implementation
+ *
+ * Copyright (C) 2014-2015 Felix Fietkau <nbd@openwrt.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * uqmi --server keeps the device and its client IDs open and runs the
+ * arguments of uqmi --socket invocations, one client at a time.
+ *
+ * The client sends the length of its arguments together with its stdout
+ * and stderr (SCM_RIGHTS), followed by the arguments, each terminated by
+ * a NUL. The server runs them with the client's stdout and stderr in
+ * place, so the output is exactly that of a plain uqmi call, and replies
+ * with the exit status as an int.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include <libubox/list.h>
+#include <libubox/usock.h>
+
+#include "uqmi.h"
+#include "utils.h"
+
+#define UQMI_SERVER_MAX_ARGS	(64 * 1024)
+#define UQMI_SERVER_MAX_CLIENTS	16
+/* time a client gets to send its request */
+#define UQMI_SERVER_TIMEOUT	5000
+
+/*
+ * Requests are read without blocking, every client has its own fd in the
+ * uloop and a deadline. Complete requests are run one after another in
+ * the order they came in.
+ */
+struct server_client {
+	struct list_head list;
+	struct uloop_fd fd;
+	struct uloop_timeout timeout;
+	int fds[2];
+	uint32_t len;
+	unsigned int ofs;
+	char *data;
+	bool ready;
+};
+
+static struct uloop_fd server_fd;
+static uqmi_server_cb server_cb;
+static const char *server_path;
+static LIST_HEAD(server_clients);
+static int n_clients;
+static bool server_busy;
+
+static void server_client_free(struct server_client *cl)
+{
+	int i;
+
+	list_del(&cl->list);
+	n_clients--;
+
+	uloop_timeout_cancel(&cl->timeout);
+	if (cl->fd.registered)
+		uloop_fd_delete(&cl->fd);
+	close(cl->fd.fd);
+
+	for (i = 0; i < 2; i++)
+		if (cl->fds[i] >= 0)
+			close(cl->fds[i]);
+
+	free(cl->data);
+	free(cl);
+}
+
+/* the header comes with the client's stdout and stderr */
+static int server_recv_header(struct server_client *cl)
+{
+	char cbuf[CMSG_SPACE(2 * sizeof(int))];
+	struct cmsghdr *cmsg;
+	struct msghdr msg = {};
+	struct iovec iov;
+	ssize_t len;
+
+	iov.iov_base = (char *) &cl->len + cl->ofs;
+	iov.iov_len = sizeof(cl->len) - cl->ofs;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	len = recvmsg(cl->fd.fd, &msg, MSG_DONTWAIT);
+	if (len <= 0)
+		return len;
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (cmsg && cmsg->cmsg_type == SCM_RIGHTS) {
+		int fds[2], i, n;
+
+		/* cbuf has no room for more than two */
+		n = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		memcpy(fds, CMSG_DATA(cmsg), n * sizeof(int));
+		if (n != 2 || cl->fds[0] >= 0) {
+			for (i = 0; i < n; i++)
+				close(fds[i]);
+			return 0;
+		}
+
+		memcpy(cl->fds, fds, sizeof(fds));
+	}
+
+	return len;
+}
+
+/* returns 1 when the request is complete, 0 to wait for more, -1 on error */
+static int server_client_read(struct server_client *cl)
+{
+	ssize_t len;
+
+	while (cl->ofs < sizeof(cl->len)) {
+		len = server_recv_header(cl);
+		if (len < 0 && errno == EAGAIN)
+			return 0;
+		if (len < 0 && errno == EINTR)
+			continue;
+		if (len <= 0)
+			return -1;
+
+		cl->ofs += len;
+	}
+
+	if (cl->fds[0] < 0 || !cl->len || cl->len > UQMI_SERVER_MAX_ARGS)
+		return -1;
+
+	if (!cl->data) {
+		cl->data = malloc(cl->len + 1);
+		if (!cl->data)
+			return -1;
+	}
+
+	while (cl->ofs < sizeof(cl->len) + cl->len) {
+		len = recv(cl->fd.fd, cl->data + cl->ofs - sizeof(cl->len),
+			   sizeof(cl->len) + cl->len - cl->ofs, MSG_DONTWAIT);
+		if (len < 0 && errno == EAGAIN)
+			return 0;
+		if (len < 0 && errno == EINTR)
+			continue;
+		if (len <= 0)
+			return -1;
+
+		cl->ofs += len;
+	}
+
+	cl->data[cl->len] = 0;
+	return 1;
+}
+
+static int server_run(int *fds, char *data, int len)
+{
+	char **argv;
+	int saved[2];
+	int argc = 1;
+	int ret, i;
+	char *p;
+
+	for (i = 0; i < len; i++)
+		argc += !data[i];
+
+	argv = calloc(argc + 1, sizeof(*argv));
+	if (!argv)
+		return -1;
+
+	argv[0] = "uqmi";
+	for (p = data, i = 1; i < argc; p += strlen(p) + 1)
+		argv[i++] = p;
+
+	fflush(stdout);
+	fflush(stderr);
+	for (i = 0; i < 2; i++) {
+		saved[i] = dup(i + 1);
+		dup2(fds[i], i + 1);
+	}
+
+	ret = server_cb(argc, argv);
+
+	fflush(stdout);
+	fflush(stderr);
+	for (i = 0; i < 2; i++) {
+		dup2(saved[i], i + 1);
+		close(saved[i]);
+	}
+
+	free(argv);
+	return ret;
+}
+
+static void server_run_clients(void)
+{
+	struct server_client *cl;
+	int32_t ret;
+
+	/* the actions run uloop until they are done, requests completing meanwhile wait */
+	if (server_busy)
+		return;
+
+	server_busy = true;
+	while (1) {
+		list_for_each_entry(cl, &server_clients, list)
+			if (cl->ready)
+				break;
+
+		if (&cl->list == &server_clients)
+			break;
+
+		ret = server_run(cl->fds, cl->data, cl->len);
+		send(cl->fd.fd, &ret, sizeof(ret), MSG_NOSIGNAL | MSG_DONTWAIT);
+		server_client_free(cl);
+	}
+	server_busy = false;
+}
+
+static void server_client_timeout_cb(struct uloop_timeout *t)
+{
+	struct server_client *cl = container_of(t, struct server_client, timeout);
+
+	server_client_free(cl);
+}
+
+static void server_client_cb(struct uloop_fd *u, unsigned int events)
+{
+	struct server_client *cl = container_of(u, struct server_client, fd);
+	int ret;
+
+	ret = server_client_read(cl);
+	if (!ret)
+		return;
+
+	if (ret < 0) {
+		server_client_free(cl);
+		return;
+	}
+
+	uloop_fd_delete(&cl->fd);
+	uloop_timeout_cancel(&cl->timeout);
+	cl->ready = true;
+	server_run_clients();
+}
+
+static void server_accept_cb(struct uloop_fd *u, unsigned int events)
+{
+	struct server_client *cl;
+	int fd;
+
+	while ((fd = accept(u->fd, NULL, NULL)) >= 0) {
+		if (n_clients >= UQMI_SERVER_MAX_CLIENTS ||
+		    !(cl = calloc(1, sizeof(*cl)))) {
+			close(fd);
+			continue;
+		}
+
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		system_fd_set_cloexec(fd);
+		cl->fd.fd = fd;
+		cl->fd.cb = server_client_cb;
+		cl->fds[0] = cl->fds[1] = -1;
+		cl->timeout.cb = server_client_timeout_cb;
+		list_add_tail(&cl->list, &server_clients);
+		n_clients++;
+
+		uloop_fd_add(&cl->fd, ULOOP_READ);
+		uloop_timeout_set(&cl->timeout, UQMI_SERVER_TIMEOUT);
+	}
+}
+
+int uqmi_server_init(const char *path, uqmi_server_cb cb)
+{
+	unlink(path);
+	server_fd.fd = usock(USOCK_UNIX | USOCK_SERVER | USOCK_NONBLOCK, path, NULL);
+	if (server_fd.fd < 0) {
+		fprintf(stderr, "Failed to create socket %s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	server_path = path;
+	server_cb = cb;
+	server_fd.cb = server_accept_cb;
+	uloop_fd_add(&server_fd, ULOOP_READ);
+
+	return 0;
+}
+
+void uqmi_server_done(void)
+{
+	struct server_client *cl, *tmp;
+
+	if (!server_path)
+		return;
+
+	list_for_each_entry_safe(cl, tmp, &server_clients, list)
+		server_client_free(cl);
+
+	uloop_fd_delete(&server_fd);
+	close(server_fd.fd);
+	unlink(server_path);
+	server_path = NULL;
+}
+
+int uqmi_client_run(const char *path, int argc, char **argv)
+{
+	char cbuf[CMSG_SPACE(2 * sizeof(int))] = {};
+	int fds[2] = { STDOUT_FILENO, STDERR_FILENO };
+	struct cmsghdr *cmsg;
+	struct msghdr msg = {};
+	struct iovec iov[2];
+	uint32_t len = 0;
+	int32_t ret = 2;
+	int fd, i;
+	char *data, *p;
+
+	for (i = 1; i < argc; i++)
+		len += strlen(argv[i]) + 1;
+
+	data = p = malloc(len);
+	if (!data)
+		return 2;
+
+	for (i = 1; i < argc; i++)
+		p = stpcpy(p, argv[i]) + 1;
+
+	fd = usock(USOCK_UNIX, path, NULL);
+	if (fd < 0) {
+		fprintf(stderr, "Failed to connect to %s: %s\n", path, strerror(errno));
+		goto out;
+	}
+
+	iov[0].iov_base = &len;
+	iov[0].iov_len = sizeof(len);
+	iov[1].iov_base = data;
+	iov[1].iov_len = len;
+	msg.msg_iov = iov;
+	msg.msg_iovlen = 2;
+	msg.msg_control = cbuf;
+	msg.msg_controllen = sizeof(cbuf);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+	fflush(stdout);
+	if (sendmsg(fd, &msg, MSG_NOSIGNAL) != sizeof(len) + len ||
+	    recv(fd, &ret, sizeof(ret), MSG_WAITALL) != sizeof(ret)) {
+		fprintf(stderr, "Lost connection to %s\n", path);
+		ret = 2;
+	}
+
+	close(fd);
+out:
+	free(data);
+	return ret;
+}
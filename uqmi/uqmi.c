@@ -23,20 +23,34 @@
 #include <libubox/utils.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <getopt.h>
+#include <glob.h>
 #include <signal.h>
 
 #include "uqmi.h"
 #include "commands.h"
+#include "capture.h"
+#include "output.h"
 
-static const char *device;
+static const char **devices;
+static int n_devices;
+static const char *capture;
+static const char *server;
+static const char *batch;
+static bool monitor;
+static struct uqmi_sample_config sample = {
+	.interval = 5000,
+};
+static bool in_batch, in_server;
+static unsigned int capture_size, capture_files;
 
 #define CMD_OPT(_arg) (-2 - _arg)
 
-#define __uqmi_command(_name, _optname, _arg, _option) { #_optname, _arg##_argument, NULL, CMD_OPT(__UQMI_COMMAND_##_name) }
+#define __uqmi_command(_name, _optname, _arg, _option, _in, _out) { #_optname, _arg##_argument, NULL, CMD_OPT(__UQMI_COMMAND_##_name) }
 static const struct option uqmi_getopt[] = {
 	__uqmi_commands,
 	{ "single", no_argument, NULL, 's' },
@@ -45,6 +59,18 @@ static const struct option uqmi_getopt[] = {
 	{ "release-client-id", required_argument, NULL, 'r' },
 	{ "mbim",  no_argument, NULL, 'm' },
 	{ "timeout", required_argument, NULL, 't' },
+	{ "capture", required_argument, NULL, 'C' },
+	{ "capture-ring", required_argument, NULL, 'R' },
+	{ "server", required_argument, NULL, 'S' },
+	{ "socket", required_argument, NULL, 'U' },
+	{ "batch", required_argument, NULL, 'B' },
+	{ "stream", no_argument, NULL, 'O' },
+	{ "monitor", no_argument, NULL, 'W' },
+	{ "cid-cache", required_argument, NULL, 'I' },
+	{ "sample", required_argument, NULL, 'P' },
+	{ "sample-interval", required_argument, NULL, 'V' },
+	{ "sample-format", required_argument, NULL, 'F' },
+	{ "sample-ring", required_argument, NULL, 'G' },
 	{ NULL, 0, NULL, 0 }
 };
 #undef __uqmi_command
@@ -54,11 +80,32 @@ static int usage(const char *progname)
 	fprintf(stderr, "Usage: %s <options|actions>\n"
 		"Options:\n"
 		"  --single, -s:                     Print output as a single line (for scripts)\n"
-		"  --device=NAME, -d NAME:           Set device name to NAME (required)\n"
+		"  --stream:                         Print output while it is decoded, one line\n"
+		"                                    per action or element of a list\n"
+		"  --device=NAME, -d NAME:           Set device name to NAME (required), may be\n"
+		"                                    a pattern or given several times to run the\n"
+		"                                    actions on all devices, tagging the results\n"
 		"  --keep-client-id <name>:          Keep Client ID for service <name>\n"
 		"  --release-client-id <name>:       Release Client ID after exiting\n"
+		"  --cid-cache <dir>:                Keep the Client IDs of each device in <dir>\n"
+		"                                    for the next call, instead of releasing them\n"
 		"  --mbim, -m                        NAME is an MBIM device with EXT_QMUX support\n"
-		"  --timeout, -t                     response timeout in msecs\n"
+		"  --timeout, -t                     timeout of each request in msecs\n"
+		"  --capture <file>:                 Write all QMI messages to <file> (pcapng)\n"
+		"  --capture-ring <kbytes>,<files>:  Split the capture into <file>.N of <kbytes>,\n"
+		"                                    keeping the last <files> of them\n"
+		"  --server <path>:                  Keep the device and client IDs open and run\n"
+		"                                    the actions sent to the UNIX socket <path>\n"
+		"  --socket <path>:                  Run the actions on a uqmi --server at <path>\n"
+		"  --batch <file>:                   Run the actions of each line of <file> (- for\n"
+		"                                    stdin), print the results as JSON lines\n"
+		"  --monitor:                        Print the NAS, WDS, DMS and UIM indications\n"
+		"                                    as JSON lines until interrupted\n"
+		"  --sample <file>:                  Write the signal, tx/rx and LTE CA info as a\n"
+		"                                    row to <file> every period until interrupted\n"
+		"  --sample-interval <msecs>:        Period of --sample (default: 5000)\n"
+		"  --sample-format <csv|bin>:        Format of the --sample rows (default: csv)\n"
+		"  --sample-ring <kbytes>,<files>:   Split the samples like --capture-ring\n"
 		"\n"
 		"Services:                           dms, nas, pds, wds, wms\n"
 		"\n"
@@ -79,48 +126,44 @@ static int usage(const char *progname)
 	return 1;
 }
 
-static void keep_client_id(struct qmi_dev *qmi, const char *optarg)
+static int keep_client_id(struct qmi_dev *qmi, const char *optarg)
 {
 	QmiService svc = qmi_service_get_by_name(optarg);
 	if (svc < 0) {
 		fprintf(stderr, "Invalid service %s\n", optarg);
-		exit(1);
+		return -1;
 	}
 	qmi_service_get_client_id(qmi, svc);
+	return 0;
 }
 
-static void release_client_id(struct qmi_dev *qmi, const char *optarg)
+static int release_client_id(struct qmi_dev *qmi, const char *optarg)
 {
 	QmiService svc = qmi_service_get_by_name(optarg);
 	if (svc < 0) {
 		fprintf(stderr, "Invalid service %s\n", optarg);
-		exit(1);
+		return -1;
 	}
 	qmi_service_release_client_id(qmi, svc);
+	return 0;
 }
 
+static bool exit_signal;
+
 static void handle_exit_signal(int signal)
 {
+	if (signal)
+		exit_signal = true;
+
 	cancel_all_requests = true;
 	uloop_end();
 }
 
-static void _request_timeout_handler(struct uloop_timeout *timeout)
-{
-	fprintf(stderr, "Request timed out\n");
-	handle_exit_signal(0);
-}
-
-struct uloop_timeout request_timeout = { .cb = _request_timeout_handler, };
+static struct qmi_dev dev;
 
-int main(int argc, char **argv)
+static int parse_args(int argc, char **argv)
 {
-	static struct qmi_dev dev;
-	int ch, ret;
-
-	uloop_init();
-	signal(SIGINT, handle_exit_signal);
-	signal(SIGTERM, handle_exit_signal);
+	int ch;
 
 	while ((ch = getopt_long(argc, argv, "d:k:smt:", uqmi_getopt, NULL)) != -1) {
 		int cmd_opt = CMD_OPT(ch);
@@ -130,15 +173,28 @@ int main(int argc, char **argv)
 			continue;
 		}
 
+		/*
+		 * a batch line or a server client only has actions, the rest
+		 * is set up once for the open device
+		 */
+		if ((in_batch || in_server) && ch > 0 && strchr("dmtCRSUBOWIPVFG", ch)) {
+			if (in_server)
+				fprintf(stderr, "Option -%c can only be given to the server\n", ch);
+			return 1;
+		}
+
 		switch(ch) {
 		case 'r':
-			release_client_id(&dev, optarg);
+			if (release_client_id(&dev, optarg))
+				return 1;
 			break;
 		case 'k':
-			keep_client_id(&dev, optarg);
+			if (keep_client_id(&dev, optarg))
+				return 1;
 			break;
 		case 'd':
-			device = optarg;
+			devices = realloc(devices, (n_devices + 1) * sizeof(*devices));
+			devices[n_devices++] = optarg;
 			break;
 		case 's':
 			single_line = true;
@@ -147,26 +203,240 @@ int main(int argc, char **argv)
 			dev.is_mbim = true;
 			break;
 		case 't':
-			uloop_timeout_set(&request_timeout, atol(optarg));
+			dev.timeout = atol(optarg);
+			break;
+		case 'C':
+			capture = optarg;
+			break;
+		case 'R':
+			if (sscanf(optarg, "%u,%u", &capture_size, &capture_files) < 1 ||
+			    !capture_size) {
+				fprintf(stderr, "Invalid capture ring %s\n", optarg);
+				return usage(argv[0]);
+			}
+			capture_size *= 1024;
+			break;
+		case 'S':
+			server = optarg;
+			break;
+		case 'U':
+			/* handled in main() */
+			break;
+		case 'B':
+			batch = optarg;
+			break;
+		case 'O':
+			uqmi_stream = true;
+			break;
+		case 'W':
+			monitor = true;
+			break;
+		case 'I':
+			dev.cid_cache = optarg;
+			break;
+		case 'P':
+			sample.path = optarg;
+			break;
+		case 'V':
+			if (atoi(optarg) <= 0) {
+				fprintf(stderr, "Invalid sample interval %s\n", optarg);
+				return usage(argv[0]);
+			}
+			sample.interval = atoi(optarg);
+			break;
+		case 'F':
+			if (!strcmp(optarg, "bin")) {
+				sample.binary = true;
+			} else if (!strcmp(optarg, "csv")) {
+				sample.binary = false;
+			} else {
+				fprintf(stderr, "Invalid sample format %s\n", optarg);
+				return usage(argv[0]);
+			}
+			break;
+		case 'G':
+			if (sscanf(optarg, "%u,%u", &sample.file_size, &sample.n_files) < 1 ||
+			    !sample.file_size) {
+				fprintf(stderr, "Invalid sample ring %s\n", optarg);
+				return usage(argv[0]);
+			}
+			sample.file_size *= 1024;
 			break;
 		default:
-			return usage(argv[0]);
+			return in_batch || in_server ? 1 : usage(argv[0]);
 		}
 	}
 
-	if (!device) {
-		fprintf(stderr, "No device given\n");
-		return usage(argv[0]);
-	}
+	return 0;
+}
 
-	if (qmi_device_open(&dev, device)) {
+/* run the arguments of a uqmi --socket call */
+static int server_run(int argc, char **argv)
+{
+	int ret;
+
+	uqmi_reset_commands();
+	single_line = false;
+	uqmi_stream = false;
+	optind = 0;
+
+	in_server = true;
+	ret = parse_args(argc, argv);
+	in_server = false;
+	if (!ret)
+		ret = uqmi_run_commands(&dev) ? 0 : -1;
+
+	uqmi_reset_commands();
+	if (exit_signal)
+		uloop_end();
+	else
+		cancel_all_requests = false;
+
+	return ret;
+}
+
+/* run the actions on a single device, then go on with the batch, monitor or server */
+static int run_device(const char *path)
+{
+	int ret;
+
+	if (qmi_device_open(&dev, path)) {
 		fprintf(stderr, "Failed to open device\n");
 		return 2;
 	}
 
+	if (server || batch)
+		uqmi_save_commands();
+
 	ret = uqmi_run_commands(&dev) ? 0 : -1;
 
+	if (batch && !ret && !exit_signal) {
+		in_batch = true;
+		ret = uqmi_batch_run(&dev, batch, uqmi_getopt, parse_args);
+		in_batch = false;
+	}
+
+	if (monitor && !ret && !exit_signal)
+		ret = uqmi_monitor_run(&dev);
+
+	if (sample.path && !ret && !exit_signal)
+		ret = uqmi_sample_run(&dev, &sample);
+
+	if (server && !exit_signal) {
+		/* a client going away must not take the server with it */
+		signal(SIGPIPE, SIG_IGN);
+		cancel_all_requests = false;
+		ret = uqmi_server_init(server, server_run);
+		if (!ret) {
+			uloop_run();
+			uqmi_server_done();
+		}
+		cancel_all_requests = false;
+	}
+
 	qmi_device_close(&dev);
 
 	return ret;
 }
+
+/* run the actions on all devices at once, each with the options given for dev */
+static int run_devices(char **paths, int n)
+{
+	struct qmi_dev *devs = calloc(n, sizeof(*devs));
+	struct qmi_dev **open_devs = calloc(n, sizeof(*open_devs));
+	int n_open = 0;
+	int i, ret = 0;
+
+	if (!devs || !open_devs) {
+		ret = 2;
+		goto out;
+	}
+
+	for (i = 0; i < n; i++) {
+		devs[i] = dev;
+		if (qmi_device_open(&devs[i], paths[i])) {
+			fprintf(stderr, "Failed to open device %s\n", paths[i]);
+			ret = 2;
+			continue;
+		}
+
+		open_devs[n_open++] = &devs[i];
+	}
+
+	if (n_open && !uqmi_run_devices(open_devs, n_open) && !ret)
+		ret = -1;
+
+	for (i = 0; i < n_open; i++)
+		qmi_device_close(open_devs[i]);
+
+out:
+	free(open_devs);
+	free(devs);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	glob_t paths;
+	int i, ret;
+
+	uloop_init();
+	signal(SIGINT, handle_exit_signal);
+	signal(SIGTERM, handle_exit_signal);
+
+	for (i = 1; i < argc; i++) {
+		const char *path;
+		int n = 2;
+
+		if (!strncmp(argv[i], "--socket=", 9)) {
+			path = argv[i] + 9;
+			n = 1;
+		} else if (!strcmp(argv[i], "--socket") && i < argc - 1) {
+			path = argv[i + 1];
+		} else {
+			continue;
+		}
+
+		memmove(&argv[i], &argv[i + n], (argc - i - n + 1) * sizeof(*argv));
+		return uqmi_client_run(path, argc - n, argv);
+	}
+
+	ret = parse_args(argc, argv);
+	if (ret)
+		return ret;
+
+	if (!n_devices) {
+		fprintf(stderr, "No device given\n");
+		return usage(argv[0]);
+	}
+
+	/* patterns without a match are kept as they are */
+	for (i = 0; i < n_devices; i++) {
+		if (glob(devices[i], GLOB_NOCHECK | (i ? GLOB_APPEND : 0), NULL, &paths)) {
+			fprintf(stderr, "Failed to expand device %s\n", devices[i]);
+			return 2;
+		}
+	}
+
+	if (paths.gl_pathc > 1 && (server || batch || monitor || sample.path || uqmi_stream)) {
+		fprintf(stderr, "--server, --batch, --monitor, --sample and --stream need a single device\n");
+		ret = 1;
+		goto out;
+	}
+
+	if (capture && qmi_capture_open(capture, capture_size, capture_files)) {
+		ret = 2;
+		goto out;
+	}
+
+	if (paths.gl_pathc > 1)
+		ret = run_devices(paths.gl_pathv, paths.gl_pathc);
+	else
+		ret = run_device(paths.gl_pathv[0]);
+
+	qmi_capture_close();
+
+out:
+	globfree(&paths);
+	return ret;
+}
@@ -28,6 +28,8 @@
 #include <libubox/ustream.h>
 
 #include "qmi-message.h"
+#include "qmi-req-table.h"
+#include "timer-wheel.h"
 
 #ifdef DEBUG_PACKET
 void dump_packet(const char *prefix, void *ptr, int len);
@@ -73,8 +75,11 @@ typedef void (*request_cb)(struct qmi_dev *qmi, struct qmi_request *req, struct
 
 struct qmi_dev {
 	struct ustream_fd sf;
+	const char *name;
 
 	struct list_head req;
+	/* the pending requests by service, client id and tid */
+	struct qmi_req_table req_table;
 
 	struct {
 		bool connected;
@@ -85,23 +90,42 @@ struct qmi_dev {
 	uint32_t service_connected;
 	uint32_t service_keep_cid;
 	uint32_t service_release_cid;
+	/* client IDs kept in the --cid-cache directory, see dev.c */
+	uint32_t service_cached;
+	const char *cid_cache;
+	int cid_cache_fd;
 
 	uint8_t ctl_tid;
 	void *buf;
 
+	/* deadline of each request in msecs, 0 waits forever */
+	unsigned int timeout;
+
+	/* called for the indications of every service but CTL */
+	void (*indication_cb)(struct qmi_dev *qmi, struct qmi_msg *msg);
+
+	/* reassembly of messages spanning several read buffers */
+	char *rx_buf;
+	int rx_buf_len;
+
 	bool is_mbim;
 };
 
 struct qmi_request {
 	struct list_head list;
+	struct qmi_dev *qmi;
+	struct qmi_timer timer;
 
 	request_cb cb;
+	/* set by the command's prepare(), for its cb */
+	void *cb_data;
 
 	bool *complete;
 	bool pending;
 	bool no_error_cb;
 	uint8_t service;
 	uint16_t tid;
+	uint32_t key;
 	int ret;
 };
 
@@ -118,6 +142,30 @@ static inline bool qmi_request_pending(struct qmi_request *req)
 	return req->pending;
 }
 
+typedef int (*uqmi_server_cb)(int argc, char **argv);
+
+int uqmi_server_init(const char *path, uqmi_server_cb cb);
+void uqmi_server_done(void);
+int uqmi_client_run(const char *path, int argc, char **argv);
+
+struct option;
+typedef int (*uqmi_batch_cb)(int argc, char **argv);
+
+int uqmi_batch_run(struct qmi_dev *qmi, const char *path,
+		   const struct option *opts, uqmi_batch_cb cb);
+
+int uqmi_monitor_run(struct qmi_dev *qmi);
+
+struct uqmi_sample_config {
+	const char *path;
+	unsigned int interval;	/* ms */
+	unsigned int file_size;	/* split into <path>.N files if set */
+	unsigned int n_files;
+	bool binary;
+};
+
+int uqmi_sample_run(struct qmi_dev *qmi, const struct uqmi_sample_config *cfg);
+
 int qmi_service_connect(struct qmi_dev *qmi, QmiService svc, int client_id);
 int qmi_service_get_client_id(struct qmi_dev *qmi, QmiService svc);
 int qmi_service_release_client_id(struct qmi_dev *qmi, QmiService svc);
@@ -15,7 +15,7 @@ static void uqmi_ctrl_request_clientid_cb(struct qmi_service *ctrl, struct qmi_r
 	if (!msg)
 		return;
 
-	qmi_parse_ctl_allocate_cid_response(msg, &res);
+	qmi_parse_ctl_allocate_cid_response_arena(msg, &res, req->arena);
 	service = uqmi_service_find(ctrl->qmi, res.data.allocation_info.service);
 	if (!service) {
 		/* FIXME: error log("Can't find the service for the allocated CID") */
@@ -50,7 +50,7 @@ static void uqmi_ctrl_release_clientid_cb(struct qmi_service *ctrl, struct qmi_r
 	if (!msg)
 		return;
 
-	if (qmi_parse_ctl_release_cid_response(msg, &res)) {
+	if (qmi_parse_ctl_release_cid_response_arena(msg, &res, req->arena)) {
 		/* error_log("Couldn't parse release cid response") */
 		return;
 	}
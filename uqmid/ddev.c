@@ -1,5 +1,6 @@
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <fcntl.h>
 #include <talloc.h>
 
@@ -17,37 +18,108 @@
 #include "services.h"
 #include "modem.h"
 #include "gsmtap_util.h"
+#include "capture.h"
+#include "utils.h"
 
 /* FIXME: decide dump_packet */
 #define dump_packet(str, buf, len)
 
-static void
-__qmi_request_complete(struct qmi_service *service, struct qmi_request *req, struct qmi_msg *msg)
+static void *uqmi_arena_talloc(struct qmi_arena *arena, unsigned int len)
+{
+	return talloc_size(arena->priv, len);
+}
+
+void uqmi_arena_init(struct qmi_arena *arena, void *buf, unsigned int len, void *ctx)
+{
+	qmi_arena_init(arena, buf, len);
+	arena->alloc = uqmi_arena_talloc;
+	arena->priv = ctx;
+}
+
+/*
+ * run the callback of a request which is no longer sent and free it, msg is
+ * NULL if the request failed without a response (req->ret has the error)
+ */
+void
+qmi_request_finish(struct qmi_service *service, struct qmi_request *req, struct qmi_msg *msg, int error)
 {
+	uint8_t arena_buf[QMI_BUFFER_LEN];
+	struct qmi_arena arena;
 	void *tlv_buf;
 	int tlv_len;
 
-	if (!req->pending)
-		return;
-
-	req->pending = false;
 	req->complete = true;
-	list_del(&req->list);
-
 	if (msg) {
 		tlv_buf = qmi_msg_get_tlv_buf(msg, &tlv_len);
 		req->ret = qmi_check_message_status(tlv_buf, tlv_len);
 	} else {
-		req->ret = QMI_ERROR_CANCELLED;
+		req->ret = error;
 	}
 
-	if (req->cb && msg)
+	if (req->cb) {
+		uqmi_arena_init(&arena, arena_buf, sizeof(arena_buf), req);
+		req->arena = &arena;
 		req->cb(service, req, msg);
+	}
 
 	talloc_free(req);
 	/* frees msg as well because of tree */
 }
 
+static void
+__qmi_request_complete(struct qmi_service *service, struct qmi_request *req, struct qmi_msg *msg, int error)
+{
+	if (!req->pending)
+		return;
+
+	req->pending = false;
+	list_del(&req->list);
+	qmi_req_table_del(&service->qmi->req_table, req->key);
+	qmi_timer_cancel(&req->timer);
+
+	if (req->query)
+		uqmi_service_query_complete(service, req, msg, error);
+
+	qmi_request_finish(service, req, msg, error);
+}
+
+static void qmi_request_timeout_cb(struct qmi_timer *t)
+{
+	struct qmi_request *req = container_of(t, struct qmi_request, timer);
+	struct qmi_service *service = req->service;
+
+	service_log(service, LOGL_ERROR, "Request tid %d timed out", req->tid);
+	__qmi_request_complete(service, req, NULL, QMI_ERROR_TIMEOUT);
+}
+
+/* requests may be freed along with their service while still waiting */
+static int qmi_request_destructor(struct qmi_request *req)
+{
+	if (req->pending) {
+		qmi_req_table_del(&req->service->qmi->req_table, req->key);
+		qmi_timer_cancel(&req->timer);
+	}
+
+	return 0;
+}
+
+/* wait for the response to a request that is about to be sent */
+int qmi_request_track(struct qmi_service *service, struct qmi_request *req)
+{
+	int ret;
+
+	ret = qmi_req_table_add(&service->qmi->req_table, req->key, req);
+	if (ret)
+		return ret;
+
+	req->pending = true;
+	req->timer.cb = qmi_request_timeout_cb;
+	qmi_timer_set(&req->timer, req->timeout ? req->timeout : QMI_REQUEST_TIMEOUT);
+	talloc_set_destructor(req, qmi_request_destructor);
+
+	return 0;
+}
+
 static void
 qmi_process_msg(struct qmi_dev *qmi, struct qmi_msg *msg)
 {
@@ -90,11 +162,10 @@ qmi_process_msg(struct qmi_dev *qmi, struct qmi_msg *msg)
 	}
 
 	if (resp) {
-		list_for_each_entry(req, &service->reqs, list) {
-			if (req->tid != tid)
-				continue;
-
-			__qmi_request_complete(service, req, msg);
+		req = qmi_req_table_find(&qmi->req_table,
+					 qmi_req_key(msg->qmux.service, msg->qmux.client, tid));
+		if (req) {
+			__qmi_request_complete(service, req, msg, 0);
 			return;
 		}
 	}
@@ -106,28 +177,32 @@ static void qmi_notify_read(struct ustream *us, int bytes)
 {
 	struct qmi_dev *qmi = container_of(us, struct qmi_dev, sf.stream);
 	struct qmi_msg *msg;
+	struct iovec iov;
 	char *buf;
 	int len, msg_len;
 
 
 	while (1) {
-		buf = ustream_get_read_buf(us, &len);
-		if (!buf || !len)
-			return;
-
-		/* FIXME: check partial reads */
 		/* FIXME: implement mbim */
-
-		dump_packet("Received packet", buf, len);
-		if (len < offsetof(struct qmi_msg, flags))
+		len = offsetof(struct qmi_msg, flags);
+		buf = ustream_get_read_buf_len(us, len, &qmi->rx_buf, &qmi->rx_buf_len);
+		if (!buf)
 			return;
+
 		msg = (struct qmi_msg *) buf;
 		msg_len = le16_to_cpu(msg->qmux.len) + 1;
 
-		if (len < msg_len)
+		/* large messages may span several read buffers */
+		buf = ustream_get_read_buf_len(us, msg_len, &qmi->rx_buf, &qmi->rx_buf_len);
+		if (!buf)
 			return;
 
+		dump_packet("Received packet", buf, msg_len);
+		msg = (struct qmi_msg *) buf;
 		gsmtap_send(qmi->modem, msg, msg_len);
+		iov.iov_base = msg;
+		iov.iov_len = msg_len;
+		qmi_capture_frame(qmi->modem->name, false, &iov, 1);
 		qmi_process_msg(qmi, msg);
 		ustream_consume(us, msg_len);
 	}
@@ -169,7 +244,7 @@ struct qmi_dev *qmi_device_open(struct modem *modem, const char *path)
 
 	us->notify_state = qmi_notify_state;
 	us->notify_read = qmi_notify_read;
-	ustream_fd_init(&qmi->sf, fd);
+	ustream_fd_init_len(&qmi->sf, fd, QMI_MSG_MAX_LEN);
 	INIT_LIST_HEAD(&qmi->services);
 	qmi->modem = modem;
 
@@ -194,6 +269,8 @@ static void qmi_device_close_cb(struct uloop_timeout *timeout)
 
 	ustream_free(&qmi->sf.stream);
 	close(qmi->sf.fd.fd);
+	free(qmi->rx_buf);
+	qmi->rx_buf = NULL;
 
 	if (qmi->closing_cb)
 		qmi->closing_cb(qmi, qmi->closing_cb_data);
@@ -19,8 +19,8 @@
 #include <stdbool.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
-#include <talloc.h>
 #include <unistd.h>
 #include "gsmtapv3.h"
 
@@ -78,26 +78,24 @@ int gsmtap_enable(const char *gsmtap_addr)
 	return 0;
 }
 
-static void tx_gsmtap(void *msg, size_t length)
-{
-	if (!gsmtap_inst.valid)
-		return ;
-
-	write(gsmtap_inst.fd, msg, length);
-}
-
-void gsmtap_send(struct modem *modem, void *data, size_t length)
+/* the qmi message is appended from the caller's iovec, no copy is made */
+void gsmtap_sendv(struct modem *modem, const struct iovec *iov, int iovcnt)
 {
 	if (!gsmtap_inst.valid)
 		return;
 
 	/* WARNING. GSMTAPv3 is still under development and defines will change! */
-	void *user_data;
-	void *msg = talloc_size(modem, length + sizeof(struct gsmtap_hdr_v3) + 32);
-	struct gsmtap_hdr_v3 *gsmtap = msg;
-	struct t16l16v *metadata = msg + sizeof(struct gsmtap_hdr_v3);
-	int meta_len = 0, rest;
-	size_t packet_len = 0;
+	struct {
+		struct gsmtap_hdr_v3 gsmtap;
+		uint8_t metadata[8];
+	} __attribute__((packed)) hdr = {};
+	struct gsmtap_hdr_v3 *gsmtap = &hdr.gsmtap;
+	struct t16l16v *metadata = (struct t16l16v *) hdr.metadata;
+	struct iovec vec[GSMTAP_MAX_IOV + 1];
+	int meta_len = 0, rest, i;
+
+	if (iovcnt > GSMTAP_MAX_IOV)
+		return;
 
 	gsmtap->version = GSMTAPV3_VERSION;
 	gsmtap->res = 0;
@@ -117,9 +115,20 @@ void gsmtap_send(struct modem *modem, void *data, size_t length)
 	gsmtap->hdr_len += (meta_len >> 2);
 	gsmtap->hdr_len = htons(gsmtap->hdr_len);
 
-	user_data = msg + sizeof(struct gsmtap_hdr_v3) + meta_len;
-	memcpy(user_data, data, length);
+	vec[0].iov_base = &hdr;
+	vec[0].iov_len = sizeof(struct gsmtap_hdr_v3) + meta_len;
+	for (i = 0; i < iovcnt; i++)
+		vec[i + 1] = iov[i];
+
+	writev(gsmtap_inst.fd, vec, iovcnt + 1);
+}
+
+void gsmtap_send(struct modem *modem, void *data, size_t length)
+{
+	struct iovec iov = {
+		.iov_base = data,
+		.iov_len = length,
+	};
 
-	packet_len = length + sizeof(struct gsmtap_hdr_v3) + meta_len;
-	tx_gsmtap(msg, packet_len);
+	gsmtap_sendv(modem, &iov, 1);
 }
@@ -18,11 +18,16 @@
 #define __UQMID_GSMTAP_UTIL_H
 
 #include <stddef.h>
+#include <sys/uio.h>
+
+/* max. number of caller buffers passed to gsmtap_sendv() */
+#define GSMTAP_MAX_IOV 4
 
 struct modem;
 
 int gsmtap_enable(const char *gsmtap_addr);
 void gsmtap_disable(void);
 void gsmtap_send(struct modem *modem, void *data, size_t length);
+void gsmtap_sendv(struct modem *modem, const struct iovec *iov, int iovcnt);
 
 #endif /* __UQMID_GSMTAP_UTIL_H */
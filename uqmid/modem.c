@@ -36,7 +36,6 @@
 #include "sim_fsm.h"
 #include "uqmid.h"
 #include "qmi-errors.h"
-#include "qmi-errors.c"
 
 #include "mbim.h"
 #include "services.h"
@@ -49,6 +48,9 @@
 #include "logging.h"
 #include "utils.h"
 
+/* ms a ubus call may be answered with an earlier response */
+#define MODEM_UBUS_MAX_AGE 1000
+
 LIST_HEAD(uqmid_modems);
 
 struct modem *
@@ -190,7 +192,7 @@ wds_get_packet_status_cb(struct qmi_service *service, struct qmi_request *req, s
 		return;
 	}
 
-	ret = qmi_parse_wds_get_packet_service_status_response(msg, &res);
+	ret = qmi_parse_wds_get_packet_service_status_response_arena(msg, &res, req->arena);
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to get packet service status. Failed to parse message");
 		/* FIXME: send ubus failed */
@@ -227,12 +229,14 @@ modem_get_opmode_cb(struct qmi_service *service, struct qmi_request *req, struct
 
 	if (req->ret) {
 		modem_log(modem, LOGL_INFO, "Failed to get operating mode. Status %d/%s.", req->ret, qmi_get_error_str(req->ret));
+		data->cb(data->cb_data, req->ret, 0);
 		goto out;
 	}
 
-	ret = qmi_parse_dms_get_operating_mode_response(msg, &res);
+	ret = qmi_parse_dms_get_operating_mode_response_arena(msg, &res, req->arena);
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to get operating mode. Failed to parse message");
+		data->cb(data->cb_data, ret, 0);
 		goto out;
 	}
 
@@ -267,7 +271,8 @@ uqmid_modem_get_opmode(struct modem *modem, uqmid_modem_get_opmode_cb cb, void *
 	data->cb_data = cb_data;
 	data->modem = modem;
 
-	uqmi_service_send_simple(dms, qmi_set_dms_get_operating_mode_request, modem_get_opmode_cb, data);
+	uqmi_service_send_query(dms, qmi_set_dms_get_operating_mode_request, modem_get_opmode_cb, data,
+				MODEM_UBUS_MAX_AGE);
 	return 0;
 }
 
@@ -279,7 +284,8 @@ int uqmid_modem_networkstatus(struct modem *modem)
 		return -1;
 	}
 
-	uqmi_service_send_simple(wds, qmi_set_wds_get_packet_service_status_request, wds_get_packet_status_cb, modem);
+	uqmi_service_send_query(wds, qmi_set_wds_get_packet_service_status_request, wds_get_packet_status_cb, modem,
+				MODEM_UBUS_MAX_AGE);
 	return 0;
 }
 
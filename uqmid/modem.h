@@ -27,6 +27,7 @@
 #include <netinet/in.h>
 
 #define PATH_LEN 128
+#define MODEM_RF_BANDS_MAX 4
 
 // try to get osmocom fsm into here?
 struct modem_config {
@@ -94,6 +95,14 @@ struct modem {
 		bool cs;
 		/* attached to Packet Switch/Data */
 		bool ps;
+		/* NAS indications report registration changes, polling is a fallback */
+		bool nas_indications;
+		/* active channels, one per radio interface (LTE + NR with NSA) */
+		struct {
+			int rat;
+			uint32_t channel;
+		} rf_band[MODEM_RF_BANDS_MAX];
+		unsigned int rf_band_n;
 		/* if an error happened and the modem should stay off */
 		char *error;
 	} state;
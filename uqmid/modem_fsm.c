@@ -78,6 +78,11 @@ static const struct value_string modem_event_names[] = {
 };
 
 #define NAS_SERVICE_POLL_TIMEOUT_S 5
+/* with NAS indications the poll only catches indications that got lost */
+#define NAS_SERVICE_POLL_FALLBACK_S 60
+
+#define QMI_NAS_SERVING_SYSTEM_IND 0x0024
+#define QMI_NAS_SYSTEM_INFO_IND 0x004E
 
 void modem_fsm_start(struct modem *modem)
 {
@@ -135,7 +140,15 @@ static void uqmid_modem_version_cb(struct qmi_service *ctl_service, struct qmi_r
 	uint16_t major, minor;
 
 	struct qmi_ctl_get_version_info_response res = {};
-	qmi_parse_ctl_get_version_info_response(msg, &res);
+
+	/* the state timeout takes care of it */
+	if (!msg) {
+		modem_log(modem, LOGL_ERROR, "Failed to get version info. Status %d/%s.", req->ret,
+			  qmi_get_error_str(req->ret));
+		return;
+	}
+
+	qmi_parse_ctl_get_version_info_response_arena(msg, &res, req->arena);
 
 	for (int i = 0; i < res.data.service_list_n; i++) {
 		service_id = res.data.service_list[i].service;
@@ -191,7 +204,7 @@ static void get_manuf_cb(struct qmi_service *service, struct qmi_request *req, s
 	int ret = 0;
 
 	struct qmi_dms_get_manufacturer_response res = {};
-	ret = qmi_parse_dms_get_manufacturer_response(msg, &res);
+	ret = msg ? qmi_parse_dms_get_manufacturer_response_arena(msg, &res, req->arena) : req->ret;
 
 	if (ret) {
 		/* FIXME: No manufacturer. Ignoring */
@@ -220,7 +233,7 @@ static void get_model_cb(struct qmi_service *service, struct qmi_request *req, s
 	int ret = 0;
 
 	struct qmi_dms_get_model_response res = {};
-	ret = qmi_parse_dms_get_model_response(msg, &res);
+	ret = msg ? qmi_parse_dms_get_model_response_arena(msg, &res, req->arena) : req->ret;
 
 	if (ret) {
 		/* FIXME: No model. Ignoring */
@@ -249,7 +262,7 @@ static void get_revision_cb(struct qmi_service *service, struct qmi_request *req
 	int ret = 0;
 
 	struct qmi_dms_get_revision_response res = {};
-	ret = qmi_parse_dms_get_revision_response(msg, &res);
+	ret = msg ? qmi_parse_dms_get_revision_response_arena(msg, &res, req->arena) : req->ret;
 
 	if (ret) {
 		/* FIXME: No revision. Ignoring */
@@ -278,7 +291,7 @@ static void get_ids_cb(struct qmi_service *service, struct qmi_request *req, str
 	int ret = 0;
 
 	struct qmi_dms_get_ids_response res = {};
-	ret = qmi_parse_dms_get_ids_response(msg, &res);
+	ret = msg ? qmi_parse_dms_get_ids_response_arena(msg, &res, req->arena) : req->ret;
 
 	if (ret) {
 		/* FIXME: No revision. Ignoring */
@@ -313,7 +326,7 @@ static void modem_st_get_model_onenter(struct osmo_fsm_inst *fi, uint32_t old_st
 		/* FIXME: fail to perm failure */
 	}
 
-	uqmi_service_send_simple(service, qmi_set_dms_get_model_request, get_model_cb, modem);
+	uqmi_service_send_query(service, qmi_set_dms_get_model_request, get_model_cb, modem, 0);
 }
 
 static void modem_st_get_model(struct osmo_fsm_inst *fi, uint32_t event, void *data)
@@ -330,13 +343,13 @@ static void modem_st_get_model(struct osmo_fsm_inst *fi, uint32_t event, void *d
 
 	switch (event) {
 	case MODEM_EV_RX_MODEL:
-		uqmi_service_send_simple(service, qmi_set_dms_get_manufacturer_request, get_manuf_cb, modem);
+		uqmi_service_send_query(service, qmi_set_dms_get_manufacturer_request, get_manuf_cb, modem, 0);
 		break;
 	case MODEM_EV_RX_MANUFACTURER:
-		uqmi_service_send_simple(service, qmi_set_dms_get_revision_request, get_revision_cb, modem);
+		uqmi_service_send_query(service, qmi_set_dms_get_revision_request, get_revision_cb, modem, 0);
 		break;
 	case MODEM_EV_RX_REVISION:
-		uqmi_service_send_simple(service, qmi_set_dms_get_ids_request, get_ids_cb, modem);
+		uqmi_service_send_query(service, qmi_set_dms_get_ids_request, get_ids_cb, modem, 0);
 		break;
 	case MODEM_EV_RX_IMEI:
 		osmo_fsm_inst_state_chg(fi, MODEM_ST_POWEROFF, 3, 0);
@@ -357,7 +370,7 @@ static void dms_get_operating_mode_cb(struct qmi_service *service, struct qmi_re
 		return;
 	}
 
-	ret = qmi_parse_dms_get_operating_mode_response(msg, &res);
+	ret = qmi_parse_dms_get_operating_mode_response_arena(msg, &res, req->arena);
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to get operating mode. Failed to parse message");
 		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_FAILED, NULL);
@@ -404,7 +417,7 @@ static void modem_st_poweroff_onenter(struct osmo_fsm_inst *fi, uint32_t old_sta
 
 	/* FIXME: abort when DMS doesn't exist */
 	if (dms)
-		uqmi_service_send_simple(dms, qmi_set_dms_get_operating_mode_request, dms_get_operating_mode_cb, modem);
+		uqmi_service_send_query(dms, qmi_set_dms_get_operating_mode_request, dms_get_operating_mode_cb, modem, 0);
 }
 static void modem_st_poweroff(struct osmo_fsm_inst *fi, uint32_t event, void *data)
 {
@@ -416,7 +429,7 @@ static void modem_st_poweroff(struct osmo_fsm_inst *fi, uint32_t event, void *da
 		tx_dms_set_operating_mode(modem, dms, QMI_DMS_OPERATING_MODE_LOW_POWER, dms_set_operating_mode_cb);
 		break;
 	case MODEM_EV_RX_POWERSET:
-		uqmi_service_send_simple(dms, qmi_set_dms_get_operating_mode_request, dms_get_operating_mode_cb, modem);
+		uqmi_service_send_query(dms, qmi_set_dms_get_operating_mode_request, dms_get_operating_mode_cb, modem, 0);
 		break;
 	case MODEM_EV_RX_POWEROFF:
 		if (modem->config.configured && !modem->state.error)
@@ -463,7 +476,7 @@ static void wds_modify_profile_cb(struct qmi_service *service, struct qmi_reques
 		return;
 	}
 
-	ret = qmi_parse_wds_modify_profile_response(msg, &res);
+	ret = qmi_parse_wds_modify_profile_response_arena(msg, &res, req->arena);
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to modify profile list. Failed to parse message");
 		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_MODIFIED_PROFILE, (void *)err);
@@ -487,7 +500,7 @@ static void wds_get_profile_list_cb(struct qmi_service *service, struct qmi_requ
 		return;
 	}
 
-	ret = qmi_parse_wds_get_profile_list_response(msg, &res);
+	ret = qmi_parse_wds_get_profile_list_response_arena(msg, &res, req->arena);
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to get operating mode. Failed to parse message");
 		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_FAILED, NULL);
@@ -574,7 +587,7 @@ static void wda_set_data_format_cb(struct qmi_service *service, struct qmi_reque
 		return;
 	}
 
-	ret = qmi_parse_wda_set_data_format_response(msg, &res);
+	ret = qmi_parse_wda_set_data_format_response_arena(msg, &res, req->arena);
 	if (ret) {
 		modem_log(modem, LOGL_ERROR, "Failed to set data format. Failed to parse message");
 		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_FAILED, NULL);
@@ -676,7 +689,7 @@ static void modem_st_poweron_onenter(struct osmo_fsm_inst *fi, uint32_t old_stat
 
 	/* FIXME: abort when DMS doesn't exist */
 	if (dms)
-		uqmi_service_send_simple(dms, qmi_set_dms_get_operating_mode_request, dms_get_operating_mode_cb, modem);
+		uqmi_service_send_query(dms, qmi_set_dms_get_operating_mode_request, dms_get_operating_mode_cb, modem, 0);
 }
 static void modem_st_poweron(struct osmo_fsm_inst *fi, uint32_t event, void *data)
 {
@@ -701,16 +714,45 @@ static void subscribe_result_cb(struct qmi_service *service, struct qmi_request
 		modem_log(modem, LOGL_INFO, "Service %d: Subscribe check failed with %d/%s", service->service, req->ret,
 			  qmi_get_error_str(req->ret));
 		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_SUBSCRIBE_FAILED,
-				       (void *)(long)le32_to_cpu(msg->svc.message));
+				       (void *)(long)le32_to_cpu(req->msg->svc.message));
 		return;
 	}
 
 	osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_SUBSCRIBED, (void *)(long)le32_to_cpu(msg->svc.message));
 }
 
+/* from the get serving system response and the serving system indication */
+static void modem_serving_system_update(struct modem *modem, uint8_t registration_state,
+					uint8_t cs_attach_state, uint8_t ps_attach_state)
+{
+	modem->state.cs = cs_attach_state == QMI_NAS_ATTACH_STATE_ATTACHED;
+	modem->state.ps = ps_attach_state == QMI_NAS_ATTACH_STATE_ATTACHED;
+
+	/* indications keep coming once the modem is registered */
+	if (modem->fi->state != MODEM_ST_NETSEARCH)
+		return;
+
+	modem_log(modem, LOGL_INFO, "Network registration state %d", registration_state);
+
+	switch (registration_state) {
+	case QMI_NAS_REGISTRATION_STATE_REGISTERED:
+		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_REGISTERED, NULL);
+		return;
+	case QMI_NAS_REGISTRATION_STATE_NOT_REGISTERED:
+	case QMI_NAS_REGISTRATION_STATE_UNKNOWN:
+	case QMI_NAS_REGISTRATION_STATE_REGISTRATION_DENIED:
+		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_UNREGISTERED, NULL);
+		return;
+	case QMI_NAS_REGISTRATION_STATE_NOT_REGISTERED_SEARCHING:
+		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_SEARCHING, NULL);
+		return;
+	}
+}
+
 static void get_serving_system_cb(struct qmi_service *service, struct qmi_request *req, struct qmi_msg *msg)
 {
 	struct modem *modem = req->cb_data;
+	struct qmi_nas_get_serving_system_response_view view;
 	struct qmi_nas_get_serving_system_response res = {};
 
 	if (req->ret) {
@@ -720,8 +762,10 @@ static void get_serving_system_cb(struct qmi_service *service, struct qmi_reques
 		return;
 	}
 
-	int ret = qmi_parse_nas_get_serving_system_response(msg, &res);
-	if (ret) {
+	/* polled every few seconds, only decode the registration state */
+	qmi_view_nas_get_serving_system_response(msg, &view);
+	int ret = qmi_view_nas_get_serving_system_response_serving_system(&view, &res, req->arena);
+	if (ret && ret != QMI_ERROR_NO_DATA) {
 		modem_log(modem, LOGL_ERROR, "Failed to decode serving system response");
 		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_FAILED, (void *)(long)1);
 		return;
@@ -733,20 +777,53 @@ static void get_serving_system_cb(struct qmi_service *service, struct qmi_reques
 		return;
 	}
 
-	modem_log(modem, LOGL_INFO, "Network registration state %d", res.data.serving_system.registration_state);
+	modem_serving_system_update(modem, res.data.serving_system.registration_state,
+				    res.data.serving_system.cs_attach_state,
+				    res.data.serving_system.ps_attach_state);
+}
 
-	switch (res.data.serving_system.registration_state) {
-	case QMI_NAS_REGISTRATION_STATE_REGISTERED:
-		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_REGISTERED, NULL);
-		return;
-	case QMI_NAS_REGISTRATION_STATE_NOT_REGISTERED:
-	case QMI_NAS_REGISTRATION_STATE_UNKNOWN:
-	case QMI_NAS_REGISTRATION_STATE_REGISTRATION_DENIED:
-		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_UNREGISTERED, NULL);
+static void nas_serving_system_ind_cb(struct qmi_service *service, struct qmi_msg *msg, void *data)
+{
+	struct modem *modem = data;
+	struct qmi_nas_serving_system_indication_view view;
+	struct qmi_nas_serving_system_indication res = {};
+	QMI_ARENA_DECLARE(arena, 256);
+
+	qmi_view_nas_serving_system_indication(msg, &view);
+	if (qmi_view_nas_serving_system_indication_serving_system(&view, &res, &arena))
 		return;
-	case QMI_NAS_REGISTRATION_STATE_NOT_REGISTERED_SEARCHING:
-		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_SEARCHING, NULL);
+
+	modem_serving_system_update(modem, res.data.serving_system.registration_state,
+				    res.data.serving_system.cs_attach_state,
+				    res.data.serving_system.ps_attach_state);
+}
+
+/* the system info only tells about service, registration comes with the serving system */
+static void nas_system_info_ind_cb(struct qmi_service *service, struct qmi_msg *msg, void *data)
+{
+	struct modem *modem = data;
+	struct qmi_nas_system_info_indication_view view;
+	struct qmi_nas_system_info_indication res = {};
+
+	if (modem->fi->state != MODEM_ST_NETSEARCH)
 		return;
+
+	qmi_view_nas_system_info_indication(msg, &view);
+	qmi_view_nas_system_info_indication_gsm_service_status(&view, &res, NULL);
+	qmi_view_nas_system_info_indication_wcdma_service_status(&view, &res, NULL);
+	qmi_view_nas_system_info_indication_lte_service_status(&view, &res, NULL);
+	qmi_view_nas_system_info_indication_nr5g_service_status_info(&view, &res, NULL);
+
+	if ((res.set.gsm_service_status &&
+	     res.data.gsm_service_status.service_status == QMI_NAS_SERVICE_STATUS_AVAILABLE) ||
+	    (res.set.wcdma_service_status &&
+	     res.data.wcdma_service_status.service_status == QMI_NAS_SERVICE_STATUS_AVAILABLE) ||
+	    (res.set.lte_service_status &&
+	     res.data.lte_service_status.service_status == QMI_NAS_SERVICE_STATUS_AVAILABLE) ||
+	    (res.set.nr5g_service_status_info &&
+	     res.data.nr5g_service_status_info.service_status == QMI_NAS_SERVICE_STATUS_AVAILABLE)) {
+		modem_log(modem, LOGL_INFO, "Full service available");
+		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_REGISTERED, NULL);
 	}
 }
 
@@ -766,6 +843,14 @@ static void modem_st_netsearch_onenter(struct osmo_fsm_inst *fi, uint32_t old_st
 {
 	struct modem *modem = fi->priv;
 	struct qmi_service *nas = uqmi_service_find(modem->qmi, QMI_SERVICE_NAS);
+
+	/* the handlers stay around, onenter might run again */
+	uqmi_service_remove_indication(nas, QMI_NAS_SERVING_SYSTEM_IND, nas_serving_system_ind_cb, modem);
+	uqmi_service_remove_indication(nas, QMI_NAS_SYSTEM_INFO_IND, nas_system_info_ind_cb, modem);
+	uqmi_service_register_indication(nas, QMI_NAS_SERVING_SYSTEM_IND, nas_serving_system_ind_cb, modem);
+	uqmi_service_register_indication(nas, QMI_NAS_SYSTEM_INFO_IND, nas_system_info_ind_cb, modem);
+
+	modem->state.nas_indications = false;
 	tx_nas_subscribe_nas_events(modem, nas, 1, subscribe_result_cb);
 }
 
@@ -783,8 +868,12 @@ static void modem_st_netsearch(struct osmo_fsm_inst *fi, uint32_t event, void *d
 		osmo_timer_schedule(&fi->timer, 5, 0);
 		break;
 	case MODEM_EV_RX_SUBSCRIBED:
+		modem->state.nas_indications = true;
+		osmo_timer_schedule(&fi->timer, NAS_SERVICE_POLL_FALLBACK_S, 0);
+		/* fall through */
 	case MODEM_EV_RX_SUBSCRIBE_FAILED:
-		uqmi_service_send_simple(nas, qmi_set_nas_get_serving_system_request, get_serving_system_cb, modem);
+		/* anything that happened before the subscription */
+		uqmi_service_send_query(nas, qmi_set_nas_get_serving_system_request, get_serving_system_cb, modem, 0);
 		break;
 	case MODEM_EV_RX_UNREGISTERED:
 		modem_log(modem, LOGL_INFO, "Start network search.");
@@ -793,8 +882,38 @@ static void modem_st_netsearch(struct osmo_fsm_inst *fi, uint32_t event, void *d
 	}
 }
 
+static void get_rf_band_information_cb(struct qmi_service *service, struct qmi_request *req, struct qmi_msg *msg)
+{
+	struct modem *modem = req->cb_data;
+	struct qmi_nas_get_rf_band_information_response res = {};
+	unsigned int i;
+
+	if (req->ret || qmi_parse_nas_get_rf_band_information_response_arena(msg, &res, req->arena)) {
+		modem_log(modem, LOGL_INFO, "Failed to get rf band information.");
+		return;
+	}
+
+	/* the extended list has the full 32 bit NR-ARFCNs */
+	if (res.data.extended_list_n) {
+		for (i = 0; i < res.data.extended_list_n && i < MODEM_RF_BANDS_MAX; i++) {
+			modem->state.rf_band[i].rat = res.data.extended_list[i].radio_interface;
+			modem->state.rf_band[i].channel = res.data.extended_list[i].active_channel;
+		}
+	} else {
+		for (i = 0; i < res.data.list_n && i < MODEM_RF_BANDS_MAX; i++) {
+			modem->state.rf_band[i].rat = res.data.list[i].radio_interface;
+			modem->state.rf_band[i].channel = res.data.list[i].active_channel;
+		}
+	}
+	modem->state.rf_band_n = i;
+}
+
 static void modem_st_registered_onenter(struct osmo_fsm_inst *fi, uint32_t old_state)
 {
+	struct modem *modem = fi->priv;
+	struct qmi_service *nas = uqmi_service_find(modem->qmi, QMI_SERVICE_NAS);
+
+	uqmi_service_send_query(nas, qmi_set_nas_get_rf_band_information_request, get_rf_band_information_cb, modem, 0);
 	osmo_fsm_inst_state_chg(fi, MODEM_ST_START_IFACE, 5, 0);
 }
 static void modem_st_registered(struct osmo_fsm_inst *fi, uint32_t event, void *data)
@@ -808,7 +927,7 @@ static void wds_start_network_cb(struct qmi_service *service, struct qmi_request
 	long err = 1;
 	int ret;
 
-	ret = qmi_parse_wds_start_network_response(msg, &res);
+	ret = msg ? qmi_parse_wds_start_network_response_arena(msg, &res, req->arena) : req->ret;
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to get operating mode. Failed to parse message");
 		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_FAILED, NULL);
@@ -849,6 +968,12 @@ wds_stop_network_cb(struct qmi_service *service, struct qmi_request *req, struct
 	struct modem *modem = req->cb_data;
 	int ret;
 
+	if (req->ret || !msg) {
+		modem_log(modem, LOGL_INFO, "Failed to stop network.");
+		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_FAILED, (void *)(long)req->ret);
+		return;
+	}
+
 	ret = qmi_parse_wds_stop_network_response(msg);
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to stop network.");
@@ -925,7 +1050,7 @@ static void wds_get_current_settings_cb(struct qmi_service *service, struct qmi_
 	struct qmi_wds_get_current_settings_response res = {};
 	int ret;
 
-	ret = qmi_parse_wds_get_current_settings_response(msg, &res);
+	ret = msg ? qmi_parse_wds_get_current_settings_response_arena(msg, &res, req->arena) : req->ret;
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to get current settings. Failed to parse message");
 		osmo_fsm_inst_dispatch(modem->fi, MODEM_EV_RX_FAILED, NULL);
@@ -1044,8 +1169,9 @@ static int modem_fsm_timer_cb(struct osmo_fsm_inst *fi)
 			modem_log(modem, LOGL_ERROR, "NAS service doesn't exist");
 			return 1;
 		}
-		uqmi_service_send_simple(service, qmi_set_nas_get_serving_system_request, get_serving_system_cb, modem);
-		osmo_timer_schedule(&fi->timer, NAS_SERVICE_POLL_TIMEOUT_S, 0);
+		uqmi_service_send_query(service, qmi_set_nas_get_serving_system_request, get_serving_system_cb, modem, 0);
+		osmo_timer_schedule(&fi->timer, modem->state.nas_indications ?
+				    NAS_SERVICE_POLL_FALLBACK_S : NAS_SERVICE_POLL_TIMEOUT_S, 0);
 		break;
 	case MODEM_ST_START_IFACE:
 		switch (fi->T) {
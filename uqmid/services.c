@@ -1,6 +1,8 @@
 /* similar to dev.c but self container */
 
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 #include <talloc.h>
 #include <errno.h>
@@ -15,6 +17,8 @@
 #include "uqmid.h"
 
 #include "gsmtap_util.h"
+#include "capture.h"
+#include "utils.h"
 
 #ifdef DEBUG_PACKET
 static void dump_packet(const char *prefix, void *ptr, int len)
@@ -57,6 +61,7 @@ uqmi_service_create(struct qmi_dev *qmi, int service_id)
 	list_add(&service->list, &qmi->services);
 	INIT_LIST_HEAD(&service->indications);
 	INIT_LIST_HEAD(&service->reqs);
+	INIT_LIST_HEAD(&service->responses);
 
 	return service;
 }
@@ -91,6 +96,8 @@ _service_send_request(struct qmi_service *service, struct qmi_request *req)
 	struct qmi_msg *msg = req->msg;
 	int len = qmi_complete_request_message(msg);
 	uint16_t tid = uqmi_service_get_next_tid(service);
+	struct iovec iov;
+	int ret;
 
 	if (req->service->service == QMI_SERVICE_CTL) {
 		msg->ctl.transaction = tid;
@@ -100,9 +107,14 @@ _service_send_request(struct qmi_service *service, struct qmi_request *req)
 		msg->qmux.client = service->client_id;
 	}
 
+	req->key = qmi_req_key(msg->qmux.service, msg->qmux.client, tid);
 	req->ret = -1;
 	req->tid = tid;
-	req->pending = true;
+	ret = qmi_request_track(service, req);
+	if (ret) {
+		service_log(service, LOGL_ERROR, "Too many pending requests, tid %d not sent", tid);
+		return ret;
+	}
 
 	/* FIXME: fix mbim support */
 
@@ -113,9 +125,13 @@ _service_send_request(struct qmi_service *service, struct qmi_request *req)
 		modem_log(service->qmi->modem, LOGL_DEBUG, "Transmit message to srv %d msg %04x flag: %02x tid: %04x",
 			  msg->qmux.service, le16_to_cpu(msg->svc.message), msg->flags, le16_to_cpu(msg->svc.transaction));
 
+	iov.iov_base = msg;
+	iov.iov_len = len;
+
 	dump_packet("Send packet", msg, len);
-	gsmtap_send(service->qmi->modem, msg, len);
-	ustream_write(&service->qmi->sf.stream, (void *) msg, len, false);
+	gsmtap_sendv(service->qmi->modem, &iov, 1);
+	qmi_capture_frame(service->qmi->modem->name, true, &iov, 1);
+	ustream_fd_writev(&service->qmi->sf, &iov, 1);
 
 	return 0;
 }
@@ -160,10 +176,11 @@ uqmi_service_get_client_id(struct qmi_service *service)
 	return 0;
 }
 
-int
-uqmi_service_send_simple(struct qmi_service *service,
-			 int(*encoder)(struct qmi_msg *msg),
-			 request_cb cb, void *cb_data)
+static int
+_service_send_simple(struct qmi_service *service,
+		     int(*encoder)(struct qmi_msg *msg),
+		     request_cb cb, void *cb_data,
+		     bool query, unsigned int max_age)
 {
 	struct qmi_request *req = talloc_zero(service, struct qmi_request);
 	struct qmi_msg *msg = talloc_zero_size(req, 1024);
@@ -171,6 +188,8 @@ uqmi_service_send_simple(struct qmi_service *service,
 	req->msg = msg;
 	req->cb = cb;
 	req->cb_data = cb_data;
+	req->query = query;
+	req->max_age = max_age;
 
 	int ret = encoder(msg);
 	if (ret) {
@@ -183,18 +202,213 @@ uqmi_service_send_simple(struct qmi_service *service,
 	return uqmi_service_send_msg(service, req);
 }
 
+int
+uqmi_service_send_simple(struct qmi_service *service,
+			 int(*encoder)(struct qmi_msg *msg),
+			 request_cb cb, void *cb_data)
+{
+	return _service_send_simple(service, encoder, cb, cb_data, false, 0);
+}
+
+int
+uqmi_service_send_query(struct qmi_service *service,
+			int(*encoder)(struct qmi_msg *msg),
+			request_cb cb, void *cb_data, unsigned int max_age)
+{
+	return _service_send_simple(service, encoder, cb, cb_data, true, max_age);
+}
+
+/*
+ * Queries (requests without side effects) are not sent again while an
+ * identical one is waiting for its response: they are added to its
+ * followers and get the same response. With max_age set, the response to
+ * a query is also kept for a while, and later identical queries which
+ * accept its age are answered from it without asking the modem.
+ */
+struct qmi_response {
+	struct list_head list; /*! entry on service->responses, newest first */
+	struct qmi_msg *query;
+	struct qmi_msg *msg;
+	uint64_t time;
+};
+
+/* responses kept per service, the oldest one is dropped beyond that */
+#define QMI_RESPONSES_MAX	8
+
+static uint64_t
+service_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool
+service_query_equal(struct qmi_msg *a, struct qmi_msg *b)
+{
+	void *tlv_a, *tlv_b;
+	int len_a, len_b;
+
+	if (a->svc.message != b->svc.message)
+		return false;
+
+	tlv_a = qmi_msg_get_tlv_buf(a, &len_a);
+	tlv_b = qmi_msg_get_tlv_buf(b, &len_b);
+
+	return len_a == len_b && !memcmp(tlv_a, tlv_b, len_a);
+}
+
+static unsigned int
+service_msg_len(struct qmi_msg *msg)
+{
+	return le16_to_cpu(msg->qmux.len) + 1;
+}
+
+static void
+service_cached_response_cb(struct qmi_timer *t)
+{
+	struct qmi_request *req = container_of(t, struct qmi_request, timer);
+
+	qmi_request_finish(req->service, req, req->msg, 0);
+}
+
+static int
+service_cached_response_destructor(struct qmi_request *req)
+{
+	qmi_timer_cancel(&req->timer);
+	return 0;
+}
+
+/* returns true if req is answered without sending it */
+static bool
+service_query_attach(struct qmi_service *service, struct qmi_request *req)
+{
+	struct qmi_response *res;
+	struct qmi_request *sent;
+	uint64_t now = service_now_ms();
+
+	list_for_each_entry(sent, &service->reqs, list) {
+		if (!sent->query || !sent->pending ||
+		    !service_query_equal(sent->msg, req->msg))
+			continue;
+
+		list_add_tail(&req->list, &sent->followers);
+		return true;
+	}
+
+	if (!req->max_age)
+		return false;
+
+	list_for_each_entry(res, &service->responses, list) {
+		if (!service_query_equal(res->query, req->msg))
+			continue;
+
+		if (now - res->time > req->max_age)
+			return false;
+
+		/* answered from the uloop, like a response from the modem */
+		talloc_free(req->msg);
+		req->msg = talloc_memdup(req, res->msg, service_msg_len(res->msg));
+		if (!req->msg)
+			return false;
+
+		req->timer.cb = service_cached_response_cb;
+		talloc_set_destructor(req, service_cached_response_destructor);
+		qmi_timer_set(&req->timer, 0);
+		return true;
+	}
+
+	return false;
+}
+
+static void
+service_store_response(struct qmi_service *service, struct qmi_request *req, struct qmi_msg *msg)
+{
+	struct qmi_response *res, *tmp;
+	int n = 0;
+
+	list_for_each_entry_safe(res, tmp, &service->responses, list) {
+		if (service_query_equal(res->query, req->msg) ||
+		    ++n >= QMI_RESPONSES_MAX) {
+			list_del(&res->list);
+			talloc_free(res);
+		}
+	}
+
+	res = talloc_zero(service, struct qmi_response);
+	if (!res)
+		return;
+
+	res->query = talloc_memdup(res, req->msg, service_msg_len(req->msg));
+	res->msg = talloc_memdup(res, msg, service_msg_len(msg));
+	if (!res->query || !res->msg) {
+		talloc_free(res);
+		return;
+	}
+
+	res->time = service_now_ms();
+	list_add(&res->list, &service->responses);
+}
+
+static void
+service_drop_responses(struct qmi_service *service)
+{
+	struct qmi_response *res, *tmp;
+
+	list_for_each_entry_safe(res, tmp, &service->responses, list) {
+		list_del(&res->list);
+		talloc_free(res);
+	}
+}
+
+/* a query got its response (or failed): hand it to the followers as well */
+void
+uqmi_service_query_complete(struct qmi_service *service, struct qmi_request *req, struct qmi_msg *msg, int error)
+{
+	struct qmi_request *follower, *tmp;
+	bool keep = req->max_age;
+	void *tlv_buf;
+	int tlv_len;
+
+	list_for_each_entry_safe(follower, tmp, &req->followers, list) {
+		keep |= follower->max_age;
+		list_del(&follower->list);
+		qmi_request_finish(service, follower, msg, error);
+	}
+
+	if (!keep || !msg)
+		return;
+
+	tlv_buf = qmi_msg_get_tlv_buf(msg, &tlv_len);
+	if (!qmi_check_message_status(tlv_buf, tlv_len))
+		service_store_response(service, req, msg);
+}
+
 int
 uqmi_service_send_msg(struct qmi_service *service, struct qmi_request *req)
 {
 	req->pending = false;
 	req->complete = false;
 	req->service = service;
+	INIT_LIST_HEAD(&req->followers);
+
+	if (req->query && service->service != QMI_SERVICE_CTL &&
+	    service_query_attach(service, req))
+		return 0;
+
+	/* anything else may change what the kept responses say */
+	if (!req->query)
+		service_drop_responses(service);
 
 	list_add(&req->list, &service->reqs);
 	if (service->state == SERVICE_IDLE)
 		return uqmi_service_get_client_id(service);
-	else
-		return uqmi_service_send_request(service);
+	else if (service->state == SERVICE_READY)
+		return _service_send_request(service, req);
+
+	/* sent together with the others once the client id is known */
+	return 0;
 }
 
 int
@@ -207,15 +421,7 @@ uqmi_service_send_msg2(struct qmi_dev *qmi, struct qmi_request *req, int service
 		return -EINVAL;
 	}
 
-	req->pending = false;
-	req->complete = false;
-	req->service = service;
-
-	list_add(&req->list, &service->reqs);
-	if (service->state == SERVICE_IDLE)
-		return uqmi_service_get_client_id(service);
-	else
-		return uqmi_service_send_request(service);
+	return uqmi_service_send_msg(service, req);
 }
 
 /* called when the call id returns */
@@ -277,6 +483,7 @@ int uqmi_service_remove_indication(struct qmi_service *service, uint16_t qmi_ind
 			continue;
 
 		list_del(&indication->list);
+		talloc_free(indication);
 	}
 
 	return 0;
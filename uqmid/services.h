@@ -52,6 +52,9 @@ struct qmi_service {
 	/* contains all pending requests */
 	struct list_head reqs;
 
+	/* recent responses to queries sent with a max_age, newest first */
+	struct list_head responses;
+
 	/* contains indication registers
 	 * a sorted llist by qmi msg id
 	 */
@@ -79,6 +82,12 @@ int uqmi_service_send_msg2(struct qmi_dev *qmi, struct qmi_request *req, int ser
 int uqmi_service_send_simple(struct qmi_service *service,
 			 int(*encode)(struct qmi_msg *msg),
 			 request_cb cb, void *cb_data);
+/* like send_simple for a request without side effects, see services.c */
+int uqmi_service_send_query(struct qmi_service *service,
+			    int(*encode)(struct qmi_msg *msg),
+			    request_cb cb, void *cb_data, unsigned int max_age);
+void uqmi_service_query_complete(struct qmi_service *service, struct qmi_request *req,
+				 struct qmi_msg *msg, int error);
 
 int uqmi_service_get_next_tid(struct qmi_service *service);
 struct qmi_service *uqmi_service_create(struct qmi_dev *qmi, int service_id);
@@ -123,7 +123,7 @@ static void uim_get_slot_status_cb(struct qmi_service *service, struct qmi_reque
 	}
 
 	struct qmi_uim_get_slot_status_response res = {};
-	ret = qmi_parse_uim_get_slot_status_response(msg, &res);
+	ret = qmi_parse_uim_get_slot_status_response_arena(msg, &res, req->arena);
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to get slot status.");
 		osmo_fsm_inst_dispatch(modem->sim.fi, SIM_EV_RX_UIM_GET_SLOT_FAILED, NULL);
@@ -184,7 +184,7 @@ static void uim_get_card_status_cb(struct qmi_service *service, struct qmi_reque
 	}
 
 	struct qmi_uim_get_card_status_response res = {};
-	ret = qmi_parse_uim_get_card_status_response(msg, &res);
+	ret = qmi_parse_uim_get_card_status_response_arena(msg, &res, req->arena);
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to get card status. Decoder failed.");
 		osmo_fsm_inst_dispatch(modem->sim.fi, SIM_EV_RX_UIM_FAILED, NULL);
@@ -248,7 +248,7 @@ static void uim_read_imsi_cb(struct qmi_service *service, struct qmi_request *re
 	}
 
 	struct qmi_uim_read_record_response res = {};
-	ret = qmi_parse_uim_read_record_response(msg, &res);
+	ret = qmi_parse_uim_read_record_response_arena(msg, &res, req->arena);
 	if (ret) {
 		modem_log(modem, LOGL_INFO, "Failed to read imsi. Decoder failed. %d", ret);
 		osmo_fsm_inst_dispatch(modem->sim.fi, SIM_EV_RX_UIM_GET_IMSI_FAILED, NULL);
@@ -285,7 +285,7 @@ static void sim_st_get_info_on_enter(struct osmo_fsm_inst *fi, uint32_t old_stat
 	// should we use uim and have it available?
 	if (uim && modem->sim.use_uim) {
 		modem_log(modem, LOGL_INFO, "Trying to query UIM for slot status.");
-		uqmi_service_send_simple(uim, qmi_set_uim_get_slot_status_request, uim_get_slot_status_cb, modem);
+		uqmi_service_send_query(uim, qmi_set_uim_get_slot_status_request, uim_get_slot_status_cb, modem, 0);
 		return;
 	} else {
 		// dms
@@ -304,15 +304,15 @@ static void sim_st_get_info(struct osmo_fsm_inst *fi, uint32_t event, void *_dat
 	case SIM_EV_RX_UIM_VALID_ICCID:
 		/* Get Slot Status succeeded? */
 		if (uim && modem->sim.use_uim)
-			uqmi_service_send_simple(uim, qmi_set_uim_get_card_status_request, uim_get_card_status_cb,
-						 modem);
+			uqmi_service_send_query(uim, qmi_set_uim_get_card_status_request, uim_get_card_status_cb,
+						modem, 0);
 		break;
 	case SIM_EV_RX_UIM_NO_UIM_FOUND:
 		if (uim && modem->sim.use_uim) {
 			/* Get Slot Status failed, try Get Card Status */
 			if (data == 0)
-				uqmi_service_send_simple(uim, qmi_set_uim_get_card_status_request, uim_get_card_status_cb,
-							 modem);
+				uqmi_service_send_query(uim, qmi_set_uim_get_card_status_request, uim_get_card_status_cb,
+							modem, 0);
 			/* Get Card Status also failed to get one */
 			else if (data == 1)
 				osmo_fsm_inst_state_chg(fi, SIM_ST_FAIL_NO_SIM_PRESENT, 0, 0);
@@ -357,7 +357,16 @@ static void uim_verify_pin_cb(struct qmi_service *service, struct qmi_request *r
 	int ret = 0;
 
 	struct qmi_uim_verify_pin_response res = {};
-	ret = qmi_parse_uim_verify_pin_response(msg, &res);
+
+	/* no answer doesn't tell anything about the PIN, check the card again */
+	if (!msg) {
+		modem_log(modem, LOGL_INFO, "Failed to verify PIN. Qmi Ret %d/%s.", req->ret,
+			  qmi_get_error_str(req->ret));
+		osmo_fsm_inst_dispatch(modem->sim.fi, SIM_EV_RX_UIM_REFRESH, NULL);
+		return;
+	}
+
+	ret = qmi_parse_uim_verify_pin_response_arena(msg, &res, req->arena);
 
 	if (req->ret) {
 		modem_log(modem, LOGL_INFO, "Failed to verify PIN. Qmi Ret %d/%s.", req->ret,
@@ -436,7 +445,16 @@ static void uim_unblock_pin_cb(struct qmi_service *service, struct qmi_request *
 	int ret = 0;
 
 	struct qmi_uim_unblock_pin_response res = {};
-	ret = qmi_parse_uim_unblock_pin_response(msg, &res);
+
+	/* no answer doesn't tell anything about the PIN, check the card again */
+	if (!msg) {
+		modem_log(modem, LOGL_INFO, "Failed to unblock PIN by PUK. Qmi Ret %d/%s.", req->ret,
+			  qmi_get_error_str(req->ret));
+		osmo_fsm_inst_dispatch(modem->sim.fi, SIM_EV_RX_UIM_REFRESH, NULL);
+		return;
+	}
+
+	ret = qmi_parse_uim_unblock_pin_response_arena(msg, &res, req->arena);
 
 	if (req->ret) {
 		modem_log(modem, LOGL_INFO, "Failed to unblock PIN by PUK. Qmi Ret %d/%s.", req->ret,
@@ -15,8 +15,11 @@
  * GNU General Public License for more details.
  */
 #include "gsmtap_util.h"
+#include "capture.h"
 #include "osmocom/fsm.h"
 #include "qmi-enums-wds.h"
+#include "qmi-message.h"
+#include "qmi-bands.h"
 
 #include <arpa/inet.h>
 #include <string.h>
@@ -101,6 +104,48 @@ static int disable_gsmtap_policy(struct ubus_context *ctx, struct ubus_object *o
 	return UBUS_STATUS_OK;
 }
 
+enum {
+	CAPTURE_PATH,
+	CAPTURE_SIZE,
+	CAPTURE_FILES,
+	__CAPTURE_MAX
+};
+
+static const struct blobmsg_policy enable_capture_policy[__CAPTURE_MAX] = {
+	[CAPTURE_PATH] = { .name = "path", .type = BLOBMSG_TYPE_STRING },
+	[CAPTURE_SIZE] = { .name = "size", .type = BLOBMSG_TYPE_INT32 },
+	[CAPTURE_FILES] = { .name = "files", .type = BLOBMSG_TYPE_INT32 },
+};
+
+/* size in kbytes, splits the capture into a ring of files */
+static int enable_capture(struct ubus_context *ctx, struct ubus_object *obj, struct ubus_request_data *req,
+			  const char *method, struct blob_attr *msg)
+{
+	struct blob_attr *tb[__CAPTURE_MAX];
+	unsigned int size = 0, files = 0;
+
+	blobmsg_parse(enable_capture_policy, __CAPTURE_MAX, tb, blob_data(msg), blob_len(msg));
+	if (!tb[CAPTURE_PATH])
+		return UBUS_STATUS_INVALID_ARGUMENT;
+
+	if (tb[CAPTURE_SIZE])
+		size = blobmsg_get_u32(tb[CAPTURE_SIZE]) * 1024;
+	if (tb[CAPTURE_FILES])
+		files = blobmsg_get_u32(tb[CAPTURE_FILES]);
+
+	if (qmi_capture_open(blobmsg_get_string(tb[CAPTURE_PATH]), size, files))
+		return UBUS_STATUS_UNKNOWN_ERROR;
+
+	return UBUS_STATUS_OK;
+}
+
+static int disable_capture(struct ubus_context *ctx, struct ubus_object *obj, struct ubus_request_data *req,
+			   const char *method, struct blob_attr *msg)
+{
+	qmi_capture_close();
+	return UBUS_STATUS_OK;
+}
+
 static int uqmid_add_object(struct ubus_object *obj)
 {
 	int ret = ubus_add_object(ubus_ctx, obj);
@@ -243,6 +288,8 @@ static struct ubus_method main_object_methods[] = {
 	{ .name = "reload", .handler = uqmid_handle_reload },
 	UBUS_METHOD("enable_gsmtap", enable_gsmtap, enable_gsmtap_policy),
 	{ .name = "disable_gsmtap", .handler = disable_gsmtap_policy },
+	UBUS_METHOD("enable_capture", enable_capture, enable_capture_policy),
+	{ .name = "disable_capture", .handler = disable_capture },
 	UBUS_METHOD("add_modem", add_modem, add_modem_policy),
 	UBUS_METHOD("remove_modem", remove_modem, remove_modem_policy),
 };
@@ -411,6 +458,32 @@ static void blob_add_addr(struct blob_buf *blob, const char *name, struct sockad
 	}
 }
 
+static void blob_add_rf_bands(struct blob_buf *blob, struct modem *modem)
+{
+	const struct qmi_band *band;
+	const char *rat;
+	void *a, *t;
+	unsigned int i;
+
+	a = blobmsg_open_array(blob, "rf_bands");
+	for (i = 0; i < modem->state.rf_band_n; i++) {
+		uint32_t channel = modem->state.rf_band[i].channel;
+
+		t = blobmsg_open_table(blob, NULL);
+		rat = qmi_enum_name(&qmi_nas_radio_interface_names, modem->state.rf_band[i].rat);
+		blobmsg_add_string(blob, "rat", rat ? rat : "unknown");
+		blobmsg_add_u32(blob, "channel", channel);
+		band = qmi_band_find(qmi_band_rat_from_radio_interface(modem->state.rf_band[i].rat), channel);
+		if (band) {
+			blobmsg_add_u32(blob, "band", band->band);
+			blobmsg_add_string(blob, "duplex", qmi_band_duplex_name(band));
+			blobmsg_add_u32(blob, "dl_frequency_khz", qmi_band_freq(band, channel));
+		}
+		blobmsg_close_table(blob, t);
+	}
+	blobmsg_close_array(blob, a);
+}
+
 #define BLOBMSG_ADD_STR_CHECK(buffer, field, value) blobmsg_add_string(buffer, field, value ? value : "")
 
 static int modem_dump_state(struct ubus_context *ctx, struct ubus_object *obj, struct ubus_request_data *req,
@@ -440,6 +513,7 @@ static int modem_dump_state(struct ubus_context *ctx, struct ubus_object *obj, s
 	blob_add_addr(&b, "ipv6", (struct sockaddr *)&modem->brearer.v6);
 	blob_add_addr(&b, "dns1", (struct sockaddr *)&modem->brearer.dns1);
 	blob_add_addr(&b, "dns2", (struct sockaddr *)&modem->brearer.dns2);
+	blob_add_rf_bands(&b, modem);
 	/* sim */
 	/* TODO: add human readable enum values */
 	blobmsg_add_u16(&b, "sim_state", modem->sim.state);
@@ -32,6 +32,7 @@
 
 #include "uqmid.h"
 #include "ubus.h"
+#include "capture.h"
 
 static const struct option uqmid_getopt[] = {
 	{ NULL, 0, NULL, 0 }
@@ -74,6 +75,7 @@ int main(int argc, char **argv)
 	}
 
 	uloop_run();
+	qmi_capture_close();
 
 	return ret;
 }
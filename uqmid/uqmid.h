@@ -25,6 +25,9 @@
 
 #include <libubox/ustream.h>
 
+#include "qmi-req-table.h"
+#include "timer-wheel.h"
+
 enum {
 	L_CRIT,
 	L_WARNING,
@@ -37,6 +40,7 @@ struct qmi_dev;
 struct qmi_service;
 struct qmi_request;
 struct qmi_msg;
+struct qmi_arena;
 struct modem;
 
 typedef void (*request_cb)(struct qmi_service *service, struct qmi_request *req, struct qmi_msg *msg);
@@ -50,13 +54,31 @@ struct qmi_request {
 	request_cb cb;
 	void *cb_data;
 
+	/*! deadline for the response in msecs, 0 for QMI_REQUEST_TIMEOUT */
+	unsigned int timeout;
+	struct qmi_timer timer;
+
+	/*! decode storage for cb, released together with the request */
+	struct qmi_arena *arena;
+
+	/*! no side effects: an identical query already sent may answer it */
+	bool query;
+	/*! also answer it from a response up to max_age msecs old */
+	unsigned int max_age;
+	/*! queries waiting for the response to this one */
+	struct list_head followers;
+
 	bool complete;
 	bool pending;
 	bool no_error_cb;
 	uint16_t tid;
+	uint32_t key; /*! entry in qmi_dev->req_table while sent */
 	int ret;
 };
 
+/* a modem dropping a response must not leave the request behind forever */
+#define QMI_REQUEST_TIMEOUT	(120 * 1000)
+
 /* FIXME: describe state machine */
 enum {
 	QMI_RUNNING,
@@ -66,9 +88,14 @@ enum {
 
 struct qmi_dev {
 	struct ustream_fd sf;
+	/* reassembly of messages spanning several read buffers */
+	char *rx_buf;
+	int rx_buf_len;
 
 	struct list_head services;
 	struct qmi_service *ctrl;
+	/* the sent requests of all services by service, client id and tid */
+	struct qmi_req_table req_table;
 	struct modem *modem;
 
 	bool is_mbim;
@@ -91,5 +118,10 @@ struct qmi_dev {
 struct qmi_dev *qmi_device_open(struct modem *modem, const char *path);
 void qmi_device_close(struct qmi_dev *qmi, int timeout_ms);
 void qmi_device_service_closed(struct qmi_dev *qmi);
+int qmi_request_track(struct qmi_service *service, struct qmi_request *req);
+void qmi_request_finish(struct qmi_service *service, struct qmi_request *req, struct qmi_msg *msg, int error);
+
+/* arena on buf, spilling over into talloc chunks below ctx */
+void uqmi_arena_init(struct qmi_arena *arena, void *buf, unsigned int len, void *ctx);
 
 #endif /* __UQMID_H */